@@ -0,0 +1,153 @@
+#include <benchmark/benchmark.h>
+#include <sstream>
+#include <streambuf>
+#include "hdfObject.hpp"
+#include "resourceCounters.hpp"
+#include "syntheticPetscFile.hpp"
+#include "xdmfBuilder.hpp"
+#include "xdmfSpecification.hpp"
+
+using namespace petscXdmfGenerator;
+using namespace petscXdmfGenerator::benchmarks;
+
+// what is written to each synthetic file, the sizes come from the benchmark arguments
+struct Layout {
+    bool mesh;
+    bool particles;
+    bool vizLayout;
+};
+
+// discards everything written while counting the bytes
+class CountingBuffer : public std::streambuf {
+   public:
+    std::size_t count = 0;
+
+   protected:
+    int overflow(int character) override {
+        count += character != traits_type::eof();
+        return traits_type::not_eof(character);
+    }
+    std::streamsize xsputn(const char*, std::streamsize size) override {
+        count += (std::size_t)size;
+        return size;
+    }
+};
+
+static SyntheticFileOptions OptionsFor(const benchmark::State& state, const Layout& layout) {
+    SyntheticFileOptions options;
+    options.timeSteps = (std::size_t)state.range(0);
+    options.fields = (std::size_t)state.range(1);
+    options.components = (std::size_t)state.range(2);
+    options.mesh = layout.mesh;
+    options.particles = layout.particles;
+    options.vizLayout = layout.vizLayout;
+    return options;
+}
+
+static std::shared_ptr<XdmfSpecification> SpecificationFor(const benchmark::State& state, const Layout& layout) {
+    return XdmfSpecification::FromPetscHdf(std::make_shared<HdfObject>(SyntheticPetscFile(OptionsFor(state, layout))));
+}
+
+// visits every object in the file, returning the number of objects
+static std::size_t Traverse(HdfObject& object) {
+    std::size_t count = 1;
+    if (object.Type() == H5O_TYPE_GROUP) {
+        for (const auto& child : object.Children()) {
+            count += Traverse(*child);
+        }
+    }
+    return count;
+}
+
+// the number of time steps, fields, and components in each file
+static void Sizes(benchmark::internal::Benchmark* benchmark) {
+    benchmark->ArgNames({"steps", "fields", "components"});
+    benchmark->Args({10, 4, 1});
+    benchmark->Args({1000, 4, 1});
+    benchmark->Args({10000, 2, 1});
+    benchmark->Args({100, 32, 1});
+    benchmark->Args({100, 4, 8});
+    benchmark->Unit(benchmark::kMillisecond);
+}
+
+static void HdfObjectTraversal(benchmark::State& state, Layout layout) {
+    auto filePath = SyntheticPetscFile(OptionsFor(state, layout));
+    ResourceCounters counters(state);
+    std::size_t objects = 0;
+    for (auto _ : state) {
+        // opening the file is part of the traversal
+        auto root = std::make_shared<HdfObject>(filePath);
+        objects = Traverse(*root);
+    }
+    state.counters["objects"] = (double)objects;
+}
+
+static void FromPetscHdf(benchmark::State& state, Layout layout) {
+    auto filePath = SyntheticPetscFile(OptionsFor(state, layout));
+    ResourceCounters counters(state);
+    for (auto _ : state) {
+        auto specification = XdmfSpecification::FromPetscHdf(std::make_shared<HdfObject>(filePath));
+        benchmark::DoNotOptimize(specification);
+    }
+}
+
+static void BuildDocument(benchmark::State& state, Layout layout) {
+    auto specification = SpecificationFor(state, layout);
+    ResourceCounters counters(state);
+    for (auto _ : state) {
+        auto document = XdmfBuilder(specification).Build();
+        benchmark::DoNotOptimize(document);
+    }
+}
+
+static void PrintDocument(benchmark::State& state, Layout layout) {
+    auto document = XdmfBuilder(SpecificationFor(state, layout)).Build();
+    ResourceCounters counters(state);
+    std::size_t bytes = 0;
+    for (auto _ : state) {
+        CountingBuffer buffer;
+        std::ostream stream(&buffer);
+        document->PrettyPrint(stream);
+        bytes += buffer.count;
+    }
+    state.SetBytesProcessed((int64_t)bytes);
+}
+
+static void StreamDocument(benchmark::State& state, Layout layout) {
+    auto specification = SpecificationFor(state, layout);
+    ResourceCounters counters(state);
+    std::size_t bytes = 0;
+    for (auto _ : state) {
+        CountingBuffer buffer;
+        std::ostream stream(&buffer);
+        XdmfBuilder(specification).Build(stream);
+        bytes += buffer.count;
+    }
+    state.SetBytesProcessed((int64_t)bytes);
+}
+
+static void SpecificationBinary(benchmark::State& state, Layout layout) {
+    auto specification = SpecificationFor(state, layout);
+    ResourceCounters counters(state);
+    for (auto _ : state) {
+        std::stringstream stream;
+        specification->WriteBinary(stream);
+        auto copy = XdmfSpecification::ReadBinary(stream);
+        benchmark::DoNotOptimize(copy);
+    }
+}
+
+#define PETSCXDMFGENERATOR_BENCHMARK_LAYOUTS(function)                                                                      \
+    BENCHMARK_CAPTURE(function, meshViz, Layout{.mesh = true, .particles = false, .vizLayout = true})->Apply(Sizes);        \
+    BENCHMARK_CAPTURE(function, meshRoot, Layout{.mesh = true, .particles = false, .vizLayout = false})->Apply(Sizes);      \
+    BENCHMARK_CAPTURE(function, particles, Layout{.mesh = false, .particles = true, .vizLayout = true})->Apply(Sizes);      \
+    BENCHMARK_CAPTURE(function, meshAndParticles, Layout{.mesh = true, .particles = true, .vizLayout = true})->Apply(Sizes)
+
+PETSCXDMFGENERATOR_BENCHMARK_LAYOUTS(HdfObjectTraversal);
+PETSCXDMFGENERATOR_BENCHMARK_LAYOUTS(FromPetscHdf);
+PETSCXDMFGENERATOR_BENCHMARK_LAYOUTS(BuildDocument);
+PETSCXDMFGENERATOR_BENCHMARK_LAYOUTS(PrintDocument);
+PETSCXDMFGENERATOR_BENCHMARK_LAYOUTS(StreamDocument);
+PETSCXDMFGENERATOR_BENCHMARK_LAYOUTS(SpecificationBinary);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,52 @@
+#include "resourceCounters.hpp"
+#include <sys/resource.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// every allocation in the process is counted, relaxed ordering is enough because the totals are only read between iterations
+static std::atomic<uint64_t> allocations{0};
+static std::atomic<uint64_t> allocatedBytes{0};
+
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    if (auto pointer = std::malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+
+void operator delete[](void* pointer) noexcept { std::free(pointer); }
+
+void operator delete(void* pointer, std::size_t) noexcept { std::free(pointer); }
+
+void operator delete[](void* pointer, std::size_t) noexcept { std::free(pointer); }
+
+petscXdmfGenerator::benchmarks::ResourceCounters::ResourceCounters(benchmark::State& state) : state(state), allocationsAtStart(Allocations()), allocatedBytesAtStart(AllocatedBytes()) {}
+
+petscXdmfGenerator::benchmarks::ResourceCounters::~ResourceCounters() {
+    state.counters["allocations"] = benchmark::Counter((double)(Allocations() - allocationsAtStart), benchmark::Counter::kAvgIterations);
+    state.counters["allocatedBytes"] = benchmark::Counter((double)(AllocatedBytes() - allocatedBytesAtStart), benchmark::Counter::kAvgIterations, benchmark::Counter::OneK::kIs1024);
+    state.counters["peakRSS"] = benchmark::Counter((double)PeakResidentSetSize(), benchmark::Counter::kDefaults, benchmark::Counter::OneK::kIs1024);
+}
+
+uint64_t petscXdmfGenerator::benchmarks::ResourceCounters::Allocations() { return allocations.load(std::memory_order_relaxed); }
+
+uint64_t petscXdmfGenerator::benchmarks::ResourceCounters::AllocatedBytes() { return allocatedBytes.load(std::memory_order_relaxed); }
+
+uint64_t petscXdmfGenerator::benchmarks::ResourceCounters::PeakResidentSetSize() {
+    struct rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    // reported in bytes on macOS
+    return (uint64_t)usage.ru_maxrss;
+#else
+    // reported in kilobytes on linux
+    return (uint64_t)usage.ru_maxrss * 1024;
+#endif
+}
@@ -0,0 +1,44 @@
+#ifndef PETSCXDMFGENERATOR_RESOURCECOUNTERS_HPP
+#define PETSCXDMFGENERATOR_RESOURCECOUNTERS_HPP
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+
+namespace petscXdmfGenerator::benchmarks {
+/**
+ * Counts the allocations made through operator new while alive and reports them, along with the peak resident set
+ * size of the process, as counters on the benchmark.  Allocations made by the hdf5 library (malloc) are not counted.
+ */
+class ResourceCounters {
+   private:
+    benchmark::State& state;
+    const uint64_t allocationsAtStart;
+    const uint64_t allocatedBytesAtStart;
+
+   public:
+    explicit ResourceCounters(benchmark::State& state);
+    ~ResourceCounters();
+
+    ResourceCounters(const ResourceCounters&) = delete;
+    void operator=(const ResourceCounters&) = delete;
+
+    /**
+     * the number of allocations made through operator new since the process started
+     * @return
+     */
+    static uint64_t Allocations();
+
+    /**
+     * the number of bytes requested through operator new since the process started
+     * @return
+     */
+    static uint64_t AllocatedBytes();
+
+    /**
+     * the peak resident set size of the process in bytes
+     * @return
+     */
+    static uint64_t PeakResidentSetSize();
+};
+}  // namespace petscXdmfGenerator::benchmarks
+#endif  // PETSCXDMFGENERATOR_RESOURCECOUNTERS_HPP
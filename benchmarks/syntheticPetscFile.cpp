@@ -0,0 +1,145 @@
+#include "syntheticPetscFile.hpp"
+#include <hdf5.h>
+#include <stdexcept>
+#include <vector>
+
+// closes the hdf5 identifier when it goes out of scope
+class Identifier {
+   private:
+    hid_t id;
+    herr_t (*close)(hid_t);
+
+   public:
+    Identifier(hid_t id, herr_t (*close)(hid_t)) : id(id), close(close) {
+        if (id < 0) {
+            throw std::runtime_error("unable to write the synthetic hdf5 file");
+        }
+    }
+    ~Identifier() { close(id); }
+    Identifier(const Identifier&) = delete;
+    void operator=(const Identifier&) = delete;
+
+    operator hid_t() const { return id; }
+};
+
+static void CreateGroups(hid_t file, const std::string& path) {
+    for (auto separator = path.find('/', 1); separator != std::string::npos; separator = path.find('/', separator + 1)) {
+        auto group = path.substr(0, separator);
+        if (H5Lexists(file, group.c_str(), H5P_DEFAULT) <= 0) {
+            Identifier created(H5Gcreate2(file, group.c_str(), H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT), H5Gclose);
+        }
+    }
+}
+
+static void WriteAttribute(hid_t dataset, const std::string& name, int value) {
+    Identifier space(H5Screate(H5S_SCALAR), H5Sclose);
+    Identifier attribute(H5Acreate2(dataset, name.c_str(), H5T_NATIVE_INT, space, H5P_DEFAULT, H5P_DEFAULT), H5Aclose);
+    H5Awrite(attribute, H5T_NATIVE_INT, &value);
+}
+
+static void WriteAttribute(hid_t dataset, const std::string& name, const std::string& value) {
+    // petsc writes fixed length null terminated strings
+    Identifier type(H5Tcopy(H5T_C_S1), H5Tclose);
+    H5Tset_size(type, value.size() + 1);
+    Identifier space(H5Screate(H5S_SCALAR), H5Sclose);
+    Identifier attribute(H5Acreate2(dataset, name.c_str(), type, space, H5P_DEFAULT, H5P_DEFAULT), H5Aclose);
+    H5Awrite(attribute, type, value.c_str());
+}
+
+// creates the dataset without writing any values, the returned dataset must be closed by the caller
+static hid_t CreateDataset(hid_t file, const std::string& path, hid_t type, std::vector<hsize_t> shape) {
+    CreateGroups(file, path);
+    Identifier space(H5Screate_simple((int)shape.size(), shape.data(), nullptr), H5Sclose);
+    auto dataset = H5Dcreate2(file, path.c_str(), type, space, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+    if (dataset < 0) {
+        throw std::runtime_error("unable to create the synthetic dataset " + path);
+    }
+    return dataset;
+}
+
+// the shape of a field with a time dimension, a single component is left off like petsc does for scalars
+static std::vector<hsize_t> FieldShape(std::size_t timeSteps, std::size_t points, std::size_t components) {
+    std::vector<hsize_t> shape = {timeSteps, points};
+    if (components > 1) {
+        shape.push_back(components);
+    }
+    return shape;
+}
+
+std::string petscXdmfGenerator::benchmarks::SyntheticFileOptions::Name() const {
+    return "synthetic_t" + std::to_string(timeSteps) + "_f" + std::to_string(fields) + "_c" + std::to_string(components) + (mesh ? "_mesh" : "") + (particles ? "_particles" : "") +
+           (vizLayout ? "_viz" : "_root") + "_l" + std::to_string(labels) + "_v" + std::to_string(vertices) + "_e" + std::to_string(cells) + "_p" + std::to_string(particlesPerStep);
+}
+
+void petscXdmfGenerator::benchmarks::WriteSyntheticPetscFile(const std::filesystem::path& filePath, const SyntheticFileOptions& options) {
+    const std::size_t dimension = 2;
+    const std::size_t cellCorners = 3;
+    Identifier file(H5Fcreate(filePath.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT), H5Fclose);
+
+    // the time is the only dataset that is read
+    {
+        std::vector<double> time(options.timeSteps);
+        for (std::size_t t = 0; t < time.size(); t++) {
+            time[t] = 0.01 * (double)t;
+        }
+        Identifier dataset(CreateDataset(file, "/time", H5T_NATIVE_DOUBLE, {options.timeSteps, 1}), H5Dclose);
+        H5Dwrite(dataset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, time.data());
+    }
+
+    if (options.mesh) {
+        Identifier vertices(CreateDataset(file, "/geometry/vertices", H5T_NATIVE_DOUBLE, {options.vertices, dimension}), H5Dclose);
+
+        // the viz layout keeps the native petsc topology in the root and the cells used for visualization under /viz
+        const std::string topologyPath = options.vizLayout ? "/viz/topology/cells" : "/topology/cells";
+        Identifier cells(CreateDataset(file, topologyPath, H5T_NATIVE_INT, {options.cells, cellCorners}), H5Dclose);
+        WriteAttribute(cells, "cell_corners", (int)cellCorners);
+        WriteAttribute(cells, "cell_dim", (int)dimension);
+        if (options.vizLayout) {
+            Identifier nativeCells(CreateDataset(file, "/topology/cells", H5T_NATIVE_INT, {options.cells * 4, 1}), H5Dclose);
+            WriteAttribute(nativeCells, "cell_dim", (int)dimension);
+            for (const auto& name : {"cones", "order", "orientation"}) {
+                Identifier dataset(CreateDataset(file, std::string("/topology/") + name, H5T_NATIVE_INT, {options.cells * 2, 1}), H5Dclose);
+            }
+        }
+
+        // alternate the fields between the vertices and cells, a scalar with several components is written as component views
+        for (std::size_t f = 0; f < options.fields; f++) {
+            const bool vertexField = f % 2 == 0;
+            const auto path = std::string(vertexField ? "/vertex_fields/" : "/cell_fields/") + "solution_field" + std::to_string(f);
+            Identifier field(CreateDataset(file, path, H5T_NATIVE_DOUBLE, FieldShape(options.timeSteps, vertexField ? options.vertices : options.cells, options.components)), H5Dclose);
+            WriteAttribute(field, "vector_field_type", std::string("scalar"));
+        }
+    }
+
+    // the particle fields are scalars so that any number of components is written as component views
+    if (options.particles) {
+        Identifier coordinates(CreateDataset(file, "/particle_fields/DMSwarmPIC_coor", H5T_NATIVE_DOUBLE, {options.timeSteps, options.particlesPerStep, dimension}), H5Dclose);
+        WriteAttribute(coordinates, "Nc", (int)dimension);
+        for (std::size_t f = 0; f < options.fields; f++) {
+            const auto path = "/particle_fields/particle_field" + std::to_string(f);
+            Identifier field(CreateDataset(file, path, H5T_NATIVE_DOUBLE, FieldShape(options.timeSteps, options.particlesPerStep, options.components)), H5Dclose);
+            WriteAttribute(field, "Nc", 1);
+        }
+    }
+
+    // labels are only traversed
+    for (std::size_t l = 0; l < options.labels; l++) {
+        for (std::size_t value = 1; value <= 4; value++) {
+            Identifier indices(CreateDataset(file, "/labels/label" + std::to_string(l) + "/" + std::to_string(value) + "/indices", H5T_NATIVE_INT, {options.vertices / 16 + 1, 1}), H5Dclose);
+        }
+    }
+}
+
+std::filesystem::path petscXdmfGenerator::benchmarks::SyntheticPetscFile(const SyntheticFileOptions& options) {
+    auto filePath = std::filesystem::temp_directory_path() / "petscXdmfGeneratorBenchmarks" / (options.Name() + ".hdf5");
+    if (!std::filesystem::exists(filePath)) {
+        std::filesystem::create_directories(filePath.parent_path());
+
+        // write to a temporary file so an interrupted benchmark never leaves a partial file behind
+        auto temporaryFilePath = filePath;
+        temporaryFilePath += ".tmp";
+        WriteSyntheticPetscFile(temporaryFilePath, options);
+        std::filesystem::rename(temporaryFilePath, filePath);
+    }
+    return filePath;
+}
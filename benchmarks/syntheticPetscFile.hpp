@@ -0,0 +1,59 @@
+#ifndef PETSCXDMFGENERATOR_SYNTHETICPETSCFILE_HPP
+#define PETSCXDMFGENERATOR_SYNTHETICPETSCFILE_HPP
+
+#include <filesystem>
+#include <string>
+
+namespace petscXdmfGenerator::benchmarks {
+/**
+ * Describes a synthetic hdf5 file using the same layout as the files written by PETSc
+ */
+struct SyntheticFileOptions {
+    // the number of values in /time, every field and the geometry (when not static) have a time dimension
+    std::size_t timeSteps = 10;
+
+    // the number of fields split between the vertex and cell fields, and the number of extra particle fields
+    std::size_t fields = 4;
+
+    // the number of components in each field, a single component is written as a plain scalar
+    std::size_t components = 1;
+
+    // write a mesh (geometry, topology, and fields) and/or a particle swarm
+    bool mesh = true;
+    bool particles = false;
+
+    // put the geometry and topology under /viz (as written by the PETSc xdmf viewer) instead of the root
+    bool vizLayout = true;
+
+    // the number of label groups, these are never used by the generator but are traversed
+    std::size_t labels = 8;
+
+    // the size of the mesh and swarm
+    std::size_t vertices = 1000;
+    std::size_t cells = 1800;
+    std::size_t particlesPerStep = 1000;
+
+    /**
+     * a short unique name for the options, used as the file name
+     * @return
+     */
+    std::string Name() const;
+};
+
+/**
+ * Writes the synthetic file.  Only /time holds real values, every other dataset is created without writing any data
+ * (the generator only reads the metadata) so even very large files are written quickly and take little space.
+ * @param filePath
+ * @param options
+ */
+void WriteSyntheticPetscFile(const std::filesystem::path& filePath, const SyntheticFileOptions& options);
+
+/**
+ * Gets the path to a synthetic file in the temporary directory, writing it if it does not already exist
+ * @param options
+ * @return
+ */
+std::filesystem::path SyntheticPetscFile(const SyntheticFileOptions& options);
+
+}  // namespace petscXdmfGenerator::benchmarks
+#endif  // PETSCXDMFGENERATOR_SYNTHETICPETSCFILE_HPP
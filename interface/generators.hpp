@@ -1,10 +1,373 @@
 #ifndef PETSCXDMFGENERATOR_GENERATORS_HPP
 #define PETSCXDMFGENERATOR_GENERATORS_HPP
+#include <chrono>
+#include <cstdint>
 #include <filesystem>
+#include <functional>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "xdmfSpecification.hpp"
 
 namespace petscXdmfGenerator {
-void Generate(std::filesystem::path, std::filesystem::path = {});
-void Generate(std::filesystem::path inputFilePath, std::ostream& stream);
-}
+/**
+ * Options used when generating xdmf files
+ */
+struct GenerateOptions {
+    // store the specification extracted from each file so that unchanged files are never opened with hdf5 again
+    bool useSpecificationCache = false;
+
+    // where to store the specification cache, if empty each entry is stored next to its hdf5 file
+    std::filesystem::path specificationCacheDirectory;
+
+    // the number of threads used to build the time steps of each file, the output is identical for any number of threads
+    std::size_t buildThreads = 1;
+
+    // write the xml without any indentation or new lines
+    bool compactOutput = false;
+
+    // time lists with at least this many values reference the /time dataset instead of being written into the xml, zero always writes them
+    std::size_t timeReferenceThreshold = 0;
+
+    // open the hdf5 files for single writer multiple reader access so that files still being written in swmr mode can be converted
+    bool swmrRead = false;
+
+    // only the fields whose names match one of these glob patterns (* and ?) are written, every field when empty
+    std::vector<std::string> includeFields;
+
+    // the fields whose names match one of these glob patterns are left out
+    std::vector<std::string> excludeFields;
+
+    // only every timeStride-th time from the first to the last time in [timeBegin, timeEnd] is written
+    double timeBegin = -std::numeric_limits<double>::infinity();
+    double timeEnd = std::numeric_limits<double>::infinity();
+    std::size_t timeStride = 1;
+
+    // a preview grid (<grid>_lod<N>) reading every Nth particle is added after each time dependent particle grid for each stride
+    std::vector<unsigned long long> particleLevelsOfDetail;
+
+    // read every field once to write the range and mean of each field in each step as Information elements, so viewers can set up color maps without reading the heavy data
+    bool fieldSummaries = false;
+
+    // in a series, time invariant meshes that match an earlier file (by shape and a hash of sampled values) reference that file's mesh
+    bool shareStaticMeshes = true;
+};
+
+/**
+ * The work done by a single conversion, used to find where the time goes on slow file systems
+ */
+struct GenerateStatistics {
+    // the number of specifications read from the cache instead of the hdf5 file
+    std::size_t cachedSpecifications = 0;
+
+    // the hdf5 calls made while reading the file(s)
+    uint64_t hdfOpens = 0;
+    uint64_t hdfMetadataQueries = 0;
+    uint64_t hdfLinkChecks = 0;
+    uint64_t hdfIterations = 0;
+    uint64_t hdfAttributeChecks = 0;
+    uint64_t hdfAttributeReads = 0;
+    uint64_t hdfDatasetReads = 0;
+    uint64_t hdfBytesRead = 0;
+
+    // the time spent in each phase, in seconds
+    double openSeconds = 0;           // opening the hdf5 file(s)
+    double specificationSeconds = 0;  // extracting the specification from the open file(s) or the cache
+    double buildSeconds = 0;          // building the xml, not including the time spent writing it
+    double writeSeconds = 0;          // writing the xml, zero when writing to a stream provided by the caller
+    double totalSeconds = 0;
+
+    // the size of the xml written, zero when writing to a stream provided by the caller
+    uint64_t bytesWritten = 0;
+};
+
+/**
+ * Writes the statistics as a single line json object
+ * @param stream
+ * @param statistics
+ * @return
+ */
+std::ostream& operator<<(std::ostream& stream, const GenerateStatistics& statistics);
+
+GenerateStatistics Generate(std::filesystem::path, std::filesystem::path = {}, const GenerateOptions& options = {});
+GenerateStatistics Generate(std::filesystem::path inputFilePath, std::ostream& stream, const GenerateOptions& options = {});
+
+/**
+ * Writes the xdmf directly to an open file descriptor (such as standard output or a socket) through a large buffer.
+ * The file descriptor is not closed.
+ * @param inputFilePath
+ * @param fileDescriptor
+ * @param options
+ */
+GenerateStatistics Generate(std::filesystem::path inputFilePath, int fileDescriptor, const GenerateOptions& options = {});
+
+/**
+ * Gets the specification for a file so that several outputs can be produced from a single scan.  A saved
+ * specification (json or binary, see XdmfSpecification::Save) is read directly, otherwise the specification cache is
+ * checked (when enabled) before the hdf5 file is opened.  Every generator that takes a file path accepts a saved
+ * specification in place of the hdf5 file.
+ * @param inputFilePath
+ * @param options
+ * @param statistics if provided, filled with the work done
+ * @return
+ */
+std::shared_ptr<XdmfSpecification> ReadSpecification(const std::filesystem::path& inputFilePath, const GenerateOptions& options = {}, GenerateStatistics* statistics = nullptr);
+
+/**
+ * Generates the xdmf from a specification without any hdf5 access
+ * @param specification
+ * @param outputFilePath
+ * @param options
+ */
+GenerateStatistics Generate(std::shared_ptr<XdmfSpecification> specification, std::filesystem::path outputFilePath, const GenerateOptions& options = {});
+GenerateStatistics Generate(std::shared_ptr<XdmfSpecification> specification, std::ostream& stream, const GenerateOptions& options = {});
+
+/**
+ * Writes a VTKHDF file (for ParaView/VTK) instead of the xdmf.  The points, connectivity, and fields are virtual
+ * datasets that read from the original PETSc datasets, so no heavy data is copied, but the output must stay next to
+ * the hdf5 file.  The first grid is written to the output file and every other grid (such as the particles) is written
+ * next to it as <stem>.<grid name>.vtkhdf.
+ * @param inputFilePath the hdf5 file or a saved specification
+ * @param outputFilePath the output file, defaults to the input with a vtkhdf extension
+ * @param options
+ */
+GenerateStatistics GenerateVtkHdf(std::filesystem::path inputFilePath, std::filesystem::path outputFilePath = {}, const GenerateOptions& options = {});
+GenerateStatistics GenerateVtkHdf(std::shared_ptr<XdmfSpecification> specification, std::filesystem::path outputFilePath, const GenerateOptions& options = {});
+
+/**
+ * An hdf5 id (hid_t), declared here so that the interface does not depend on the hdf5 headers
+ */
+using HdfId = int64_t;
+
+/**
+ * Receives the xdmf in blocks as it is written
+ */
+using XmlSink = std::function<void(const char* data, std::size_t size)>;
+
+/**
+ * Generates the xdmf for a file or group that is already open, such as the viewer used by PETSc, without opening the
+ * file again.  The id is not closed and must refer to data that has been flushed (H5Fflush) if the file is still being
+ * written.  The specification cache is not used and the hdf5 library lock is not taken by these functions.
+ * @param fileOrGroupId
+ * @param sink called with each block of the xdmf
+ * @param options
+ */
+GenerateStatistics Generate(HdfId fileOrGroupId, const XmlSink& sink, const GenerateOptions& options = {});
+
+/**
+ * Generates the xdmf for an open file or group into the caller's buffer, replacing its contents
+ * @param fileOrGroupId
+ * @param buffer
+ * @param options
+ */
+GenerateStatistics Generate(HdfId fileOrGroupId, std::string& buffer, const GenerateOptions& options = {});
+GenerateStatistics Generate(HdfId fileOrGroupId, std::ostream& stream, const GenerateOptions& options = {});
+
+/**
+ * The work done by an incremental generation
+ */
+enum IncrementalUpdate { UNCHANGED, APPENDED, REBUILT };
+
+/**
+ * Regenerates the xdmf for a file that is still being written.  The state of the previous generation is stored next to
+ * the output file; if the input file is unchanged nothing is done and if only the time dimension grew just the new
+ * steps are built and appended to the existing steps.  Otherwise the whole file is rebuilt.
+ * @param inputFilePath
+ * @param outputFilePath defaults to the input file name with an xmf extension
+ * @param statistics if provided, filled with the work done
+ * @return
+ */
+IncrementalUpdate GenerateIncremental(std::filesystem::path inputFilePath, std::filesystem::path outputFilePath = {}, const GenerateOptions& options = {},
+                                      GenerateStatistics* statistics = nullptr);
+
+/**
+ * Combines a series of files (one per output step) into a single temporal collection where each time step points at
+ * its own file.  The xdmf file is expected to be written next to the hdf5 files.
+ * @param inputFilePaths the files in time order
+ * @param outputFilePath
+ */
+GenerateStatistics GenerateSeries(const std::vector<std::filesystem::path>& inputFilePaths, std::filesystem::path outputFilePath, const GenerateOptions& options = {});
+GenerateStatistics GenerateSeries(const std::vector<std::filesystem::path>& inputFilePaths, std::ostream& stream, const GenerateOptions& options = {});
+
+/**
+ * Combines the specifications for a series of files (one per output step) into a single temporal collection
+ * @param series the specifications in time order
+ * @param outputFilePath
+ * @param options
+ */
+GenerateStatistics GenerateSeries(const std::vector<std::shared_ptr<XdmfSpecification>>& series, std::filesystem::path outputFilePath, const GenerateOptions& options = {});
+
+/**
+ * Combines the partition files of a domain (such as one file per rank group, each holding the same time steps) into
+ * a single temporal collection.  Each step is a spatial collection with a uniform grid for every partition, so viewers
+ * can load the partitions in parallel.  The xdmf file is expected to be written next to the hdf5 files.
+ * @param partitionFilePaths the file for each partition
+ * @param outputFilePath
+ * @param options
+ */
+GenerateStatistics GeneratePartitions(const std::vector<std::filesystem::path>& partitionFilePaths, std::filesystem::path outputFilePath, const GenerateOptions& options = {});
+GenerateStatistics GeneratePartitions(const std::vector<std::filesystem::path>& partitionFilePaths, std::ostream& stream, const GenerateOptions& options = {});
+
+/**
+ * The outcome of converting a single file in a batch
+ */
+struct BatchResult {
+    std::filesystem::path inputFilePath;
+    std::filesystem::path outputFilePath;
+    bool success = false;
+    std::string error;
+    GenerateStatistics statistics;
+};
+
+/**
+ * Expands a list of files, directories (all hdf5 files inside), and glob patterns (* and ? in the file name) into a
+ * list of hdf5 files sorted so that numbered output steps are in order (flowField.2 before flowField.10)
+ * @param inputs
+ * @return
+ */
+std::vector<std::filesystem::path> ExpandInputPaths(const std::vector<std::string>& inputs);
+
+/**
+ * The bounded queues between the stages of a batch
+ */
+struct PipelineOptions {
+    // the number of extracted specifications waiting to be built, limits how far the hdf5 reads run ahead
+    std::size_t specificationQueueDepth = 4;
+
+    // the number of built documents waiting to be written, limits the memory held by documents in flight
+    std::size_t writeQueueDepth = 4;
+};
+
+/**
+ * The work done by a single stage of a batch
+ */
+struct StageStatistics {
+    // the number of files that completed the stage
+    std::size_t files = 0;
+
+    // the time spent working, and waiting on the queue before (for a new file) or after (for room) the stage, summed over its threads
+    double busySeconds = 0;
+    double waitSeconds = 0;
+
+    // the files completed for each second spent working
+    double FilesPerSecond() const { return busySeconds > 0 ? (double)files / busySeconds : 0; }
+};
+
+/**
+ * The work done by each stage of a batch, used to find the stage that limits the batch
+ */
+struct PipelineStatistics {
+    StageStatistics extract;  // opening and scanning the hdf5 files (a single thread)
+    StageStatistics build;    // building and serializing the xml (the workers)
+    StageStatistics write;    // writing the xml files (a single thread)
+    double totalSeconds = 0;
+};
+
+std::ostream& operator<<(std::ostream& stream, const PipelineStatistics& statistics);
+
+/**
+ * Converts each file with a three stage pipeline.  A single thread extracts the specifications (hdf5 may only be used
+ * by one thread at a time), a fixed number of workers build and serialize the xdmf, and a single thread writes each
+ * file, so the file system latency of the next file overlaps with building the current one.  A failed file is
+ * reported in its result and does not stop the batch.
+ * @param inputFilePaths
+ * @param numberOfWorkers the number of build workers, or zero to use the hardware concurrency
+ * @param outputDirectory the directory for the xdmf files, or empty to write next to each input file
+ * @param options
+ * @param pipelineOptions the depth of the queues between the stages
+ * @param pipelineStatistics if provided, the work done by each stage
+ * @return the result for each input in the same order
+ */
+std::vector<BatchResult> GenerateBatch(const std::vector<std::filesystem::path>& inputFilePaths, std::size_t numberOfWorkers, std::filesystem::path outputDirectory, const GenerateOptions& options,
+                                       const PipelineOptions& pipelineOptions, PipelineStatistics* pipelineStatistics = nullptr);
+
+/**
+ * Converts each file with the default pipeline queues
+ * @param inputFilePaths
+ * @param numberOfWorkers the number of build workers, or zero to use the hardware concurrency
+ * @param outputDirectory the directory for the xdmf files, or empty to write next to each input file
+ * @return the result for each input in the same order
+ */
+std::vector<BatchResult> GenerateBatch(const std::vector<std::filesystem::path>& inputFilePaths, std::size_t numberOfWorkers = 0, std::filesystem::path outputDirectory = {},
+                                       const GenerateOptions& options = {});
+
+/**
+ * Options used when watching a directory
+ */
+struct WatchOptions {
+    // how long a file must be quiet after it is closed (or stops changing when polling) before it is converted
+    std::chrono::milliseconds debounce{500};
+
+    // how often the directory is scanned when polling, and how often the stop request is checked
+    std::chrono::milliseconds pollInterval{1000};
+
+    // poll the directory even if inotify is available, needed on file systems where inotify does not see remote writes
+    bool forcePolling = false;
+
+    // the directory for the xdmf files, or empty to write next to each input file
+    std::filesystem::path outputDirectory;
+};
+
+/**
+ * Watches a directory and incrementally regenerates the xdmf for each hdf5 file as soon as it is written and closed,
+ * so that only new time steps are appended.  The files already in the directory are converted when the watch starts.
+ * A failed conversion is reported and retried the next time the file changes.
+ * @param directory
+ * @param watchOptions
+ * @param options
+ * @param converted called after each conversion with its result and the work done
+ * @param stop checked between conversions, the watch ends when it returns true (or runs forever if empty)
+ */
+void Watch(const std::filesystem::path& directory, const WatchOptions& watchOptions, const GenerateOptions& options,
+           const std::function<void(const BatchResult& result, IncrementalUpdate update)>& converted, const std::function<bool()>& stop = {});
+
+/**
+ * How a time dependent dataset is stored compared to the single step slabs the xdmf reads for each time
+ */
+struct LayoutReport {
+    std::string path;
+    // contiguous, chunked, compact, or virtual
+    std::string layout;
+    std::vector<unsigned long long> shape;
+    std::vector<unsigned long long> chunk;
+    bool filtered = false;
+
+    // the bytes in a single step, and the chunks touched (and their bytes, all of which are read and decompressed when filtered) to load it
+    uint64_t stepBytes = 0;
+    uint64_t chunksPerStep = 0;
+    uint64_t chunkBytesPerStep = 0;
+
+    // each step is stored contiguously or in exactly one chunk of its own
+    bool aligned = true;
+};
+
+/**
+ * Describes the report as a single line warning
+ * @param stream
+ * @param report
+ * @return
+ */
+std::ostream& operator<<(std::ostream& stream, const LayoutReport& report);
+
+/**
+ * Inspects the storage of each time dependent dataset (geometry and fields) used by the xdmf
+ * @param inputFilePath the hdf5 file or a saved specification next to it
+ * @param options the field and time selection limits the datasets inspected
+ * @return a report for each dataset
+ */
+std::vector<LayoutReport> AnalyzeLayout(const std::filesystem::path& inputFilePath, const GenerateOptions& options = {});
+
+/**
+ * Copies the hdf5 file, rewriting each time dependent dataset that is not aligned (see AnalyzeLayout) with one chunk
+ * per step so that each step loads with a single chunk read.  The filters, attributes, and maximum extent of each
+ * rewritten dataset are kept and every other object is copied unchanged.
+ * @param inputFilePath
+ * @param outputFilePath the new file, which must not be the input
+ * @param options
+ * @return the report (from before the repack) for each rewritten dataset
+ */
+std::vector<LayoutReport> Repack(const std::filesystem::path& inputFilePath, const std::filesystem::path& outputFilePath, const GenerateOptions& options = {});
+}  // namespace petscXdmfGenerator
 
 #endif  // PETSCXDMFGENERATOR_CONVERTERS_HPP
@@ -0,0 +1,36 @@
+#ifndef PETSCXDMFGENERATOR_MPIGENERATORS_HPP
+#define PETSCXDMFGENERATOR_MPIGENERATORS_HPP
+#include <mpi.h>
+#include <filesystem>
+#include <vector>
+#include "generators.hpp"
+
+namespace petscXdmfGenerator {
+/**
+ * Converts each file using every rank of the communicator.  Each rank claims the next unconverted file from a shared
+ * counter on the root rank, so ranks that get small files simply convert more of them.  A failed file is reported in
+ * its result and does not stop the batch.  This is collective over the communicator.
+ * @param communicator
+ * @param inputFilePaths the same files on every rank
+ * @param outputDirectory the directory for the xdmf files, or empty to write next to each input file
+ * @param options
+ * @return on the root rank (0) the result for each input in the same order, on the other ranks only the results for the
+ * files converted by that rank
+ */
+std::vector<BatchResult> GenerateBatch(MPI_Comm communicator, const std::vector<std::filesystem::path>& inputFilePaths, std::filesystem::path outputDirectory = {},
+                                       const GenerateOptions& options = {});
+
+/**
+ * Combines a series of files into a single temporal collection.  The specification of each file is extracted by
+ * whichever rank claims it and the root rank (0) gathers them and writes the xdmf.  This is collective over the
+ * communicator and a file that cannot be read is reported on every rank.
+ * @param communicator
+ * @param inputFilePaths the files in time order, the same on every rank
+ * @param outputFilePath
+ * @param options
+ * @return the work done, summed over every rank on the root rank
+ */
+GenerateStatistics GenerateSeries(MPI_Comm communicator, const std::vector<std::filesystem::path>& inputFilePaths, std::filesystem::path outputFilePath, const GenerateOptions& options = {});
+}  // namespace petscXdmfGenerator
+
+#endif  // PETSCXDMFGENERATOR_MPIGENERATORS_HPP
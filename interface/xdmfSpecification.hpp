@@ -0,0 +1,277 @@
+#ifndef PETSCXDMFGENERATOR_XDMFSPECIFICATION_H
+#define PETSCXDMFGENERATOR_XDMFSPECIFICATION_H
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace petscXdmfGenerator {
+class HdfObject;
+class JsonValue;
+
+enum FieldLocation { NODE, CELL };
+enum FieldType { SCALAR, VECTOR, TENSOR, MATRIX, NONE };
+enum NumberType { FLOAT, INT, UINT, CHAR, UCHAR };
+
+/**
+ * Describes everything needed to write the xdmf for a file: the heavy file name and, for each grid, the path, shape,
+ * and type of each dataset.  It is normally extracted once from a PETSc hdf5 file, but it can be saved (as compact
+ * binary or json) and read back, or built directly from other metadata, so every output can be produced without
+ * opening the hdf5 file again.
+ */
+class XdmfSpecification {
+   public:
+    // the native type of the values in a heavy dataset
+    struct DataTypeDescription {
+        NumberType numberType = FLOAT;
+        unsigned long long precision = 8;
+    };
+
+    struct TopologyDescription {
+        std::string path;
+        unsigned long long number = 0;
+        unsigned long long numberCorners = 0;
+        unsigned long long dimension = 0;
+        DataTypeDescription dataType = {.numberType = INT, .precision = 4};
+
+        // the fingerprint of the cells in a time invariant mesh, zero unless the meshes were fingerprinted
+        uint64_t contentHash = 0;
+    };
+
+    // the range and mean of the finite values in one component of one step, NaN when there are none
+    struct ValueSummary {
+        double minimum;
+        double maximum;
+        double mean;
+    };
+
+    // a scalar view of a single component in a field
+    struct ComponentDescription {
+        std::string name;
+        unsigned long long offset = 0;
+    };
+
+    struct FieldDescription {
+        std::string name;
+        std::string path;
+        std::vector<unsigned long long> shape;
+        unsigned long long componentDimension = 0;
+        FieldLocation fieldLocation = NODE;
+        FieldType fieldType = NONE;
+        DataTypeDescription dataType;
+
+        // a field that holds several scalar components is written as a view of each component
+        std::vector<ComponentDescription> components;
+
+        // the summary of each component at each time in the grid's time list (timeIndex * componentDimension + component), empty unless summarized
+        std::vector<ValueSummary> summaries;
+
+        // the fingerprint of the values in a time invariant geometry, zero unless the meshes were fingerprinted
+        uint64_t contentHash = 0;
+
+       public:
+        bool HasTimeDimension() const { return shape.size() > 2; }
+
+        unsigned long long GetDof() const { return shape.size() > 2 ? shape[1] : shape[0]; }
+        unsigned long long GetDimension() const { return componentDimension; }
+    };
+
+    struct GridDescription {
+        std::string name = "domain";
+        // store each type of geometry/topology data
+        TopologyDescription topology;
+        TopologyDescription hybridTopology;
+        FieldDescription geometry;
+
+        // store the field data
+        std::vector<FieldDescription> fields;
+
+        // This is empty for steady state problems
+        std::vector<double> time;
+
+        // the dataset holding the time values, the path is empty for steady state problems
+        FieldDescription timeDataset;
+
+        // the row in the time dependent datasets of the first time and the rows between each time, so that only some of the times can be written
+        unsigned long long timeStart = 0;
+        unsigned long long timeStride = 1;
+
+        // the rows between each point read from the time dependent datasets, so that a particle grid can be a cheap preview of every nth particle
+        unsigned long long pointStride = 1;
+
+       public:
+        unsigned long long TimeRow(std::size_t timeIndex) const { return timeStart + timeIndex * timeStride; }
+    };
+
+   private:
+    // Store the path to the file
+    std::string hdf5File;
+
+    // store the list of grids
+    std::vector<GridDescription> grids;
+
+    // helper functions
+    static void GenerateFieldsFromPetsc(std::vector<FieldDescription>& fields, const std::vector<std::shared_ptr<petscXdmfGenerator::HdfObject>>& hdfFields, FieldLocation location);
+    static DataTypeDescription DataTypeFromHdf(const petscXdmfGenerator::HdfObject& dataset);
+    static void DescribeTime(GridDescription& grid, std::shared_ptr<petscXdmfGenerator::HdfObject>& root);
+    static std::shared_ptr<petscXdmfGenerator::HdfObject> FindPetscHdfChild(std::shared_ptr<petscXdmfGenerator::HdfObject>& root, std::string name);
+
+    // binary serialization helpers
+    static void WriteBinary(std::ostream& stream, const TopologyDescription& topology);
+    static void WriteBinary(std::ostream& stream, const FieldDescription& field);
+    static void ReadBinary(std::istream& stream, TopologyDescription& topology);
+    static void ReadBinary(std::istream& stream, FieldDescription& field);
+
+    // json serialization helpers
+    static JsonValue ToJson(const DataTypeDescription& dataType);
+    static JsonValue ToJson(const TopologyDescription& topology);
+    static JsonValue ToJson(const FieldDescription& field);
+    static DataTypeDescription DataTypeFromJson(const JsonValue& value);
+    static TopologyDescription TopologyFromJson(const JsonValue& value);
+    static FieldDescription FieldFromJson(const JsonValue& value);
+
+    // Allow the builder to access
+    friend class XdmfBuilder;
+    friend class IncrementalState;
+
+   public:
+    /**
+     * Starts a specification for the heavy data file
+     * @param hdf5File the heavy data file referenced by the xdmf, relative to the xdmf file
+     * @param grids
+     */
+    explicit XdmfSpecification(std::string hdf5File = "", std::vector<GridDescription> grids = {});
+
+    // provide generator functions
+    static std::shared_ptr<XdmfSpecification> FromPetscHdf(std::shared_ptr<petscXdmfGenerator::HdfObject>);
+
+    /**
+     * The heavy data file referenced by the xdmf
+     * @return
+     */
+    const std::string& Hdf5File() const { return hdf5File; }
+
+    /**
+     * The grids in the order they are written
+     * @return
+     */
+    const std::vector<GridDescription>& Grids() const { return grids; }
+
+    /**
+     * Adds a grid after the existing grids
+     * @param grid
+     * @return this specification
+     */
+    XdmfSpecification& AddGrid(GridDescription grid);
+
+    /**
+     * Keeps only the fields and times that should be written, so that neither the xdmf nor the heavy data read by the
+     * viewer includes the rest.  The times kept run from the first to the last time inside the window, taking every
+     * nth time, so that each grid still reads a regular selection of rows from its datasets.  Any summaries are
+     * selected with their times.
+     * @param keepField true for each field name that should be kept
+     * @param timeBegin the earliest time kept
+     * @param timeEnd the latest time kept
+     * @param timeStride keep every nth time in the window
+     */
+    void Select(const std::function<bool(const std::string&)>& keepField, double timeBegin, double timeEnd, std::size_t timeStride = 1);
+
+    /**
+     * Adds a level of detail grid named <grid>_lod<N> after each time dependent particle grid for each stride N.  The
+     * copy reads every Nth particle of the same datasets, so viewers can preview the particles from 1/N of the data.
+     * @param pointStrides the particle stride for each level, each greater than one
+     */
+    void AddLevelsOfDetail(const std::vector<unsigned long long>& pointStrides);
+
+    /**
+     * Reads every field a block at a time and stores the minimum, maximum, and mean of each component in each step,
+     * so that viewers can set up color ranges from the xdmf without reading the heavy data.  Only the rows of the
+     * selected times are read, so the times should be selected first.
+     * @param root the open file described by this specification
+     * @param blockValues the most values read at once
+     */
+    void Summarize(std::shared_ptr<petscXdmfGenerator::HdfObject> root, std::size_t blockValues = (std::size_t)1 << 20);
+
+    /**
+     * Hashes the sampled values of each time invariant topology and geometry, so that the files in a series holding
+     * the same mesh can be found by comparing specifications without opening any of the files again
+     * @param root the open file described by this specification
+     */
+    void FingerprintMeshes(std::shared_ptr<petscXdmfGenerator::HdfObject> root);
+
+    /**
+     * true if every time invariant topology and geometry has been fingerprinted
+     * @return
+     */
+    bool IsFingerprinted() const;
+
+    /**
+     * Removes the summaries from every field so that none are written
+     */
+    void ClearSummaries();
+
+    /**
+     * Checks that each grid can be written, throwing std::invalid_argument naming the first problem.  Specifications
+     * read from json or built by hand should be checked before they are used.
+     */
+    void Validate() const;
+
+    /**
+     * Writes the specification in a compact binary form
+     * @param stream
+     */
+    void WriteBinary(std::ostream& stream) const;
+
+    /**
+     * Reads a specification written with WriteBinary
+     * @param stream
+     * @return
+     */
+    static std::shared_ptr<XdmfSpecification> ReadBinary(std::istream& stream);
+
+    /**
+     * Writes the specification as an indented json document
+     * @param stream
+     */
+    void WriteJson(std::ostream& stream) const;
+
+    /**
+     * Reads and validates a specification written with WriteJson (or by any other tool using the same layout)
+     * @param stream
+     * @return
+     */
+    static std::shared_ptr<XdmfSpecification> ReadJson(std::istream& stream);
+
+    /**
+     * The extensions used for saved specifications
+     */
+    inline static const char* JsonExtension = ".json";
+    inline static const char* BinaryExtension = ".pxspec";
+
+    /**
+     * true if the path names a saved specification instead of an hdf5 file
+     * @param filePath
+     * @return
+     */
+    static bool IsSpecificationFile(const std::filesystem::path& filePath);
+
+    /**
+     * Saves the specification as json if the path has a json extension, otherwise in the compact binary form
+     * @param filePath
+     */
+    void Save(const std::filesystem::path& filePath) const;
+
+    /**
+     * Reads a saved specification in either form
+     * @param filePath
+     * @return
+     */
+    static std::shared_ptr<XdmfSpecification> Load(const std::filesystem::path& filePath);
+};
+
+}  // namespace petscXdmfGenerator
+#endif  // PETSCXDMFGENERATOR_XDMFSPECIFICATION_H
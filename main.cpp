@@ -1,7 +1,24 @@
+#include <csignal>
 #include <filesystem>
 #include <iostream>
 #include <memory>
+#include <string>
+#include <vector>
+#include <unistd.h>
 #include "generators.hpp"
+#ifdef PETSCXDMFGENERATOR_USE_MPI
+#include "mpiGenerators.hpp"
+
+// mpi is finalized on every return from main
+struct MpiSession {
+    MpiSession(int *argc, char ***args) { MPI_Init(argc, args); }
+    ~MpiSession() { MPI_Finalize(); }
+};
+#endif
+
+// set when the watch should end
+static volatile std::sig_atomic_t stopRequested = 0;
+static void RequestStop(int) { stopRequested = 1; }
 
 int main(int argc, char **args) {
     // Get the file path
@@ -9,16 +26,325 @@ int main(int argc, char **args) {
         throw std::invalid_argument("the hdf5 file must be specified as the first argument");
     }
 
-    std::filesystem::path filePath(args[1]);
-    if (!std::filesystem::exists(filePath)) {
-        throw std::invalid_argument("unable to locate input file: " + filePath.string());
+    // only batches and series are spread over the ranks, everything else is done by the root rank
+    int rank = 0;
+#ifdef PETSCXDMFGENERATOR_USE_MPI
+    MpiSession mpiSession(&argc, &args);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+#endif
+
+    // parse the options, everything else is an input
+    std::size_t numberOfWorkers = 0;
+    std::filesystem::path seriesFile;
+    std::filesystem::path partitionsFile;
+    std::filesystem::path specificationFile;
+    std::filesystem::path repackFile;
+    bool checkLayout = false;
+    bool incremental = false;
+    bool vtkHdf = false;
+    bool standardOutput = false;
+    bool printStatistics = false;
+    bool watch = false;
+    petscXdmfGenerator::WatchOptions watchOptions;
+    petscXdmfGenerator::PipelineOptions pipelineOptions;
+    petscXdmfGenerator::GenerateOptions options;
+    std::vector<std::string> inputs;
+    for (int a = 1; a < argc; a++) {
+        std::string argument(args[a]);
+        if (argument == "--workers") {
+            if (++a >= argc) {
+                throw std::invalid_argument("--workers requires the number of workers");
+            }
+            numberOfWorkers = std::stoul(args[a]);
+        } else if (argument == "--spec-queue") {
+            if (++a >= argc) {
+                throw std::invalid_argument("--spec-queue requires the number of specifications");
+            }
+            pipelineOptions.specificationQueueDepth = std::stoul(args[a]);
+        } else if (argument == "--write-queue") {
+            if (++a >= argc) {
+                throw std::invalid_argument("--write-queue requires the number of documents");
+            }
+            pipelineOptions.writeQueueDepth = std::stoul(args[a]);
+        } else if (argument == "--series") {
+            if (++a >= argc) {
+                throw std::invalid_argument("--series requires the output xdmf file");
+            }
+            seriesFile = args[a];
+        } else if (argument == "--no-shared-mesh") {
+            options.shareStaticMeshes = false;
+        } else if (argument == "--partitions") {
+            if (++a >= argc) {
+                throw std::invalid_argument("--partitions requires the xdmf output file");
+            }
+            partitionsFile = args[a];
+        } else if (argument == "--save-spec") {
+            if (++a >= argc) {
+                throw std::invalid_argument("--save-spec requires the specification file");
+            }
+            specificationFile = args[a];
+        } else if (argument == "--check-layout") {
+            checkLayout = true;
+        } else if (argument == "--repack") {
+            if (++a >= argc) {
+                throw std::invalid_argument("--repack requires the repacked hdf5 file");
+            }
+            repackFile = args[a];
+        } else if (argument == "--vtkhdf") {
+            vtkHdf = true;
+        } else if (argument == "--incremental") {
+            incremental = true;
+        } else if (argument == "--build-threads") {
+            if (++a >= argc) {
+                throw std::invalid_argument("--build-threads requires the number of threads");
+            }
+            options.buildThreads = std::stoul(args[a]);
+        } else if (argument == "--reference-time") {
+            if (++a >= argc) {
+                throw std::invalid_argument("--reference-time requires the number of time values");
+            }
+            options.timeReferenceThreshold = std::stoul(args[a]);
+        } else if (argument == "--compact") {
+            options.compactOutput = true;
+        } else if (argument == "--stdout") {
+            standardOutput = true;
+        } else if (argument == "--watch") {
+            watch = true;
+        } else if (argument == "--poll") {
+            watchOptions.forcePolling = true;
+        } else if (argument == "--debounce") {
+            if (++a >= argc) {
+                throw std::invalid_argument("--debounce requires the number of milliseconds");
+            }
+            watchOptions.debounce = std::chrono::milliseconds(std::stoul(args[a]));
+        } else if (argument == "--fields") {
+            if (++a >= argc) {
+                throw std::invalid_argument("--fields requires a field name pattern");
+            }
+            options.includeFields.emplace_back(args[a]);
+        } else if (argument == "--exclude-fields") {
+            if (++a >= argc) {
+                throw std::invalid_argument("--exclude-fields requires a field name pattern");
+            }
+            options.excludeFields.emplace_back(args[a]);
+        } else if (argument == "--time-begin") {
+            if (++a >= argc) {
+                throw std::invalid_argument("--time-begin requires the earliest time");
+            }
+            options.timeBegin = std::stod(args[a]);
+        } else if (argument == "--time-end") {
+            if (++a >= argc) {
+                throw std::invalid_argument("--time-end requires the latest time");
+            }
+            options.timeEnd = std::stod(args[a]);
+        } else if (argument == "--time-stride") {
+            if (++a >= argc) {
+                throw std::invalid_argument("--time-stride requires the number of times between each written time");
+            }
+            options.timeStride = std::stoul(args[a]);
+        } else if (argument == "--lod") {
+            if (++a >= argc) {
+                throw std::invalid_argument("--lod requires the particle stride");
+            }
+            options.particleLevelsOfDetail.push_back(std::stoull(args[a]));
+        } else if (argument == "--summaries") {
+            options.fieldSummaries = true;
+        } else if (argument == "--swmr") {
+            options.swmrRead = true;
+        } else if (argument == "--stats") {
+            printStatistics = true;
+        } else if (argument == "--cache") {
+            options.useSpecificationCache = true;
+        } else if (argument == "--cache-dir") {
+            if (++a >= argc) {
+                throw std::invalid_argument("--cache-dir requires the cache directory");
+            }
+            options.useSpecificationCache = true;
+            options.specificationCacheDirectory = args[a];
+        } else {
+            inputs.push_back(argument);
+        }
     }
 
-    // build the path to the output file
-    std::filesystem::path outputFile = filePath.parent_path();
-    outputFile /= (filePath.stem().string() + ".xmf");
+    // the statistics for each conversion are written to stderr as a json line so they never mix with the xdmf
+    auto reportStatistics = [printStatistics](const std::filesystem::path& file, const petscXdmfGenerator::GenerateStatistics& statistics) {
+        if (printStatistics) {
+            std::cerr << "{\"file\": " << file << ", \"statistics\": " << statistics << "}" << std::endl;
+        }
+    };
+
+    // keep regenerating the xdmf for each file in the directory as it is written until interrupted
+    if (watch) {
+        if (rank != 0) {
+            return 0;
+        }
+        if (inputs.size() != 1 || !std::filesystem::is_directory(inputs.front())) {
+            throw std::invalid_argument("--watch requires a single directory");
+        }
+        std::signal(SIGINT, RequestStop);
+        std::signal(SIGTERM, RequestStop);
+        petscXdmfGenerator::Watch(
+            inputs.front(), watchOptions, options,
+            [&](const petscXdmfGenerator::BatchResult &result, petscXdmfGenerator::IncrementalUpdate update) {
+                if (!result.success) {
+                    std::cerr << "unable to convert " << result.inputFilePath << ": " << result.error << std::endl;
+                    return;
+                }
+                reportStatistics(result.inputFilePath, result.statistics);
+                switch (update) {
+                    case petscXdmfGenerator::UNCHANGED:
+                        break;
+                    case petscXdmfGenerator::APPENDED:
+                        std::cout << "XDMF file " << result.outputFilePath << " appended with new time steps" << std::endl;
+                        break;
+                    case petscXdmfGenerator::REBUILT:
+                        std::cout << "XDMF file written to " << result.outputFilePath << std::endl;
+                        break;
+                }
+            },
+            [] { return stopRequested != 0; });
+        return 0;
+    }
+
+    // combine all of the files into a single temporal series
+    if (!seriesFile.empty()) {
+        auto filePaths = petscXdmfGenerator::ExpandInputPaths(inputs);
+        if (filePaths.empty()) {
+            throw std::invalid_argument("unable to locate any input files");
+        }
+#ifdef PETSCXDMFGENERATOR_USE_MPI
+        auto statistics = petscXdmfGenerator::GenerateSeries(MPI_COMM_WORLD, filePaths, seriesFile, options);
+        if (rank != 0) {
+            return 0;
+        }
+#else
+        auto statistics = petscXdmfGenerator::GenerateSeries(filePaths, seriesFile, options);
+#endif
+        reportStatistics(seriesFile, statistics);
+        std::cout << "XDMF series of " << filePaths.size() << " files written to " << seriesFile << std::endl;
+        return 0;
+    }
+
+    // combine the partitions of each step into a spatial collection, the specifications are extracted on the root rank
+    if (!partitionsFile.empty()) {
+        if (rank != 0) {
+            return 0;
+        }
+        auto filePaths = petscXdmfGenerator::ExpandInputPaths(inputs);
+        if (filePaths.empty()) {
+            throw std::invalid_argument("unable to locate any input files");
+        }
+        reportStatistics(partitionsFile, petscXdmfGenerator::GeneratePartitions(filePaths, partitionsFile, options));
+        std::cout << "XDMF collection of " << filePaths.size() << " partitions written to " << partitionsFile << std::endl;
+        return 0;
+    }
+
+    // a single file is converted directly
+    if (inputs.size() == 1 && std::filesystem::is_regular_file(inputs.front())) {
+        if (rank != 0) {
+            return 0;
+        }
+        std::filesystem::path filePath(inputs.front());
+
+        // warn about datasets whose storage does not match the single step reads made for each time
+        if (checkLayout) {
+            for (const auto &report : petscXdmfGenerator::AnalyzeLayout(filePath, options)) {
+                if (!report.aligned) {
+                    std::cerr << "warning: " << report << std::endl;
+                }
+            }
+        }
+
+        // rewrite those datasets with a chunk per step into a new file, which is then converted instead
+        if (!repackFile.empty()) {
+            auto rewritten = petscXdmfGenerator::Repack(filePath, repackFile, options);
+            std::cout << "Repacked " << rewritten.size() << " datasets into " << repackFile << std::endl;
+            filePath = repackFile;
+        }
+
+        // save the specification so that the xdmf can be written later without opening the hdf5 file
+        if (!specificationFile.empty()) {
+            petscXdmfGenerator::GenerateStatistics statistics;
+            petscXdmfGenerator::ReadSpecification(filePath, options, &statistics)->Save(specificationFile);
+            reportStatistics(filePath, statistics);
+            std::cout << "Specification written to " << specificationFile << std::endl;
+            return 0;
+        }
+
+        // write a vtkhdf file that links to the PETSc datasets instead of the xdmf
+        if (vtkHdf) {
+            std::filesystem::path outputFile = filePath.parent_path() / (filePath.stem().string() + ".vtkhdf");
+            reportStatistics(filePath, petscXdmfGenerator::GenerateVtkHdf(filePath, outputFile, options));
+            std::cout << "VTKHDF file written to " << outputFile << std::endl;
+            return 0;
+        }
+
+        // write the xdmf to standard output so it can be piped elsewhere
+        if (standardOutput) {
+            std::cout.flush();
+            reportStatistics(filePath, petscXdmfGenerator::Generate(filePath, STDOUT_FILENO, options));
+            return 0;
+        }
+
+        // build the path to the output file
+        std::filesystem::path outputFile = filePath.parent_path();
+        outputFile /= (filePath.stem().string() + ".xmf");
+
+        // write to the file
+        if (incremental) {
+            petscXdmfGenerator::GenerateStatistics statistics;
+            switch (petscXdmfGenerator::GenerateIncremental(filePath, outputFile, options, &statistics)) {
+                case petscXdmfGenerator::UNCHANGED:
+                    std::cout << "XDMF file " << outputFile << " is up to date" << std::endl;
+                    break;
+                case petscXdmfGenerator::APPENDED:
+                    std::cout << "XDMF file " << outputFile << " appended with new time steps" << std::endl;
+                    break;
+                case petscXdmfGenerator::REBUILT:
+                    std::cout << "XDMF file written to " << outputFile << std::endl;
+                    break;
+            }
+            reportStatistics(filePath, statistics);
+        } else {
+            reportStatistics(filePath, petscXdmfGenerator::Generate(filePath, outputFile, options));
+            std::cout << "XDMF file written to " << outputFile << std::endl;
+        }
+        return 0;
+    }
+
+    // otherwise convert everything as a batch
+    auto filePaths = petscXdmfGenerator::ExpandInputPaths(inputs);
+    if (filePaths.empty()) {
+        throw std::invalid_argument("unable to locate any input files");
+    }
+
+#ifdef PETSCXDMFGENERATOR_USE_MPI
+    // each rank converts a single file at a time
+    if (numberOfWorkers != 0) {
+        throw std::invalid_argument("--workers is not used with mpi, start more ranks instead");
+    }
+    auto results = petscXdmfGenerator::GenerateBatch(MPI_COMM_WORLD, filePaths, {}, options);
+    if (rank != 0) {
+        return 0;
+    }
+#else
+    petscXdmfGenerator::PipelineStatistics pipelineStatistics;
+    auto results = petscXdmfGenerator::GenerateBatch(filePaths, numberOfWorkers, {}, options, pipelineOptions, &pipelineStatistics);
+    if (printStatistics) {
+        std::cerr << "{\"pipeline\": " << pipelineStatistics << "}" << std::endl;
+    }
+#endif
+    std::size_t failures = 0;
+    for (const auto &result : results) {
+        reportStatistics(result.inputFilePath, result.statistics);
+        if (result.success) {
+            std::cout << "XDMF file written to " << result.outputFilePath << std::endl;
+        } else {
+            failures++;
+            std::cerr << "unable to convert " << result.inputFilePath << ": " << result.error << std::endl;
+        }
+    }
+    std::cout << (results.size() - failures) << " of " << results.size() << " files converted" << std::endl;
 
-    // write to the file
-    petscXdmfGenerator::Generate(filePath, outputFile);
-    std::cout << "XDMF file written to " << outputFile << std::endl;
+    return failures == 0 ? 0 : 1;
 }
@@ -0,0 +1,74 @@
+#ifndef PETSCXDMFGENERATOR_BOUNDEDQUEUE_HPP
+#define PETSCXDMFGENERATOR_BOUNDEDQUEUE_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+namespace petscXdmfGenerator {
+/**
+ * A first in, first out queue between two pipeline stages that holds at most a fixed number of items.  A producer
+ * waits while the queue is full and a consumer waits while it is empty, so a fast stage can only run a fixed distance
+ * ahead of a slow one.
+ */
+template <typename T>
+class BoundedQueue {
+   private:
+    const std::size_t capacity;
+    std::deque<T> items;
+    bool closed = false;
+    std::mutex mutex;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+
+   public:
+    /**
+     * @param capacity the number of items held before Push waits, at least one
+     */
+    explicit BoundedQueue(std::size_t capacity) : capacity(capacity == 0 ? 1 : capacity) {}
+
+    /**
+     * Adds an item, waiting until there is room
+     * @param item
+     * @return false if the queue was closed and the item was dropped
+     */
+    bool Push(T item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this] { return closed || items.size() < capacity; });
+        if (closed) {
+            return false;
+        }
+        items.push_back(std::move(item));
+        notEmpty.notify_one();
+        return true;
+    }
+
+    /**
+     * Removes the oldest item, waiting until one is available
+     * @return the item, or empty once the queue is closed and every item has been removed
+     */
+    std::optional<T> Pop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this] { return closed || !items.empty(); });
+        if (items.empty()) {
+            return std::nullopt;
+        }
+        std::optional<T> item(std::move(items.front()));
+        items.pop_front();
+        notFull.notify_one();
+        return item;
+    }
+
+    /**
+     * No more items can be pushed, the items already in the queue can still be removed
+     */
+    void Close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        notFull.notify_all();
+        notEmpty.notify_all();
+    }
+};
+}  // namespace petscXdmfGenerator
+#endif  // PETSCXDMFGENERATOR_BOUNDEDQUEUE_HPP
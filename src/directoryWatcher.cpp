@@ -0,0 +1,124 @@
+#include "directoryWatcher.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__linux__) && __has_include(<sys/inotify.h>)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#define PETSCXDMFGENERATOR_HAS_INOTIFY
+#endif
+
+using namespace petscXdmfGenerator;
+
+static bool IsHdf5Name(const std::filesystem::path& path) { return path.extension() == ".hdf5" || path.extension() == ".h5"; }
+
+petscXdmfGenerator::DirectoryWatcher::DirectoryWatcher(std::filesystem::path directory, std::chrono::milliseconds debounce, std::chrono::milliseconds pollInterval, bool forcePolling)
+    : directory(std::move(directory)), debounce(debounce), pollInterval(std::max(pollInterval, std::chrono::milliseconds(1))) {
+    if (!std::filesystem::is_directory(this->directory)) {
+        throw std::invalid_argument("unable to locate directory: " + this->directory.string());
+    }
+
+#ifdef PETSCXDMFGENERATOR_HAS_INOTIFY
+    // a file is reported when a writer closes it or it is moved into the directory
+    if (!forcePolling) {
+        inotifyDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotifyDescriptor >= 0 && inotify_add_watch(inotifyDescriptor, this->directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+            close(inotifyDescriptor);
+            inotifyDescriptor = -1;
+        }
+    }
+#endif
+
+    // remember the existing files so that only changes are reported
+    if (!UsingInotify()) {
+        Scan();
+        pending.clear();
+    }
+}
+
+petscXdmfGenerator::DirectoryWatcher::~DirectoryWatcher() {
+#ifdef PETSCXDMFGENERATOR_HAS_INOTIFY
+    if (inotifyDescriptor >= 0) {
+        close(inotifyDescriptor);
+    }
+#endif
+}
+
+void petscXdmfGenerator::DirectoryWatcher::ReadEvents(std::chrono::milliseconds timeout) {
+#ifdef PETSCXDMFGENERATOR_HAS_INOTIFY
+    // a signal or timeout returns without any events
+    pollfd descriptor{.fd = inotifyDescriptor, .events = POLLIN, .revents = 0};
+    if (poll(&descriptor, 1, (int)timeout.count()) <= 0) {
+        return;
+    }
+
+    alignas(inotify_event) char buffer[16 * 1024];
+    for (auto length = read(inotifyDescriptor, buffer, sizeof(buffer)); length > 0; length = read(inotifyDescriptor, buffer, sizeof(buffer))) {
+        for (auto event = buffer; event < buffer + length;) {
+            const auto inotifyEvent = reinterpret_cast<const inotify_event*>(event);
+            if (inotifyEvent->len > 0) {
+                auto filePath = directory / inotifyEvent->name;
+                if (IsHdf5Name(filePath)) {
+                    pending[filePath] = Clock::now();
+                }
+            }
+            event += sizeof(inotify_event) + inotifyEvent->len;
+        }
+    }
+#endif
+}
+
+void petscXdmfGenerator::DirectoryWatcher::Scan() {
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+        if (!IsHdf5Name(entry.path()) || !entry.is_regular_file(error)) {
+            continue;
+        }
+
+        // files can be removed while scanning
+        auto size = entry.file_size(error);
+        auto modified = error ? std::filesystem::file_time_type() : entry.last_write_time(error);
+        if (error) {
+            continue;
+        }
+
+        // a file that is still changing keeps being pushed back
+        auto identity = std::make_pair(size, modified);
+        auto previous = scanned.find(entry.path());
+        if (previous == scanned.end() || previous->second != identity) {
+            scanned[entry.path()] = identity;
+            pending[entry.path()] = Clock::now();
+        }
+    }
+}
+
+std::vector<std::filesystem::path> petscXdmfGenerator::DirectoryWatcher::Wait() {
+    // wait until the first pending file could be ready, but never longer than the poll interval
+    auto timeout = pollInterval;
+    const auto now = Clock::now();
+    for (const auto& [filePath, changed] : pending) {
+        timeout = std::min(timeout, std::max(std::chrono::milliseconds(0), std::chrono::duration_cast<std::chrono::milliseconds>(changed + debounce - now)));
+    }
+
+    if (UsingInotify()) {
+        ReadEvents(timeout);
+    } else {
+        std::this_thread::sleep_for(timeout);
+        Scan();
+    }
+
+    // report each file that has been quiet for the debounce time
+    std::vector<std::filesystem::path> ready;
+    const auto checked = Clock::now();
+    for (auto file = pending.begin(); file != pending.end();) {
+        if (checked - file->second >= debounce) {
+            ready.push_back(file->first);
+            file = pending.erase(file);
+        } else {
+            ++file;
+        }
+    }
+    return ready;
+}
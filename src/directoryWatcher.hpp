@@ -0,0 +1,69 @@
+#ifndef PETSCXDMFGENERATOR_DIRECTORYWATCHER_HPP
+#define PETSCXDMFGENERATOR_DIRECTORYWATCHER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace petscXdmfGenerator {
+/**
+ * Reports the hdf5 files in a directory that have been written and closed.  inotify is used when it is available,
+ * otherwise (or when requested, e.g. on a network file system where inotify never sees remote writes) the directory
+ * is polled and a file is reported once its size and modification time stop changing.  Bursts of changes to the same
+ * file are reported once after the file has been quiet for the debounce time.
+ */
+class DirectoryWatcher {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+   private:
+    const std::filesystem::path directory;
+    const std::chrono::milliseconds debounce;
+    const std::chrono::milliseconds pollInterval;
+
+    // the inotify instance, or -1 when polling
+    int inotifyDescriptor = -1;
+
+    // the last time each changed file was seen changing
+    std::map<std::filesystem::path, Clock::time_point> pending;
+
+    // the size and modification time of each file when last scanned (polling only)
+    std::map<std::filesystem::path, std::pair<std::uintmax_t, std::filesystem::file_time_type>> scanned;
+
+    // records the changes seen by inotify until the timeout
+    void ReadEvents(std::chrono::milliseconds timeout);
+
+    // records the files that changed since the last scan
+    void Scan();
+
+   public:
+    /**
+     * Starts watching the directory.  Files that already exist are not reported until they change.
+     * @param directory
+     * @param debounce how long a file must be quiet before it is reported
+     * @param pollInterval how often the directory is scanned when polling, and the longest Wait blocks
+     * @param forcePolling poll even if inotify is available
+     */
+    DirectoryWatcher(std::filesystem::path directory, std::chrono::milliseconds debounce, std::chrono::milliseconds pollInterval, bool forcePolling = false);
+    ~DirectoryWatcher();
+
+    DirectoryWatcher(const DirectoryWatcher&) = delete;
+    void operator=(const DirectoryWatcher&) = delete;
+
+    /**
+     * Waits (at most the poll interval) for files to be written and closed
+     * @return the files that are ready to be converted, possibly none
+     */
+    std::vector<std::filesystem::path> Wait();
+
+    /**
+     * true if changes are reported by inotify instead of polling
+     * @return
+     */
+    bool UsingInotify() const { return inotifyDescriptor >= 0; }
+};
+}  // namespace petscXdmfGenerator
+#endif  // PETSCXDMFGENERATOR_DIRECTORYWATCHER_HPP
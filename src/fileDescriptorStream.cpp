@@ -0,0 +1,107 @@
+#include "fileDescriptorStream.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+petscXdmfGenerator::FileDescriptorBuffer::FileDescriptorBuffer(int fileDescriptor, std::size_t bufferSize) : fileDescriptor(fileDescriptor), buffer(bufferSize) {
+    setp(buffer.data(), buffer.data() + buffer.size());
+}
+
+petscXdmfGenerator::FileDescriptorBuffer::~FileDescriptorBuffer() { WriteBuffer(); }
+
+bool petscXdmfGenerator::FileDescriptorBuffer::WriteBuffer() {
+    // write may accept less than requested, so keep writing until the buffer is empty
+    const auto start = std::chrono::steady_clock::now();
+    auto begin = pbase();
+    bool success = true;
+    while (begin < pptr()) {
+        auto count = ::write(fileDescriptor, begin, pptr() - begin);
+        statistics.writeCalls++;
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            success = false;
+            break;
+        }
+        begin += count;
+        written += count;
+        statistics.bytesWritten += count;
+    }
+    statistics.writeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    setp(buffer.data(), buffer.data() + buffer.size());
+    return success;
+}
+
+petscXdmfGenerator::FileDescriptorBuffer::int_type petscXdmfGenerator::FileDescriptorBuffer::overflow(int_type character) {
+    if (!WriteBuffer()) {
+        return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(character, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(character);
+        pbump(1);
+    }
+    return traits_type::not_eof(character);
+}
+
+std::streamsize petscXdmfGenerator::FileDescriptorBuffer::xsputn(const char* characters, std::streamsize count) {
+    std::streamsize copied = 0;
+    while (copied < count) {
+        if (pptr() == epptr() && !WriteBuffer()) {
+            break;
+        }
+        const auto chunk = std::min<std::streamsize>(count - copied, epptr() - pptr());
+        std::memcpy(pptr(), characters + copied, chunk);
+        pbump((int)chunk);
+        copied += chunk;
+    }
+    return copied;
+}
+
+int petscXdmfGenerator::FileDescriptorBuffer::sync() { return WriteBuffer() ? 0 : -1; }
+
+petscXdmfGenerator::FileDescriptorBuffer::pos_type petscXdmfGenerator::FileDescriptorBuffer::seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode mode) {
+    // only the current position can be queried (tellp)
+    if (offset != 0 || direction != std::ios_base::cur || !(mode & std::ios_base::out)) {
+        return pos_type(off_type(-1));
+    }
+    return pos_type(written + (pptr() - pbase()));
+}
+
+petscXdmfGenerator::FileDescriptorStream::FileDescriptorStream(int fileDescriptor, std::size_t bufferSize) : std::ostream(nullptr), buffer(fileDescriptor, bufferSize) { rdbuf(&buffer); }
+
+petscXdmfGenerator::OutputFileStream::OutputFileStream(std::filesystem::path filePath, std::size_t bufferSize) : std::ostream(nullptr), filePath(std::move(filePath)) {
+    fileDescriptor = ::open(this->filePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fileDescriptor < 0) {
+        throw std::runtime_error("unable to open output file " + this->filePath.string() + ": " + std::strerror(errno));
+    }
+    buffer = std::make_unique<FileDescriptorBuffer>(fileDescriptor, bufferSize);
+    rdbuf(buffer.get());
+}
+
+petscXdmfGenerator::OutputFileStream::~OutputFileStream() {
+    if (fileDescriptor >= 0) {
+        buffer.reset();
+        ::close(fileDescriptor);
+    }
+}
+
+void petscXdmfGenerator::OutputFileStream::Close() {
+    if (fileDescriptor < 0) {
+        return;
+    }
+    flush();
+    const bool written = static_cast<bool>(*this);
+    statistics = buffer->Statistics();
+    rdbuf(nullptr);
+    buffer.reset();
+    const auto closed = ::close(fileDescriptor);
+    fileDescriptor = -1;
+    if (!written || closed < 0) {
+        throw std::runtime_error("unable to write output file " + filePath.string());
+    }
+}
@@ -0,0 +1,105 @@
+#ifndef PETSCXDMFGENERATOR_FILEDESCRIPTORSTREAM_HPP
+#define PETSCXDMFGENERATOR_FILEDESCRIPTORSTREAM_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <streambuf>
+#include <vector>
+
+namespace petscXdmfGenerator {
+
+/**
+ * The work done writing to a file descriptor
+ */
+struct WriteStatistics {
+    uint64_t bytesWritten = 0;
+    uint64_t writeCalls = 0;
+    // the time spent inside write calls
+    double writeSeconds = 0;
+};
+
+/**
+ * A stream buffer that collects the output in a large buffer and writes it to a file descriptor in as few write calls
+ * as possible.  The file descriptor is not owned by the buffer.
+ */
+class FileDescriptorBuffer : public std::streambuf {
+   private:
+    const int fileDescriptor;
+    std::vector<char> buffer;
+
+    // the number of bytes already written to the file descriptor
+    std::streamoff written = 0;
+    WriteStatistics statistics;
+
+    // writes the buffered bytes, returning false on error
+    bool WriteBuffer();
+
+   protected:
+    int_type overflow(int_type character) override;
+    std::streamsize xsputn(const char* characters, std::streamsize count) override;
+    int sync() override;
+    pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode mode) override;
+
+   public:
+    inline const static std::size_t DefaultBufferSize = 1 << 20;
+
+    explicit FileDescriptorBuffer(int fileDescriptor, std::size_t bufferSize = DefaultBufferSize);
+    ~FileDescriptorBuffer() override;
+
+    /**
+     * the bytes written so far, not including any that are still buffered
+     * @return
+     */
+    const WriteStatistics& Statistics() const { return statistics; }
+};
+
+/**
+ * An output stream that writes directly to a file descriptor through a FileDescriptorBuffer
+ */
+class FileDescriptorStream : public std::ostream {
+   private:
+    FileDescriptorBuffer buffer;
+
+   public:
+    explicit FileDescriptorStream(int fileDescriptor, std::size_t bufferSize = FileDescriptorBuffer::DefaultBufferSize);
+
+    /**
+     * the bytes written so far, not including any that are still buffered
+     * @return
+     */
+    const WriteStatistics& Statistics() const { return buffer.Statistics(); }
+};
+
+/**
+ * An output stream that creates (or truncates) a file and writes to it through a FileDescriptorBuffer
+ */
+class OutputFileStream : public std::ostream {
+   private:
+    int fileDescriptor = -1;
+    std::unique_ptr<FileDescriptorBuffer> buffer;
+    const std::filesystem::path filePath;
+
+    // kept once the buffer is released
+    WriteStatistics statistics;
+
+   public:
+    explicit OutputFileStream(std::filesystem::path filePath, std::size_t bufferSize = FileDescriptorBuffer::DefaultBufferSize);
+    ~OutputFileStream() override;
+
+    /**
+     * writes any buffered output and closes the file, throwing if any of the output could not be written
+     */
+    void Close();
+
+    /**
+     * the bytes written so far, not including any that are still buffered
+     * @return
+     */
+    const WriteStatistics& Statistics() const { return buffer ? buffer->Statistics() : statistics; }
+};
+
+}  // namespace petscXdmfGenerator
+
+#endif  // PETSCXDMFGENERATOR_FILEDESCRIPTORSTREAM_HPP
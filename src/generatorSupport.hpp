@@ -0,0 +1,53 @@
+#ifndef PETSCXDMFGENERATOR_GENERATORSUPPORT_HPP
+#define PETSCXDMFGENERATOR_GENERATORSUPPORT_HPP
+
+#include <filesystem>
+#include <memory>
+#include <vector>
+#include "generators.hpp"
+#include "xdmfBuilder.hpp"
+#include "xdmfSpecification.hpp"
+
+/**
+ * The steps shared by the generators in the library and the optional mpi generators
+ */
+namespace petscXdmfGenerator::support {
+/**
+ * The xdmf file for an input, the input file name with an xmf extension
+ * @param inputFilePath
+ * @param outputDirectory the directory for the xdmf file, or empty to use the directory of the input
+ * @return
+ */
+std::filesystem::path DefaultOutputFilePath(const std::filesystem::path& inputFilePath, const std::filesystem::path& outputDirectory = {});
+
+/**
+ * Reads the specification from the cache (when enabled) or extracts it from the hdf5 file
+ * @param inputFilePath
+ * @param options
+ * @param statistics the work done is added to these statistics
+ * @param lockLibrary hold the hdf5 library lock while the file is open
+ * @param fingerprintMeshes hash the time invariant meshes while the file is open so that ShareStaticMeshes can compare them
+ * @return
+ */
+std::shared_ptr<XdmfSpecification> LoadSpecification(const std::filesystem::path& inputFilePath, const GenerateOptions& options, GenerateStatistics& statistics, bool lockLibrary = false,
+                                                     bool fingerprintMeshes = false);
+
+/**
+ * Points the time invariant meshes in a series that are identical to a mesh in an earlier file at that file's
+ * DataItems.  Meshes are compared by grid, path, and the fingerprint stored when the specification was extracted
+ * (shape, type, and the hash of a few sampled blocks of values), so no file is opened again.
+ * @param series the specification for each file in time order
+ * @param builder
+ * @param options
+ */
+void ShareStaticMeshes(const std::vector<std::shared_ptr<XdmfSpecification>>& series, XdmfBuilder& builder, const GenerateOptions& options);
+
+/**
+ * Applies the options that control how the xdmf is built
+ * @param builder
+ * @param options
+ */
+void ConfigureBuilder(XdmfBuilder& builder, const GenerateOptions& options);
+}  // namespace petscXdmfGenerator::support
+
+#endif  // PETSCXDMFGENERATOR_GENERATORSUPPORT_HPP
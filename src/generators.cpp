@@ -1,36 +1,978 @@
+#include "generators.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include "boundedQueue.hpp"
+#include "directoryWatcher.hpp"
+#include "fileDescriptorStream.hpp"
+#include "generatorSupport.hpp"
+#include "incrementalState.hpp"
+#include "repacker.hpp"
+#include "sinkStream.hpp"
+#include "specificationCache.hpp"
+#include "vtkHdfBuilder.hpp"
 #include "xdmfBuilder.hpp"
 
+using petscXdmfGenerator::support::ConfigureBuilder;
+using petscXdmfGenerator::support::DefaultOutputFilePath;
+using petscXdmfGenerator::support::LoadSpecification;
+using petscXdmfGenerator::support::ShareStaticMeshes;
+
+std::filesystem::path petscXdmfGenerator::support::DefaultOutputFilePath(const std::filesystem::path& inputFilePath, const std::filesystem::path& outputDirectory) {
+    auto outputFilePath = outputDirectory.empty() ? inputFilePath.parent_path() : outputDirectory;
+    outputFilePath /= (inputFilePath.stem().string() + ".xmf");
+    return outputFilePath;
+}
+
+static bool IsHdf5File(const std::filesystem::path& path) { return std::filesystem::is_regular_file(path) && (path.extension() == ".hdf5" || path.extension() == ".h5"); }
+
+// the hdf5 file read for an input, a saved specification points at the file next to it
+static std::filesystem::path Hdf5FilePath(const std::filesystem::path& inputFilePath, const petscXdmfGenerator::XdmfSpecification& specification) {
+    return petscXdmfGenerator::XdmfSpecification::IsSpecificationFile(inputFilePath) ? inputFilePath.parent_path() / specification.Hdf5File() : inputFilePath;
+}
+
+static bool MatchesGlob(const char* pattern, const char* name) {
+    for (; *pattern; pattern++, name++) {
+        if (*pattern == '*') {
+            // try every possible length for the wildcard
+            for (const char* n = name;; n++) {
+                if (MatchesGlob(pattern + 1, n)) {
+                    return true;
+                }
+                if (!*n) {
+                    return false;
+                }
+            }
+        }
+        if (!*name || (*pattern != '?' && *pattern != *name)) {
+            return false;
+        }
+    }
+    return !*name;
+}
+
+static bool NaturalLess(const std::filesystem::path& aPath, const std::filesystem::path& bPath) {
+    const auto a = aPath.string();
+    const auto b = bPath.string();
+    std::size_t i = 0, j = 0;
+    while (i < a.size() && j < b.size()) {
+        if (std::isdigit((unsigned char)a[i]) && std::isdigit((unsigned char)b[j])) {
+            // compare runs of digits by value
+            auto iEnd = a.find_first_not_of("0123456789", i);
+            auto jEnd = b.find_first_not_of("0123456789", j);
+            iEnd = iEnd == std::string::npos ? a.size() : iEnd;
+            jEnd = jEnd == std::string::npos ? b.size() : jEnd;
+            auto aDigits = a.substr(i, iEnd - i);
+            auto bDigits = b.substr(j, jEnd - j);
+            aDigits.erase(0, std::min(aDigits.find_first_not_of('0'), aDigits.size()));
+            bDigits.erase(0, std::min(bDigits.find_first_not_of('0'), bDigits.size()));
+            if (aDigits.size() != bDigits.size()) {
+                return aDigits.size() < bDigits.size();
+            }
+            if (aDigits != bDigits) {
+                return aDigits < bDigits;
+            }
+            i = iEnd;
+            j = jEnd;
+        } else {
+            if (a[i] != b[j]) {
+                return a[i] < b[j];
+            }
+            i++;
+            j++;
+        }
+    }
+    return (a.size() - i) < (b.size() - j) || (i == a.size() && j == b.size() && a < b);
+}
+
+using Clock = std::chrono::steady_clock;
+
+static double SecondsSince(Clock::time_point start) { return std::chrono::duration<double>(Clock::now() - start).count(); }
+
+// adds the time from construction to destruction to the phase
+class PhaseTimer {
+   private:
+    double& seconds;
+    const Clock::time_point start = Clock::now();
+
+   public:
+    explicit PhaseTimer(double& seconds) : seconds(seconds) {}
+    ~PhaseTimer() { seconds += SecondsSince(start); }
+};
+
+// adds the hdf5 calls made on this thread between the two snapshots
+static void AddHdfStatistics(petscXdmfGenerator::GenerateStatistics& statistics, const petscXdmfGenerator::HdfObject::Statistics& before, const petscXdmfGenerator::HdfObject::Statistics& after) {
+    statistics.hdfOpens += after.opens - before.opens;
+    statistics.hdfMetadataQueries += after.metadataQueries - before.metadataQueries;
+    statistics.hdfLinkChecks += after.linkChecks - before.linkChecks;
+    statistics.hdfIterations += after.iterations - before.iterations;
+    statistics.hdfAttributeChecks += after.attributeChecks - before.attributeChecks;
+    statistics.hdfAttributeReads += after.attributeReads - before.attributeReads;
+    statistics.hdfDatasetReads += after.datasetReads - before.datasetReads;
+    statistics.hdfBytesRead += after.bytesRead - before.bytesRead;
+}
+
+// splits the time since the build started into building and the writes reported by the stream
+static void RecordBuild(petscXdmfGenerator::GenerateStatistics& statistics, Clock::time_point buildStart, const petscXdmfGenerator::WriteStatistics* writeStatistics) {
+    const auto seconds = SecondsSince(buildStart);
+    if (writeStatistics) {
+        statistics.writeSeconds += writeStatistics->writeSeconds;
+        statistics.bytesWritten += writeStatistics->bytesWritten;
+    }
+    statistics.buildSeconds += seconds - (writeStatistics ? writeStatistics->writeSeconds : 0);
+}
+
+// keeps only the fields, times, and summaries selected by the options
+static void SelectFromOptions(petscXdmfGenerator::XdmfSpecification& specification, const petscXdmfGenerator::GenerateOptions& options) {
+    auto matchesAny = [](const std::vector<std::string>& patterns, const std::string& name) {
+        return std::any_of(patterns.begin(), patterns.end(), [&name](const std::string& pattern) { return MatchesGlob(pattern.c_str(), name.c_str()); });
+    };
+    specification.Select([&](const std::string& name) { return (options.includeFields.empty() || matchesAny(options.includeFields, name)) && !matchesAny(options.excludeFields, name); },
+                         options.timeBegin, options.timeEnd, options.timeStride);
+
+    // a saved specification may hold summaries from an earlier run that asked for them
+    if (!options.fieldSummaries) {
+        specification.ClearSummaries();
+    }
+}
+
+// adds the level of detail particle grids, each copying the summaries of the selected times
+static void AddLevelsOfDetail(petscXdmfGenerator::XdmfSpecification& specification, const petscXdmfGenerator::GenerateOptions& options) {
+    if (!options.particleLevelsOfDetail.empty()) {
+        specification.AddLevelsOfDetail(options.particleLevelsOfDetail);
+    }
+}
+
+// loads and selects the specification, summarizing only the selected times while the file is open
+static std::shared_ptr<petscXdmfGenerator::XdmfSpecification> LoadSelectedSpecification(const std::filesystem::path& inputFilePath, const petscXdmfGenerator::GenerateOptions& options,
+                                                                                        petscXdmfGenerator::GenerateStatistics& statistics, bool lockLibrary, bool fingerprintMeshes) {
+    // a saved specification is used as is, along with any summaries it holds
+    if (petscXdmfGenerator::XdmfSpecification::IsSpecificationFile(inputFilePath)) {
+        PhaseTimer loadTimer(statistics.specificationSeconds);
+        auto specification = petscXdmfGenerator::XdmfSpecification::Load(inputFilePath);
+        SelectFromOptions(*specification, options);
+        return specification;
+    }
+
+    // check for a cached specification before opening the file with hdf5
+    std::unique_ptr<petscXdmfGenerator::SpecificationCache> cache;
+    std::shared_ptr<petscXdmfGenerator::XdmfSpecification> specification;
+    if (options.useSpecificationCache) {
+        PhaseTimer cacheTimer(statistics.specificationSeconds);
+        cache = std::make_unique<petscXdmfGenerator::SpecificationCache>(options.specificationCacheDirectory);
+        specification = cache->Get(inputFilePath);
+        // an entry without the requested fingerprints is extracted again
+        if (specification && fingerprintMeshes && !specification->IsFingerprinted()) {
+            specification.reset();
+        }
+        if (specification) {
+            statistics.cachedSpecifications++;
+        }
+    }
+
+    // the summaries depend on the selection, so a cached specification still needs the file to summarize
+    std::shared_ptr<const petscXdmfGenerator::XdmfSpecification> extracted;
+    if (!specification || options.fieldSummaries) {
+        // only a single thread may use the hdf5 library at a time
+        std::unique_lock<std::mutex> lock;
+        if (lockLibrary) {
+            lock = std::unique_lock<std::mutex>(petscXdmfGenerator::HdfObject::LibraryMutex());
+        }
+
+        // every hdf5 call for this file is made on this thread
+        const auto before = petscXdmfGenerator::HdfObject::ThreadStatistics();
+        std::shared_ptr<petscXdmfGenerator::HdfObject> hdfObject;
+        {
+            PhaseTimer openTimer(statistics.openSeconds);
+            hdfObject = std::make_shared<petscXdmfGenerator::HdfObject>(inputFilePath, options.swmrRead);
+        }
+        {
+            PhaseTimer specificationTimer(statistics.specificationSeconds);
+            if (!specification) {
+                specification = petscXdmfGenerator::XdmfSpecification::FromPetscHdf(hdfObject);
+                if (fingerprintMeshes) {
+                    specification->FingerprintMeshes(hdfObject);
+                }
+                // the cache holds every field and time so that any selection can be made from it
+                if (cache) {
+                    extracted = std::make_shared<const petscXdmfGenerator::XdmfSpecification>(*specification);
+                }
+            }
+            SelectFromOptions(*specification, options);
+            if (options.fieldSummaries) {
+                specification->Summarize(hdfObject);
+            }
+        }
+        AddHdfStatistics(statistics, before, petscXdmfGenerator::HdfObject::ThreadStatistics());
+    } else {
+        PhaseTimer selectTimer(statistics.specificationSeconds);
+        SelectFromOptions(*specification, options);
+    }
+
+    if (extracted) {
+        PhaseTimer cacheTimer(statistics.specificationSeconds);
+        cache->Put(inputFilePath, *extracted);
+    }
+    return specification;
+}
+
+std::shared_ptr<petscXdmfGenerator::XdmfSpecification> petscXdmfGenerator::support::LoadSpecification(const std::filesystem::path& inputFilePath, const GenerateOptions& options,
+                                                                                                       GenerateStatistics& statistics, bool lockLibrary, bool fingerprintMeshes) {
+    auto specification = LoadSelectedSpecification(inputFilePath, options, statistics, lockLibrary, fingerprintMeshes);
+    PhaseTimer detailTimer(statistics.specificationSeconds);
+    AddLevelsOfDetail(*specification, options);
+    return specification;
+}
+
+static std::shared_ptr<petscXdmfGenerator::XdmfSpecification> LoadSpecification(petscXdmfGenerator::HdfId fileOrGroupId, const petscXdmfGenerator::GenerateOptions& options,
+                                                                                petscXdmfGenerator::GenerateStatistics& statistics) {
+    static_assert(std::is_same_v<petscXdmfGenerator::HdfId, hid_t>, "HdfId must match the hid_t used by hdf5");
+
+    // the objects opened below the id are closed before returning, the id itself is left open
+    const auto before = petscXdmfGenerator::HdfObject::ThreadStatistics();
+    std::shared_ptr<petscXdmfGenerator::HdfObject> hdfObject;
+    {
+        PhaseTimer openTimer(statistics.openSeconds);
+        hdfObject = std::make_shared<petscXdmfGenerator::HdfObject>((hid_t)fileOrGroupId);
+    }
+    std::shared_ptr<petscXdmfGenerator::XdmfSpecification> specification;
+    {
+        PhaseTimer specificationTimer(statistics.specificationSeconds);
+        specification = petscXdmfGenerator::XdmfSpecification::FromPetscHdf(hdfObject);
+        SelectFromOptions(*specification, options);
+        if (options.fieldSummaries) {
+            specification->Summarize(hdfObject);
+        }
+        AddLevelsOfDetail(*specification, options);
+    }
+    AddHdfStatistics(statistics, before, petscXdmfGenerator::HdfObject::ThreadStatistics());
+    return specification;
+}
+
+static std::vector<std::shared_ptr<petscXdmfGenerator::XdmfSpecification>> SeriesSpecifications(const std::vector<std::filesystem::path>& inputFilePaths,
+                                                                                               const petscXdmfGenerator::GenerateOptions& options,
+                                                                                               petscXdmfGenerator::GenerateStatistics& statistics, bool shareStaticMeshes) {
+    // each file is opened and scanned exactly once, fingerprinting the meshes while it is open when they may be shared
+    const auto fingerprintMeshes = shareStaticMeshes && options.shareStaticMeshes && inputFilePaths.size() > 1;
+    std::vector<std::shared_ptr<petscXdmfGenerator::XdmfSpecification>> series;
+    for (const auto& inputFilePath : inputFilePaths) {
+        series.push_back(LoadSpecification(inputFilePath, options, statistics, false, fingerprintMeshes));
+    }
+    return series;
+}
+
+void petscXdmfGenerator::support::ShareStaticMeshes(const std::vector<std::shared_ptr<XdmfSpecification>>& series, XdmfBuilder& builder, const GenerateOptions& options) {
+    if (!options.shareStaticMeshes || series.size() < 2) {
+        return;
+    }
+
+    // the fingerprint of each time invariant mesh dataset already seen, by grid name and dataset path, mapped to the first file holding it
+    std::map<std::tuple<std::string, std::string, uint64_t>, std::size_t> firstFiles;
+    for (std::size_t s = 0; s < series.size(); s++) {
+        for (const auto& grid : series[s]->Grids()) {
+            if (grid.geometry.HasTimeDimension()) {
+                continue;
+            }
+            std::vector<std::pair<const std::string*, uint64_t>> meshes;
+            if (grid.topology.number > 0) {
+                meshes.emplace_back(&grid.topology.path, grid.topology.contentHash);
+            }
+            if (grid.hybridTopology.number > 0) {
+                meshes.emplace_back(&grid.hybridTopology.path, grid.hybridTopology.contentHash);
+            }
+            if (grid.geometry.GetDof() > 0) {
+                meshes.emplace_back(&grid.geometry.path, grid.geometry.contentHash);
+            }
+
+            // a mesh that was never fingerprinted is always written
+            for (const auto& [path, contentHash] : meshes) {
+                if (contentHash == 0) {
+                    continue;
+                }
+                auto [first, inserted] = firstFiles.emplace(std::make_tuple(grid.name, *path, contentHash), s);
+                if (!inserted && first->second != s) {
+                    builder.ShareHeavyData(s, *path, first->second);
+                }
+            }
+        }
+    }
+}
+
+void petscXdmfGenerator::support::ConfigureBuilder(XdmfBuilder& builder, const GenerateOptions& options) {
+    builder.SetBuildThreads(options.buildThreads);
+    builder.SetFormat(options.compactOutput ? petscXdmfGenerator::COMPACT : petscXdmfGenerator::PRETTY);
+    builder.SetTimeReferenceThreshold(options.timeReferenceThreshold);
+}
+
 namespace petscXdmfGenerator {
-void Generate(std::filesystem::path inputFilePath, std::filesystem::path outputFilePath) {
+std::ostream& operator<<(std::ostream& stream, const GenerateStatistics& statistics) {
+    stream << "{\"cachedSpecifications\": " << statistics.cachedSpecifications << ", \"hdfOpens\": " << statistics.hdfOpens << ", \"hdfMetadataQueries\": " << statistics.hdfMetadataQueries
+           << ", \"hdfLinkChecks\": " << statistics.hdfLinkChecks << ", \"hdfIterations\": " << statistics.hdfIterations << ", \"hdfAttributeChecks\": " << statistics.hdfAttributeChecks
+           << ", \"hdfAttributeReads\": " << statistics.hdfAttributeReads << ", \"hdfDatasetReads\": " << statistics.hdfDatasetReads << ", \"hdfBytesRead\": " << statistics.hdfBytesRead
+           << ", \"openSeconds\": " << statistics.openSeconds << ", \"specificationSeconds\": " << statistics.specificationSeconds << ", \"buildSeconds\": " << statistics.buildSeconds
+           << ", \"writeSeconds\": " << statistics.writeSeconds << ", \"totalSeconds\": " << statistics.totalSeconds << ", \"bytesWritten\": " << statistics.bytesWritten << "}";
+    return stream;
+}
+
+GenerateStatistics Generate(std::filesystem::path inputFilePath, std::filesystem::path outputFilePath, const GenerateOptions& options) {
+    const auto start = Clock::now();
+    GenerateStatistics statistics;
+
     // prepare the builder
-    auto hdfObject = std::make_shared<petscXdmfGenerator::HdfObject>(inputFilePath);
-    auto specification = petscXdmfGenerator::XdmfSpecification::FromPetscHdf(hdfObject);
+    auto specification = LoadSpecification(inputFilePath, options, statistics);
     auto builder = petscXdmfGenerator::XdmfBuilder(specification);
-    auto xml = builder.Build();
+    ConfigureBuilder(builder, options);
 
     // build the path to the output file
     if (outputFilePath.empty()) {
-        outputFilePath = inputFilePath.parent_path();
-        outputFilePath /= (inputFilePath.stem().string() + ".xmf");
+        outputFilePath = DefaultOutputFilePath(inputFilePath);
     }
 
     // write to the file
-    std::ofstream xmlFile;
-    xmlFile.open(outputFilePath);
-    xml->PrettyPrint(xmlFile);
-    xmlFile.close();
+    const auto buildStart = Clock::now();
+    OutputFileStream xmlFile(outputFilePath);
+    builder.Build(xmlFile);
+    xmlFile.Close();
+    RecordBuild(statistics, buildStart, &xmlFile.Statistics());
+
+    statistics.totalSeconds = SecondsSince(start);
+    return statistics;
+}
+
+GenerateStatistics Generate(std::filesystem::path inputFilePath, int fileDescriptor, const GenerateOptions& options) {
+    const auto start = Clock::now();
+    GenerateStatistics statistics;
+
+    // prepare the builder
+    auto specification = LoadSpecification(inputFilePath, options, statistics);
+    auto builder = petscXdmfGenerator::XdmfBuilder(specification);
+    ConfigureBuilder(builder, options);
+
+    // write to the file descriptor
+    const auto buildStart = Clock::now();
+    FileDescriptorStream stream(fileDescriptor);
+    builder.Build(stream);
+    stream.flush();
+    if (!stream) {
+        throw std::runtime_error("unable to write to file descriptor " + std::to_string(fileDescriptor));
+    }
+    RecordBuild(statistics, buildStart, &stream.Statistics());
+
+    statistics.totalSeconds = SecondsSince(start);
+    return statistics;
 }
 
-void Generate(std::filesystem::path inputFilePath, std::ostream& stream) {
+GenerateStatistics Generate(std::filesystem::path inputFilePath, std::ostream& stream, const GenerateOptions& options) {
+    const auto start = Clock::now();
+    GenerateStatistics statistics;
+
     // prepare the builder
-    auto hdfObject = std::make_shared<petscXdmfGenerator::HdfObject>(inputFilePath);
-    auto specification = petscXdmfGenerator::XdmfSpecification::FromPetscHdf(hdfObject);
+    auto specification = LoadSpecification(inputFilePath, options, statistics);
     auto builder = petscXdmfGenerator::XdmfBuilder(specification);
-    auto xml = builder.Build();
+    ConfigureBuilder(builder, options);
 
     // write to the stream
-    xml->PrettyPrint(stream);
+    const auto buildStart = Clock::now();
+    builder.Build(stream);
+    RecordBuild(statistics, buildStart, nullptr);
+
+    statistics.totalSeconds = SecondsSince(start);
+    return statistics;
+}
+
+std::shared_ptr<XdmfSpecification> ReadSpecification(const std::filesystem::path& inputFilePath, const GenerateOptions& options, GenerateStatistics* statistics) {
+    const auto start = Clock::now();
+    GenerateStatistics localStatistics;
+    if (!statistics) {
+        statistics = &localStatistics;
+    }
+    *statistics = {};
+
+    auto specification = LoadSpecification(inputFilePath, options, *statistics);
+    statistics->totalSeconds = SecondsSince(start);
+    return specification;
+}
+
+GenerateStatistics Generate(std::shared_ptr<XdmfSpecification> specification, std::filesystem::path outputFilePath, const GenerateOptions& options) {
+    const auto start = Clock::now();
+    GenerateStatistics statistics;
+    specification->Validate();
+    auto builder = petscXdmfGenerator::XdmfBuilder(std::move(specification));
+    ConfigureBuilder(builder, options);
+
+    // write to the file
+    const auto buildStart = Clock::now();
+    OutputFileStream xmlFile(outputFilePath);
+    builder.Build(xmlFile);
+    xmlFile.Close();
+    RecordBuild(statistics, buildStart, &xmlFile.Statistics());
+
+    statistics.totalSeconds = SecondsSince(start);
+    return statistics;
+}
+
+GenerateStatistics Generate(std::shared_ptr<XdmfSpecification> specification, std::ostream& stream, const GenerateOptions& options) {
+    const auto start = Clock::now();
+    GenerateStatistics statistics;
+    specification->Validate();
+    auto builder = petscXdmfGenerator::XdmfBuilder(std::move(specification));
+    ConfigureBuilder(builder, options);
+
+    // write to the stream
+    const auto buildStart = Clock::now();
+    builder.Build(stream);
+    RecordBuild(statistics, buildStart, nullptr);
+
+    statistics.totalSeconds = SecondsSince(start);
+    return statistics;
+}
+
+GenerateStatistics GenerateVtkHdf(std::filesystem::path inputFilePath, std::filesystem::path outputFilePath, const GenerateOptions& options) {
+    const auto start = Clock::now();
+    GenerateStatistics statistics;
+    auto specification = LoadSpecification(inputFilePath, options, statistics, true);
+
+    // build the path to the output file
+    if (outputFilePath.empty()) {
+        outputFilePath = inputFilePath.parent_path() / (inputFilePath.stem().string() + petscXdmfGenerator::VtkHdfBuilder::Extension);
+    }
+
+    auto buildStatistics = GenerateVtkHdf(std::move(specification), outputFilePath, options);
+    statistics.buildSeconds += buildStatistics.buildSeconds;
+    statistics.bytesWritten += buildStatistics.bytesWritten;
+    statistics.totalSeconds = SecondsSince(start);
+    return statistics;
+}
+
+GenerateStatistics GenerateVtkHdf(std::shared_ptr<XdmfSpecification> specification, std::filesystem::path outputFilePath, const GenerateOptions&) {
+    const auto start = Clock::now();
+    GenerateStatistics statistics;
+    specification->Validate();
+
+    // the hdf5 writes are the build, only the small arrays that PETSc does not store are written
+    const auto buildStart = Clock::now();
+    for (const auto& filePath : petscXdmfGenerator::VtkHdfBuilder(std::move(specification)).Build(outputFilePath)) {
+        statistics.bytesWritten += std::filesystem::file_size(filePath);
+    }
+    RecordBuild(statistics, buildStart, nullptr);
+
+    statistics.totalSeconds = SecondsSince(start);
+    return statistics;
+}
+
+GenerateStatistics Generate(HdfId fileOrGroupId, const XmlSink& sink, const GenerateOptions& options) {
+    const auto start = Clock::now();
+    GenerateStatistics statistics;
+
+    // prepare the builder
+    auto specification = LoadSpecification(fileOrGroupId, options, statistics);
+    auto builder = petscXdmfGenerator::XdmfBuilder(specification);
+    ConfigureBuilder(builder, options);
+
+    // write to the sink
+    const auto buildStart = Clock::now();
+    SinkStream stream(sink);
+    builder.Build(stream);
+    stream.flush();
+    RecordBuild(statistics, buildStart, &stream.Statistics());
+
+    statistics.totalSeconds = SecondsSince(start);
+    return statistics;
+}
+
+GenerateStatistics Generate(HdfId fileOrGroupId, std::string& buffer, const GenerateOptions& options) {
+    buffer.clear();
+    return Generate(
+        fileOrGroupId, [&buffer](const char* data, std::size_t size) { buffer.append(data, size); }, options);
+}
+
+GenerateStatistics Generate(HdfId fileOrGroupId, std::ostream& stream, const GenerateOptions& options) {
+    const auto start = Clock::now();
+    GenerateStatistics statistics;
+
+    // prepare the builder
+    auto specification = LoadSpecification(fileOrGroupId, options, statistics);
+    auto builder = petscXdmfGenerator::XdmfBuilder(specification);
+    ConfigureBuilder(builder, options);
+
+    // write to the stream
+    const auto buildStart = Clock::now();
+    builder.Build(stream);
+    RecordBuild(statistics, buildStart, nullptr);
+
+    statistics.totalSeconds = SecondsSince(start);
+    return statistics;
+}
+
+IncrementalUpdate GenerateIncremental(std::filesystem::path inputFilePath, std::filesystem::path outputFilePath, const GenerateOptions& options, GenerateStatistics* statistics) {
+    const auto start = Clock::now();
+    GenerateStatistics localStatistics;
+    if (!statistics) {
+        statistics = &localStatistics;
+    }
+    *statistics = {};
+
+    if (outputFilePath.empty()) {
+        outputFilePath = DefaultOutputFilePath(inputFilePath);
+    }
+    auto statePath = IncrementalState::StatePath(outputFilePath);
+    auto previous = std::filesystem::exists(outputFilePath) ? IncrementalState::Read(statePath) : std::nullopt;
+
+    // there is nothing to do if the file has not been written to and is selected the same way
+    if (previous && previous->SameOptions(options) && previous->SameInput(inputFilePath)) {
+        statistics->totalSeconds = SecondsSince(start);
+        return UNCHANGED;
+    }
+
+    // prepare the builder
+    auto specification = LoadSpecification(inputFilePath, options, *statistics);
+    auto state = IncrementalState::FromSpecification(*specification, inputFilePath, options);
+    const bool append = previous && state.GrewFrom(*previous, *specification);
+
+    // reuse each of the steps that were already written
+    XdmfBuilder::StepHooks hooks;
+    std::ifstream previousFile;
+    if (append) {
+        bool grew = false;
+        for (const auto& grid : previous->Grids()) {
+            hooks.existingSteps[grid.name] = grid.timeCount;
+            grew = grew || state.Grid(grid.name).timeCount > grid.timeCount;
+        }
+
+        // the file was touched without adding any steps
+        if (!grew) {
+            for (const auto& grid : previous->Grids()) {
+                state.SetSteps(grid.name, grid.stepsBegin, grid.stepsEnd);
+            }
+            state.Write(statePath);
+            statistics->totalSeconds = SecondsSince(start);
+            return UNCHANGED;
+        }
+
+        previousFile.open(outputFilePath, std::ios::binary);
+        hooks.writeExistingSteps = [&](const std::string& gridName, std::ostream& stream) {
+            const auto& previousGrid = previous->Grid(gridName);
+
+            // time dependent datasets are declared once in the domain, so the existing steps are copied as is
+            previousFile.seekg(previousGrid.stepsBegin);
+            std::streamoff remaining = previousGrid.stepsEnd - previousGrid.stepsBegin;
+            std::vector<char> buffer(64 * 1024);
+            while (remaining > 0 && previousFile.read(buffer.data(), std::min<std::streamoff>(remaining, buffer.size()))) {
+                stream.write(buffer.data(), previousFile.gcount());
+                remaining -= previousFile.gcount();
+            }
+            if (remaining > 0) {
+                throw std::runtime_error("unable to read the existing steps from " + outputFilePath.string());
+            }
+        };
+    }
+    hooks.stepsWritten = [&state](const std::string& gridName, std::streampos begin, std::streampos end) { state.SetSteps(gridName, begin, end); };
+
+    // write to a temporary file so the existing file can be read while building and the update is atomic
+    auto temporaryFilePath = outputFilePath;
+    temporaryFilePath += ".tmp";
+    const auto buildStart = Clock::now();
+    OutputFileStream xmlFile(temporaryFilePath);
+    XdmfBuilder builder(specification);
+    ConfigureBuilder(builder, options);
+    builder.Build(xmlFile, hooks);
+    xmlFile.Close();
+    RecordBuild(*statistics, buildStart, &xmlFile.Statistics());
+    previousFile.close();
+    std::filesystem::rename(temporaryFilePath, outputFilePath);
+    state.Write(statePath);
+
+    statistics->totalSeconds = SecondsSince(start);
+    return append ? APPENDED : REBUILT;
+}
+
+GenerateStatistics GenerateSeries(const std::vector<std::filesystem::path>& inputFilePaths, std::filesystem::path outputFilePath, const GenerateOptions& options) {
+    const auto start = Clock::now();
+    GenerateStatistics statistics;
+    const auto series = SeriesSpecifications(inputFilePaths, options, statistics, true);
+    auto builder = petscXdmfGenerator::XdmfBuilder(series);
+    ConfigureBuilder(builder, options);
+    ShareStaticMeshes(series, builder, options);
+
+    // write to the file
+    const auto buildStart = Clock::now();
+    OutputFileStream xmlFile(outputFilePath);
+    builder.Build(xmlFile);
+    xmlFile.Close();
+    RecordBuild(statistics, buildStart, &xmlFile.Statistics());
+
+    statistics.totalSeconds = SecondsSince(start);
+    return statistics;
+}
+
+GenerateStatistics GenerateSeries(const std::vector<std::filesystem::path>& inputFilePaths, std::ostream& stream, const GenerateOptions& options) {
+    const auto start = Clock::now();
+    GenerateStatistics statistics;
+    const auto series = SeriesSpecifications(inputFilePaths, options, statistics, true);
+    auto builder = petscXdmfGenerator::XdmfBuilder(series);
+    ConfigureBuilder(builder, options);
+    ShareStaticMeshes(series, builder, options);
+
+    // write to the stream
+    const auto buildStart = Clock::now();
+    builder.Build(stream);
+    RecordBuild(statistics, buildStart, nullptr);
+
+    statistics.totalSeconds = SecondsSince(start);
+    return statistics;
+}
+
+GenerateStatistics GenerateSeries(const std::vector<std::shared_ptr<XdmfSpecification>>& series, std::filesystem::path outputFilePath, const GenerateOptions& options) {
+    const auto start = Clock::now();
+    GenerateStatistics statistics;
+    for (const auto& specification : series) {
+        specification->Validate();
+    }
+    auto builder = petscXdmfGenerator::XdmfBuilder(series);
+    ConfigureBuilder(builder, options);
+
+    // write to the file
+    const auto buildStart = Clock::now();
+    OutputFileStream xmlFile(outputFilePath);
+    builder.Build(xmlFile);
+    xmlFile.Close();
+    RecordBuild(statistics, buildStart, &xmlFile.Statistics());
+
+    statistics.totalSeconds = SecondsSince(start);
+    return statistics;
+}
+
+GenerateStatistics GeneratePartitions(const std::vector<std::filesystem::path>& partitionFilePaths, std::filesystem::path outputFilePath, const GenerateOptions& options) {
+    const auto start = Clock::now();
+    GenerateStatistics statistics;
+    auto builder = petscXdmfGenerator::XdmfBuilder(SeriesSpecifications(partitionFilePaths, options, statistics, false), petscXdmfGenerator::SPATIAL_PARTITIONS);
+    ConfigureBuilder(builder, options);
+
+    // write to the file
+    const auto buildStart = Clock::now();
+    OutputFileStream xmlFile(outputFilePath);
+    builder.Build(xmlFile);
+    xmlFile.Close();
+    RecordBuild(statistics, buildStart, &xmlFile.Statistics());
+
+    statistics.totalSeconds = SecondsSince(start);
+    return statistics;
+}
+
+GenerateStatistics GeneratePartitions(const std::vector<std::filesystem::path>& partitionFilePaths, std::ostream& stream, const GenerateOptions& options) {
+    const auto start = Clock::now();
+    GenerateStatistics statistics;
+    auto builder = petscXdmfGenerator::XdmfBuilder(SeriesSpecifications(partitionFilePaths, options, statistics, false), petscXdmfGenerator::SPATIAL_PARTITIONS);
+    ConfigureBuilder(builder, options);
+
+    // write to the stream
+    const auto buildStart = Clock::now();
+    builder.Build(stream);
+    RecordBuild(statistics, buildStart, nullptr);
+
+    statistics.totalSeconds = SecondsSince(start);
+    return statistics;
+}
+
+std::vector<std::filesystem::path> ExpandInputPaths(const std::vector<std::string>& inputs) {
+    std::vector<std::filesystem::path> paths;
+
+    for (const auto& input : inputs) {
+        std::filesystem::path inputPath(input);
+        auto fileName = inputPath.filename().string();
+
+        if (fileName.find_first_of("*?") != std::string::npos) {
+            // match the pattern against each file in the directory
+            auto directory = inputPath.parent_path().empty() ? std::filesystem::path(".") : inputPath.parent_path();
+            if (!std::filesystem::is_directory(directory)) {
+                throw std::invalid_argument("unable to locate directory: " + directory.string());
+            }
+            for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+                if (entry.is_regular_file() && MatchesGlob(fileName.c_str(), entry.path().filename().c_str())) {
+                    paths.push_back(inputPath.parent_path().empty() ? entry.path().filename() : entry.path());
+                }
+            }
+        } else if (std::filesystem::is_directory(inputPath)) {
+            for (const auto& entry : std::filesystem::directory_iterator(inputPath)) {
+                if (IsHdf5File(entry.path())) {
+                    paths.push_back(entry.path());
+                }
+            }
+        } else {
+            // pass through the file so that a missing file is reported with the batch
+            paths.push_back(inputPath);
+        }
+    }
+
+    std::sort(paths.begin(), paths.end(), NaturalLess);
+    paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+    return paths;
+}
+
+std::ostream& operator<<(std::ostream& stream, const PipelineStatistics& statistics) {
+    auto writeStage = [&stream](const char* name, const StageStatistics& stage) {
+        stream << "\"" << name << "\": {\"files\": " << stage.files << ", \"busySeconds\": " << stage.busySeconds << ", \"waitSeconds\": " << stage.waitSeconds
+               << ", \"filesPerSecond\": " << stage.FilesPerSecond() << "}";
+    };
+    stream << "{";
+    writeStage("extract", statistics.extract);
+    stream << ", ";
+    writeStage("build", statistics.build);
+    stream << ", ";
+    writeStage("write", statistics.write);
+    stream << ", \"totalSeconds\": " << statistics.totalSeconds << "}";
+    return stream;
+}
+
+std::vector<BatchResult> GenerateBatch(const std::vector<std::filesystem::path>& inputFilePaths, std::size_t numberOfWorkers, std::filesystem::path outputDirectory, const GenerateOptions& options) {
+    return GenerateBatch(inputFilePaths, numberOfWorkers, std::move(outputDirectory), options, PipelineOptions());
+}
+
+std::vector<BatchResult> GenerateBatch(const std::vector<std::filesystem::path>& inputFilePaths, std::size_t numberOfWorkers, std::filesystem::path outputDirectory, const GenerateOptions& options,
+                                       const PipelineOptions& pipelineOptions, PipelineStatistics* pipelineStatistics) {
+    const auto start = Clock::now();
+    std::vector<BatchResult> results(inputFilePaths.size());
+    for (std::size_t index = 0; index < inputFilePaths.size(); index++) {
+        results[index].inputFilePath = inputFilePaths[index];
+        results[index].outputFilePath = DefaultOutputFilePath(inputFilePaths[index], outputDirectory);
+    }
+    if (numberOfWorkers == 0) {
+        numberOfWorkers = std::max(1u, std::thread::hardware_concurrency());
+    }
+    numberOfWorkers = std::min(numberOfWorkers, std::max<std::size_t>(1, inputFilePaths.size()));
+
+    // a file is only handled by one stage at a time, the queues hand its result from one stage to the next
+    struct ExtractedFile {
+        std::size_t index;
+        Clock::time_point start;
+        std::shared_ptr<XdmfSpecification> specification;
+    };
+    struct BuiltFile {
+        std::size_t index;
+        Clock::time_point start;
+        std::string document;
+    };
+    BoundedQueue<ExtractedFile> extractedFiles(pipelineOptions.specificationQueueDepth);
+    BoundedQueue<BuiltFile> builtFiles(pipelineOptions.writeQueueDepth);
+    PipelineStatistics stages;
+    std::mutex buildStatisticsMutex;
+
+    // a failed file is finished as soon as it fails
+    auto fail = [&results](std::size_t index, Clock::time_point fileStart, const std::exception& exception) {
+        results[index].error = exception.what();
+        results[index].statistics.totalSeconds = SecondsSince(fileStart);
+    };
+
+    // hdf5 may only be used by a single thread, so the specifications are extracted in order by a single thread
+    std::thread extractor([&]() {
+        for (std::size_t index = 0; index < inputFilePaths.size(); index++) {
+            const auto fileStart = Clock::now();
+            std::shared_ptr<XdmfSpecification> specification;
+            try {
+                specification = LoadSpecification(inputFilePaths[index], options, results[index].statistics, true);
+            } catch (std::exception& exception) {
+                fail(index, fileStart, exception);
+            }
+            stages.extract.busySeconds += SecondsSince(fileStart);
+            if (specification) {
+                stages.extract.files++;
+                const auto waitStart = Clock::now();
+                extractedFiles.Push(ExtractedFile{.index = index, .start = fileStart, .specification = std::move(specification)});
+                stages.extract.waitSeconds += SecondsSince(waitStart);
+            }
+        }
+        extractedFiles.Close();
+    });
+
+    // building and serializing does not touch the hdf5 file
+    auto builder = [&]() {
+        StageStatistics stage;
+        for (;;) {
+            auto waitStart = Clock::now();
+            auto extracted = extractedFiles.Pop();
+            stage.waitSeconds += SecondsSince(waitStart);
+            if (!extracted) {
+                break;
+            }
+
+            const auto buildStart = Clock::now();
+            std::ostringstream document;
+            try {
+                XdmfBuilder xdmfBuilder(extracted->specification);
+                ConfigureBuilder(xdmfBuilder, options);
+                xdmfBuilder.Build(document);
+            } catch (std::exception& exception) {
+                fail(extracted->index, extracted->start, exception);
+                stage.busySeconds += SecondsSince(buildStart);
+                continue;
+            }
+            RecordBuild(results[extracted->index].statistics, buildStart, nullptr);
+            stage.busySeconds += SecondsSince(buildStart);
+            stage.files++;
+
+            waitStart = Clock::now();
+            builtFiles.Push(BuiltFile{.index = extracted->index, .start = extracted->start, .document = document.str()});
+            stage.waitSeconds += SecondsSince(waitStart);
+        }
+
+        std::lock_guard<std::mutex> lock(buildStatisticsMutex);
+        stages.build.files += stage.files;
+        stages.build.busySeconds += stage.busySeconds;
+        stages.build.waitSeconds += stage.waitSeconds;
+    };
+
+    // the documents are written in the order they are built
+    std::thread writer([&]() {
+        for (;;) {
+            const auto waitStart = Clock::now();
+            auto built = builtFiles.Pop();
+            stages.write.waitSeconds += SecondsSince(waitStart);
+            if (!built) {
+                break;
+            }
+
+            const auto writeStart = Clock::now();
+            auto& result = results[built->index];
+            try {
+                OutputFileStream xmlFile(result.outputFilePath);
+                xmlFile.write(built->document.data(), (std::streamsize)built->document.size());
+                xmlFile.Close();
+                result.statistics.writeSeconds += xmlFile.Statistics().writeSeconds;
+                result.statistics.bytesWritten += xmlFile.Statistics().bytesWritten;
+                result.success = true;
+                result.statistics.totalSeconds = SecondsSince(built->start);
+                stages.write.files++;
+            } catch (std::exception& exception) {
+                fail(built->index, built->start, exception);
+            }
+            stages.write.busySeconds += SecondsSince(writeStart);
+        }
+    });
+
+    std::vector<std::thread> builders;
+    for (std::size_t w = 0; w < numberOfWorkers; w++) {
+        builders.emplace_back(builder);
+    }
+    extractor.join();
+    for (auto& thread : builders) {
+        thread.join();
+    }
+    builtFiles.Close();
+    writer.join();
+
+    if (pipelineStatistics) {
+        *pipelineStatistics = stages;
+        pipelineStatistics->totalSeconds = SecondsSince(start);
+    }
+    return results;
+}
+
+void Watch(const std::filesystem::path& directory, const WatchOptions& watchOptions, const GenerateOptions& options,
+           const std::function<void(const BatchResult& result, IncrementalUpdate update)>& converted, const std::function<bool()>& stop) {
+    auto convert = [&](const std::filesystem::path& inputFilePath) {
+        BatchResult result{.inputFilePath = inputFilePath, .outputFilePath = DefaultOutputFilePath(inputFilePath, watchOptions.outputDirectory)};
+        auto update = UNCHANGED;
+        try {
+            update = GenerateIncremental(result.inputFilePath, result.outputFilePath, options, &result.statistics);
+            result.success = true;
+        } catch (std::exception& exception) {
+            result.error = exception.what();
+        }
+        converted(result, update);
+    };
+
+    // start watching before the existing files are converted so that no change is missed
+    DirectoryWatcher watcher(directory, watchOptions.debounce, watchOptions.pollInterval, watchOptions.forcePolling);
+    for (const auto& inputFilePath : ExpandInputPaths({directory.string()})) {
+        convert(inputFilePath);
+    }
+
+    while (!stop || !stop()) {
+        for (const auto& inputFilePath : watcher.Wait()) {
+            if (std::filesystem::is_regular_file(inputFilePath)) {
+                convert(inputFilePath);
+            }
+        }
+    }
+}
+
+std::ostream& operator<<(std::ostream& stream, const LayoutReport& report) {
+    auto join = [](const std::vector<unsigned long long>& values) {
+        std::string joined;
+        for (auto value : values) {
+            joined += (joined.empty() ? "" : ", ") + std::to_string(value);
+        }
+        return "(" + joined + ")";
+    };
+    stream << report.path << " " << join(report.shape) << " is " << report.layout;
+    if (!report.chunk.empty()) {
+        stream << " in " << join(report.chunk) << (report.filtered ? " filtered" : "") << " chunks, a " << report.stepBytes << " byte step reads " << report.chunkBytesPerStep << " bytes from "
+               << report.chunksPerStep << (report.chunksPerStep == 1 ? " chunk" : " chunks");
+    }
+    if (!report.aligned) {
+        stream << ", repack so that each step is a single chunk";
+    }
+    return stream;
+}
+
+// the hdf5 file described by an input, saved specifications are next to their hdf5 file
+static std::vector<LayoutReport> AnalyzeLayout(const XdmfSpecification& specification, const std::filesystem::path& hdf5FilePath, const GenerateOptions& options) {
+    // only a single thread may use the hdf5 library at a time
+    std::lock_guard<std::mutex> lock(HdfObject::LibraryMutex());
+    auto root = std::make_shared<HdfObject>(hdf5FilePath, options.swmrRead);
+
+    // each time dependent dataset is read a step at a time, datasets shared between grids are only reported once
+    std::vector<LayoutReport> reports;
+    std::set<std::string> analyzedPaths;
+    for (const auto& grid : specification.Grids()) {
+        std::vector<const XdmfSpecification::FieldDescription*> datasets = {&grid.geometry};
+        for (const auto& field : grid.fields) {
+            datasets.push_back(&field);
+        }
+        for (const auto* dataset : datasets) {
+            if (!dataset->HasTimeDimension() || !analyzedPaths.insert(dataset->path).second) {
+                continue;
+            }
+            if (auto object = root->Get(dataset->path)) {
+                reports.push_back(Repacker::Analyze(*object));
+                reports.back().path = dataset->path;
+            }
+        }
+    }
+    return reports;
+}
+
+std::vector<LayoutReport> AnalyzeLayout(const std::filesystem::path& inputFilePath, const GenerateOptions& options) {
+    GenerateStatistics statistics;
+    auto specification = LoadSpecification(inputFilePath, options, statistics, true);
+    return AnalyzeLayout(*specification, Hdf5FilePath(inputFilePath, *specification), options);
+}
+
+std::vector<LayoutReport> Repack(const std::filesystem::path& inputFilePath, const std::filesystem::path& outputFilePath, const GenerateOptions& options) {
+    GenerateStatistics statistics;
+    auto specification = LoadSpecification(inputFilePath, options, statistics, true);
+    const auto hdf5FilePath = Hdf5FilePath(inputFilePath, *specification);
+
+    // only the datasets that are not read a chunk per step are rewritten
+    std::vector<LayoutReport> rewritten;
+    std::set<std::string> rewrittenPaths;
+    for (auto& report : AnalyzeLayout(*specification, hdf5FilePath, options)) {
+        if (!report.aligned) {
+            rewrittenPaths.insert(report.path);
+            rewritten.push_back(std::move(report));
+        }
+    }
+
+    Repacker(hdf5FilePath, std::move(rewrittenPaths)).Write(outputFilePath);
+    return rewritten;
 }
 }  // namespace petscXdmfGenerator
@@ -0,0 +1,37 @@
+#ifndef PETSCXDMFGENERATOR_HASH_HPP
+#define PETSCXDMFGENERATOR_HASH_HPP
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+namespace petscXdmfGenerator {
+/**
+ * Simple FNV-1a hash.  Unlike std::hash the result is stable between builds so it can be stored in files.
+ */
+class Hash {
+   private:
+    uint64_t value = 14695981039346656037ull;
+
+   public:
+    Hash& Add(const void* data, std::size_t size) {
+        auto bytes = static_cast<const unsigned char*>(data);
+        for (std::size_t b = 0; b < size; b++) {
+            value = (value ^ bytes[b]) * 1099511628211ull;
+        }
+        return *this;
+    }
+
+    Hash& Add(const std::string& string) { return Add(string.data(), string.size() + 1); }
+
+    template <typename T>
+    Hash& Add(const T& scalar) {
+        static_assert(std::is_arithmetic_v<T>, "only scalar values can be hashed directly");
+        return Add(&scalar, sizeof(T));
+    }
+
+    uint64_t Value() const { return value; }
+};
+}  // namespace petscXdmfGenerator
+
+#endif  // PETSCXDMFGENERATOR_HASH_HPP
@@ -1,5 +1,52 @@
 #include "hdfObject.hpp"
 #include <map>
+#include "hash.hpp"
+
+/**
+ * Gets only the basic object information (type and address) when the hdf5 version supports it
+ */
+static herr_t GetBasicInformation(hid_t locId, const char *name, H5O_info_t *information) {
+    petscXdmfGenerator::HdfObject::ThreadStatistics().metadataQueries++;
+#if H5_VERSION_GE(1, 10, 3)
+    return H5Oget_info_by_name2(locId, name, information, H5O_INFO_BASIC, H5P_DEFAULT);
+#else
+    return H5Oget_info_by_name(locId, name, information, H5P_DEFAULT);
+#endif
+}
+
+/**
+ * The name of the file holding an open file or group, which is referenced by the xdmf
+ */
+static std::string CheckedFileName(hid_t fileOrGroupId) {
+    const auto idType = H5Iget_type(fileOrGroupId);
+    if (idType != H5I_FILE && idType != H5I_GROUP) {
+        throw std::invalid_argument("the hdf5 id must be an open file or group");
+    }
+
+    auto length = H5Fget_name(fileOrGroupId, nullptr, 0);
+    if (length < 0) {
+        throw std::runtime_error("cannot get the file name for the hdf5 id");
+    }
+    std::string fileName(length, '\0');
+    H5Fget_name(fileOrGroupId, fileName.data(), length + 1);
+    return std::filesystem::path(fileName).filename();
+}
+
+/**
+ * The path to an open group so that the objects below it keep their full path in the file, empty for the root
+ */
+static std::string GroupPath(hid_t fileOrGroupId) {
+    if (H5Iget_type(fileOrGroupId) != H5I_GROUP) {
+        return "";
+    }
+    auto length = H5Iget_name(fileOrGroupId, nullptr, 0);
+    if (length <= 0) {
+        return "";
+    }
+    std::string groupPath(length, '\0');
+    H5Iget_name(fileOrGroupId, groupPath.data(), length + 1);
+    return groupPath == "/" ? "" : groupPath;
+}
 
 static std::map<H5O_type_t, std::string> h50bjectTypes = {{H5O_TYPE_UNKNOWN, "H5O_TYPE_UNKNOWN"},
                                                           {H5O_TYPE_GROUP, "H5O_TYPE_GROUP"},
@@ -7,91 +54,197 @@ static std::map<H5O_type_t, std::string> h50bjectTypes = {{H5O_TYPE_UNKNOWN, "H5
                                                           {H5O_TYPE_NAMED_DATATYPE, "H5O_TYPE_NAMED_DATATYPE"},
                                                           {H5O_TYPE_MAP, "H5O_TYPE_MAP"}};
 
-petscXdmfGenerator::HdfObject::HdfObject(std::filesystem::path filePath) : parent(nullptr), name(filePath.filename()) {
-    locId = H5Fopen(filePath.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+petscXdmfGenerator::HdfObject::HdfObject(std::filesystem::path filePath, bool swmrRead) : parent(nullptr), name(filePath.filename()), swmrRead(swmrRead) {
+    auto flags = H5F_ACC_RDONLY;
+    if (swmrRead) {
+#if H5_VERSION_GE(1, 10, 0)
+        flags |= H5F_ACC_SWMR_READ;
+#else
+        throw std::invalid_argument("swmr reading requires hdf5 1.10 or newer");
+#endif
+    }
+
+    ThreadStatistics().opens++;
+    locId = H5Fopen(filePath.c_str(), flags, H5P_DEFAULT);
     if (locId < 0) {
         throw std::runtime_error("cannot open hdf5 file " + filePath.string());
     }
+    ThreadStatistics().metadataQueries++;
     auto status = H5Oget_info(locId, &information);
     if (status < 0) {
+        H5Fclose(locId);
         throw std::runtime_error("cannot get root object " + filePath.string());
     }
 }
 
-petscXdmfGenerator::HdfObject::HdfObject(std::shared_ptr<HdfObject> parent, H5O_info_t information, std::string name) : parent(parent), name(name), information(information) {
-    // Open the location
-    locId = H5Oopen_by_addr(parent->locId, information.addr);
-    if (locId < 0) {
-        throw std::runtime_error("unable to open hdf5 object");
+petscXdmfGenerator::HdfObject::HdfObject(hid_t fileOrGroupId)
+    : parent(nullptr), name(CheckedFileName(fileOrGroupId)), path(GroupPath(fileOrGroupId)), locId(fileOrGroupId), ownsId(false) {
+    ThreadStatistics().metadataQueries++;
+    auto status = H5Oget_info(locId, &information);
+    if (status < 0) {
+        throw std::runtime_error("cannot get root object " + name);
     }
 }
 
+petscXdmfGenerator::HdfObject::HdfObject(HdfObject *parent, std::string name, H5O_info_t information, bool openByAddress)
+    : parent(parent), name(name), path(parent->path + "/" + name), openByAddress(openByAddress), information(information) {}
+
 petscXdmfGenerator::HdfObject::~HdfObject() {
+    // close the children before their parent
+    children.clear();
     if (parent) {
-        H5Oclose(locId);
-    } else {
+        if (locId >= 0) {
+            H5Oclose(locId);
+        }
+    } else if (ownsId) {
         H5Fclose(locId);
     }
 }
 
-std::shared_ptr<petscXdmfGenerator::HdfObject> petscXdmfGenerator::HdfObject::Get(std::string name) {
-    H5O_info_t information;
-    auto err = H5Oget_info_by_name(locId, name.c_str(), &information, H5P_DEFAULT);
-    if (err < 0) {
-        return nullptr;
-    } else {
-        return std::shared_ptr<HdfObject>(new HdfObject(shared_from_this(), information, name));
+petscXdmfGenerator::HdfObject::Statistics &petscXdmfGenerator::HdfObject::ThreadStatistics() {
+    static thread_local Statistics statistics;
+    return statistics;
+}
+
+std::mutex &petscXdmfGenerator::HdfObject::LibraryMutex() {
+    static std::mutex libraryMutex;
+    return libraryMutex;
+}
+
+const petscXdmfGenerator::HdfObject &petscXdmfGenerator::HdfObject::Root() const { return parent ? parent->Root() : *this; }
+
+void petscXdmfGenerator::HdfObject::Refresh() const {
+#if H5_VERSION_GE(1, 10, 0)
+    if (refreshed || Type() != H5O_TYPE_DATASET || !Root().swmrRead) {
+        return;
     }
+    ThreadStatistics().metadataQueries++;
+    if (H5Drefresh(Id()) < 0) {
+        throw std::runtime_error("cannot refresh dataset " + path);
+    }
+    refreshed = true;
+#endif
 }
 
-struct listDataContext {
-    std::vector<std::shared_ptr<petscXdmfGenerator::HdfObject>> childrenList;
-    std::shared_ptr<petscXdmfGenerator::HdfObject> parent;
-};
+petscXdmfGenerator::HdfObject *petscXdmfGenerator::HdfObject::Lookup(const std::string &name) const {
+    // check for a previous lookup
+    if (auto cached = children.find(name); cached != children.end()) {
+        return cached->second.get();
+    }
 
-herr_t petscXdmfGenerator::HdfObject::addChildToList(hid_t locId, const char *name, const H5L_info_t *info, void *operator_data) {
-    // get the children list
-    auto context = (listDataContext *)operator_data;
+    ThreadStatistics().linkChecks++;
+    auto linkCheck = H5Lexists(Id(), name.c_str(), H5P_DEFAULT);
+    if (linkCheck < 0) {
+        throw std::runtime_error("cannot check link " + name + " in " + this->name);
+    } else if (linkCheck == 0) {
+        children[name] = nullptr;
+        return nullptr;
+    }
+
+    // Check to see if the link is an object
+    ThreadStatistics().linkChecks++;
+    auto objectCheck = H5Oexists_by_name(Id(), name.c_str(), H5P_DEFAULT);
+    if (objectCheck < 0) {
+        throw std::runtime_error("cannot check object " + name + " in " + this->name);
+    } else if (objectCheck == 0) {
+        children[name] = nullptr;
+        return nullptr;
+    }
 
-    H5O_info_t information;
-    auto err = H5Oget_info_by_name(locId, name, &information, H5P_DEFAULT);
+    return AddChild(name, false);
+}
+
+petscXdmfGenerator::HdfObject *petscXdmfGenerator::HdfObject::AddChild(const std::string &name, bool openByAddress) const {
+    H5O_info_t childInformation;
+    auto err = GetBasicInformation(Id(), name.c_str(), &childInformation);
+    auto &child = children[name];
     if (err >= 0) {
-        context->childrenList.push_back(std::shared_ptr<petscXdmfGenerator::HdfObject>(new petscXdmfGenerator::HdfObject(context->parent, information, name)));
+        child.reset(new HdfObject(const_cast<HdfObject *>(this), name, childInformation, openByAddress));
+    }
+    return child.get();
+}
+
+hid_t petscXdmfGenerator::HdfObject::Id() const {
+    if (locId < 0) {
+        // Open the location
+        ThreadStatistics().opens++;
+        locId = openByAddress ? H5Oopen_by_addr(parent->Id(), information.addr) : H5Oopen(parent->Id(), name.c_str(), H5P_DEFAULT);
+        if (locId < 0) {
+            throw std::runtime_error("unable to open hdf5 object " + path);
+        }
+    }
+    return locId;
+}
+
+std::shared_ptr<petscXdmfGenerator::HdfObject> petscXdmfGenerator::HdfObject::Get(std::string name) {
+    auto child = Lookup(name);
+    if (!child) {
+        return nullptr;
     }
-    return err;
+
+    // share ownership with the root so the whole file stays open while the child is in use
+    return std::shared_ptr<HdfObject>(const_cast<HdfObject &>(Root()).shared_from_this(), child);
+}
+
+herr_t petscXdmfGenerator::HdfObject::addChildToList(hid_t locId, const char *name, const H5L_info_t *info, void *operator_data) {
+    // get the children list
+    auto childrenNames = (std::vector<std::string> *)operator_data;
+    childrenNames->push_back(name);
+    return 0;
 }
 
 std::vector<std::shared_ptr<petscXdmfGenerator::HdfObject>> petscXdmfGenerator::HdfObject::Items() {
-    listDataContext context{.childrenList = {}, .parent = shared_from_this()};
+    std::vector<std::string> childrenNames;
 
     // march over each child
-    auto status = H5Lvisit(locId, H5_INDEX_NAME, H5_ITER_NATIVE, addChildToList, &context);
+    ThreadStatistics().iterations++;
+    auto status = H5Lvisit(Id(), H5_INDEX_NAME, H5_ITER_NATIVE, addChildToList, &childrenNames);
     if (status < 0) {
         throw std::runtime_error("cannot traverse items in " + name);
     }
 
-    return context.childrenList;
+    // open each child through the cache
+    std::vector<std::shared_ptr<HdfObject>> childrenList;
+    for (const auto &childName : childrenNames) {
+        if (auto child = Get(childName)) {
+            childrenList.push_back(child);
+        }
+    }
+    return childrenList;
+}
+
+herr_t petscXdmfGenerator::HdfObject::addDirectChildToList(hid_t locId, const char *name, const H5L_info_t *info, void *operator_data) {
+    // get the children list
+    auto childrenNames = (std::vector<std::pair<std::string, bool>> *)operator_data;
+    childrenNames->emplace_back(name, info->type == H5L_TYPE_HARD);
+    return 0;
 }
 
-bool petscXdmfGenerator::HdfObject::Contains(std::string name) const {
-    auto linkCheck = H5Lexists(locId, name.c_str(), H5P_DEFAULT);
-    if (linkCheck < 0) {
-        throw std::runtime_error("cannot check link " + name + " in " + this->name);
-    } else if (linkCheck == 0) {
-        return false;
+std::vector<std::shared_ptr<petscXdmfGenerator::HdfObject>> petscXdmfGenerator::HdfObject::Children() {
+    std::vector<std::pair<std::string, bool>> childrenNames;
+
+    // march over only the direct children
+    ThreadStatistics().iterations++;
+    auto status = H5Literate(Id(), H5_INDEX_NAME, H5_ITER_NATIVE, nullptr, addDirectChildToList, &childrenNames);
+    if (status < 0) {
+        throw std::runtime_error("cannot iterate children in " + name);
     }
 
-    // Check to see if the link is an object
-    auto objectCheck = H5Oexists_by_name(locId, name.c_str(), H5P_DEFAULT);
-    if (objectCheck < 0) {
-        throw std::runtime_error("cannot check object " + name + " in " + this->name);
-    } else if (objectCheck == 0) {
-        return false;
-    } else {
-        return true;
+    // add each child to the cache without opening it
+    auto root = const_cast<HdfObject &>(Root()).shared_from_this();
+    std::vector<std::shared_ptr<HdfObject>> childrenList;
+    for (const auto &[childName, hardLink] : childrenNames) {
+        auto cached = children.find(childName);
+        auto child = cached != children.end() ? cached->second.get() : AddChild(childName, hardLink);
+        if (child) {
+            childrenList.emplace_back(root, child);
+        }
     }
+    return childrenList;
 }
 
+bool petscXdmfGenerator::HdfObject::Contains(std::string name) const { return Lookup(name) != nullptr; }
+
 namespace petscXdmfGenerator {
 std::ostream &operator<<(std::ostream &os, const petscXdmfGenerator::HdfObject &object) {
     os << object.name << ": " << object.TypeName();
@@ -101,23 +254,15 @@ std::ostream &operator<<(std::ostream &os, const petscXdmfGenerator::HdfObject &
 
 std::string petscXdmfGenerator::HdfObject::TypeName() const { return h50bjectTypes.count(Type()) > 0 ? h50bjectTypes.at(Type()) : h50bjectTypes.at(H5O_TYPE_UNKNOWN); }
 
-std::string petscXdmfGenerator::HdfObject::Path() const {
-    std::string path = "";
-    if (parent) {
-        path = parent->Path() + "/";
-        path += name;
-    }
-
-    return path;
-}
-
 std::vector<hsize_t> petscXdmfGenerator::HdfObject::Shape() const {
     if (Type() != H5O_TYPE_DATASET) {
         throw std::runtime_error("Shape can only be called on H5O_TYPE_DATASET objects");
     }
 
     // get the object as a dataspace
-    auto dataspace = H5Dget_space(locId); /* dataspace handle */
+    Refresh();
+    ThreadStatistics().metadataQueries++;
+    auto dataspace = H5Dget_space(Id()); /* dataspace handle */
     const auto ndims = H5Sget_simple_extent_ndims(dataspace);
 
     // prepare the shape vector
@@ -129,9 +274,85 @@ std::vector<hsize_t> petscXdmfGenerator::HdfObject::Shape() const {
     return shape;
 }
 
+petscXdmfGenerator::HdfObject::DataTypeInformation petscXdmfGenerator::HdfObject::DataType() const {
+    if (Type() != H5O_TYPE_DATASET) {
+        throw std::runtime_error("DataType can only be called on H5O_TYPE_DATASET objects");
+    }
+
+    ThreadStatistics().metadataQueries++;
+    auto dataType = H5Dget_type(Id());
+    if (dataType < 0) {
+        throw std::runtime_error("cannot obtain data type for " + path);
+    }
+    DataTypeInformation information{.typeClass = H5Tget_class(dataType), .size = H5Tget_size(dataType)};
+    if (information.typeClass == H5T_INTEGER) {
+        information.isSigned = H5Tget_sign(dataType) == H5T_SGN_2;
+    }
+    H5Tclose(dataType);
+
+    return information;
+}
+
+petscXdmfGenerator::HdfObject::StorageLayout petscXdmfGenerator::HdfObject::Layout() const {
+    if (Type() != H5O_TYPE_DATASET) {
+        throw std::runtime_error("Layout can only be called on H5O_TYPE_DATASET objects");
+    }
+
+    ThreadStatistics().metadataQueries++;
+    auto properties = H5Dget_create_plist(Id());
+    if (properties < 0) {
+        throw std::runtime_error("cannot obtain creation properties for " + path);
+    }
+    StorageLayout storage{.layout = H5Pget_layout(properties)};
+    if (storage.layout == H5D_CHUNKED) {
+        storage.chunk.resize(H5S_MAX_RANK);
+        storage.chunk.resize(std::max(H5Pget_chunk(properties, H5S_MAX_RANK, storage.chunk.data()), 0));
+    }
+    for (int f = 0; f < H5Pget_nfilters(properties); f++) {
+        unsigned int flags;
+        std::size_t numberOfValues = 0;
+        storage.filters.push_back(H5Pget_filter2(properties, (unsigned)f, &flags, &numberOfValues, nullptr, 0, nullptr, nullptr));
+    }
+    H5Pclose(properties);
+
+    return storage;
+}
+
+uint64_t petscXdmfGenerator::HdfObject::ContentHash(hsize_t sampledRows) const {
+    const auto shape = Shape();
+    const auto dataType = DataType();
+    Hash hash;
+    hash.Add((int)dataType.typeClass).Add(dataType.size).Add(shape.size());
+    for (const auto extent : shape) {
+        hash.Add(extent);
+    }
+    if (shape.empty() || shape.front() == 0 || sampledRows == 0) {
+        return hash.Value();
+    }
+
+    // the values are compared as doubles, which holds every integer index exactly
+    const auto rows = shape.front();
+    std::vector<hsize_t> starts = {0};
+    if (rows > sampledRows) {
+        starts.push_back((rows - sampledRows) / 2);
+        starts.push_back(rows - sampledRows);
+    }
+    std::vector<hsize_t> start(shape.size(), 0);
+    std::vector<hsize_t> count(shape);
+    count.front() = std::min(rows, sampledRows);
+    std::vector<double> block(std::accumulate(count.begin(), count.end(), (hsize_t)1, std::multiplies<>()));
+    for (const auto first : starts) {
+        start.front() = first;
+        RawData(block.data(), start, count);
+        hash.Add(block.data(), block.size() * sizeof(double));
+    }
+    return hash.Value();
+}
+
 bool petscXdmfGenerator::HdfObject::HasAttribute(std::string name) const {
     // Check to see if the link is an attribute
-    auto objectCheck = H5Aexists_by_name(locId, ".", name.c_str(), H5P_DEFAULT);
+    ThreadStatistics().attributeChecks++;
+    auto objectCheck = H5Aexists_by_name(Id(), ".", name.c_str(), H5P_DEFAULT);
     if (objectCheck < 0) {
         throw std::runtime_error("cannot check attribute " + name + " in " + this->name);
     } else if (objectCheck == 0) {
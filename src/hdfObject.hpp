@@ -3,9 +3,15 @@
 
 #define H5_USE_18_API_DEFAULT
 #include <hdf5.h>
+#include <algorithm>
+#include <cstdint>
 #include <filesystem>
+#include <functional>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
 #include <string>
 #include <typeindex>
 #include <typeinfo>
@@ -14,11 +20,29 @@
 namespace petscXdmfGenerator {
 class HdfObject : public std::enable_shared_from_this<HdfObject> {
    private:
-    const std::shared_ptr<HdfObject> parent = nullptr;
+    // children are owned by their parent so the parent is always valid
+    HdfObject *const parent = nullptr;
     const std::string name = "";
-    hid_t locId;
+    const std::string path = "";
+
+    // children are opened on first use, by address when the address is known from the link or by name otherwise
+    mutable hid_t locId = -1;
+    const bool openByAddress = false;
+
+    // the root id is closed with this object unless it was provided by the caller
+    const bool ownsId = true;
+
+    // the file is opened for single writer multiple reader access and each dataset is refreshed once before use
+    const bool swmrRead = false;
+    mutable bool refreshed = false;
     H5O_info_t information;
 
+    // each child is opened once and kept until this object is closed, missing children are stored as nullptr
+    mutable std::map<std::string, std::unique_ptr<HdfObject>> children;
+
+    // raw data that has been read once and shared, by requested type
+    mutable std::map<std::type_index, std::shared_ptr<const void>> sharedRawData;
+
     inline static std::map<std::type_index, hid_t> nativeHdfTypes = {{typeid(char), H5T_NATIVE_CHAR},
                                                                      {typeid(signed char), H5T_NATIVE_SCHAR},
                                                                      {typeid(unsigned int), H5T_NATIVE_UCHAR},
@@ -46,31 +70,127 @@ class HdfObject : public std::enable_shared_from_this<HdfObject> {
      */
     static herr_t addChildToList(hid_t locId, const char *name, const H5L_info_t *info, void *operator_data);
 
+    /**
+     * Static method passed into the hdf5 library to add each direct child to the children list
+     * @param locId
+     * @param name
+     * @param info
+     * @param operator_data
+     * @return
+     */
+    static herr_t addDirectChildToList(hid_t locId, const char *name, const H5L_info_t *info, void *operator_data);
+
+    /**
+     * Stores an unopened child using only the basic object information (type and address)
+     * @param name
+     * @param openByAddress
+     * @return the child or nullptr if the object information is not available
+     */
+    HdfObject *AddChild(const std::string &name, bool openByAddress) const;
+
+    /**
+     * Gets the hdf5 id for this object, opening it on first use
+     * @return
+     */
+    hid_t Id() const;
+
+    /**
+     * Finds (and opens on the first request) the named child
+     * @param name
+     * @return the child or nullptr if there is no object with that name
+     */
+    HdfObject *Lookup(const std::string &name) const;
+
+    /**
+     * The root file object that owns every node
+     * @return
+     */
+    const HdfObject &Root() const;
+
+    /**
+     * Updates the extent of a dataset that may still be growing the first time it is used, so that every query in a
+     * conversion sees the same extent
+     */
+    void Refresh() const;
+
    protected:
-    HdfObject(std::shared_ptr<HdfObject> parent, H5O_info_t information, std::string name);
+    HdfObject(HdfObject *parent, std::string name, H5O_info_t information, bool openByAddress);
 
    public:
-    HdfObject(std::filesystem::path filePath);
+    /**
+     * Counts the hdf5 calls made by every HdfObject on a single thread
+     */
+    struct Statistics {
+        // files and objects opened (H5Fopen, H5Oopen)
+        uint64_t opens = 0;
+        // object information, dataspace, and type queries (H5Oget_info, H5Dget_space, H5Dget_type)
+        uint64_t metadataQueries = 0;
+        // link and object existence checks (H5Lexists, H5Oexists_by_name)
+        uint64_t linkChecks = 0;
+        // iterations over the links in a group (H5Literate, H5Lvisit)
+        uint64_t iterations = 0;
+        // attribute existence checks (H5Aexists_by_name) and reads (H5Aopen_name)
+        uint64_t attributeChecks = 0;
+        uint64_t attributeReads = 0;
+        // dataset reads (H5Dread) and the number of bytes read
+        uint64_t datasetReads = 0;
+        uint64_t bytesRead = 0;
+    };
+
+    /**
+     * The counters for the calling thread.  The hdf5 calls for a conversion are all made on the thread that reads the
+     * file, so the difference between two snapshots is the work done by that conversion.
+     * @return
+     */
+    static Statistics &ThreadStatistics();
+
+    /**
+     * Opens the file read only
+     * @param filePath
+     * @param swmrRead open for single writer multiple reader access so that a file still being written (in swmr mode)
+     * can be read, the extent of each dataset is refreshed before it is used
+     */
+    explicit HdfObject(std::filesystem::path filePath, bool swmrRead = false);
+
+    /**
+     * Wraps a file or group that is already open (for instance by PETSc) without taking ownership.  The id is never
+     * closed and must stay open while this object is in use; any object opened below it is closed with this object.
+     * @param fileOrGroupId
+     */
+    explicit HdfObject(hid_t fileOrGroupId);
     ~HdfObject();
 
+    /**
+     * The hdf5 library is usually built without thread safety, so any HdfObject use from more than one thread
+     * (including destruction) must hold this lock
+     * @return
+     */
+    static std::mutex &LibraryMutex();
+
     inline H5O_type_t Type() const { return information.type; }
 
     std::string TypeName() const;
 
     /**
-     * Simple function to get child node
+     * Simple function to get child node.  The returned node keeps the file open.
      * @param name
      * @return
      */
     std::shared_ptr<HdfObject> Get(std::string name);
 
     /**
-     * Get all of the child items
+     * Get all of the child items, recursively
      * @param name
      * @return
      */
     std::vector<std::shared_ptr<HdfObject>> Items();
 
+    /**
+     * Get only the direct children in name order.  The children are not opened until they are used.
+     * @return
+     */
+    std::vector<std::shared_ptr<HdfObject>> Children();
+
     /**
      * Simple function to get child node
      * @param name
@@ -88,7 +208,7 @@ class HdfObject : public std::enable_shared_from_this<HdfObject> {
      * Get the path to the current node from root
      * @return
      */
-    std::string Path() const;
+    const std::string &Path() const { return path; }
 
     /**
      * Gets the shape for a dataset
@@ -96,6 +216,46 @@ class HdfObject : public std::enable_shared_from_this<HdfObject> {
      */
     std::vector<hsize_t> Shape() const;
 
+    /**
+     * The class, size, and sign of the values stored in a dataset
+     */
+    struct DataTypeInformation {
+        H5T_class_t typeClass = H5T_NO_CLASS;
+        std::size_t size = 0;
+        bool isSigned = false;
+    };
+
+    /**
+     * Gets the stored (file) type of a dataset
+     * @return
+     */
+    DataTypeInformation DataType() const;
+
+    /**
+     * How the values in a dataset are stored
+     */
+    struct StorageLayout {
+        H5D_layout_t layout = H5D_CONTIGUOUS;
+        // the shape of each chunk, empty unless the dataset is chunked
+        std::vector<hsize_t> chunk;
+        // the filters (such as deflate) applied to each chunk
+        std::vector<H5Z_filter_t> filters;
+    };
+
+    /**
+     * Gets the layout, chunk shape, and filters from the creation properties of a dataset
+     * @return
+     */
+    StorageLayout Layout() const;
+
+    /**
+     * Computes a cheap fingerprint of a dataset from its shape, type, and a few blocks of leading-dimension rows
+     * (the first, middle, and last), so that large datasets can be compared without reading them completely
+     * @param sampledRows the number of rows read in each block
+     * @return
+     */
+    uint64_t ContentHash(hsize_t sampledRows = 64) const;
+
     /**
      * Checks to see if this object hold an attirbute
      * @param name
@@ -112,7 +272,8 @@ class HdfObject : public std::enable_shared_from_this<HdfObject> {
     template <typename T>
     T Attribute(std::string name) const {
         // get the attribute
-        auto attLocation = H5Aopen_name(locId, name.c_str());
+        ThreadStatistics().attributeReads++;
+        auto attLocation = H5Aopen_name(Id(), name.c_str());
         if (attLocation < 0) {
             throw std::invalid_argument("unable to find " + name + " on object " + name);
         }
@@ -138,7 +299,8 @@ class HdfObject : public std::enable_shared_from_this<HdfObject> {
      */
     std::string AttributeString(std::string name) const {
         // get the attribute
-        auto attLocation = H5Aopen_name(locId, name.c_str());
+        ThreadStatistics().attributeReads++;
+        auto attLocation = H5Aopen_name(Id(), name.c_str());
         if (attLocation < 0) {
             throw std::invalid_argument("unable to find " + name + " on object " + name);
         }
@@ -148,42 +310,30 @@ class HdfObject : public std::enable_shared_from_this<HdfObject> {
         auto sdim = H5Tget_size(filetype);
         sdim++; /* Make room for null terminator */
 
-        /*
-         * Get dataspace and allocate memory for read buffer.  This is a
-         * two dimensional attribute so the dynamic allocation must be done
-         * in steps.
-         */
+        // scalar attributes hold a single string
         auto space = H5Aget_space(attLocation);
-        hsize_t dims[1] = {0};
-        H5Sget_simple_extent_dims(space, dims, NULL);
-
-        // define and allocate the read buffer
-        // Allocate array of pointers to rows.
-        char **rdata = (char **)malloc(dims[0] * sizeof(char *));
-        // Allocate space for integer data.
-        rdata[0] = (char *)malloc(dims[0] * sdim * sizeof(char));
-
-        // Set the rest of the pointers to rows to the correct addresses.
-        for (hsize_t i = 1; i < dims[0]; i++) {
-            rdata[i] = rdata[0] + i * sdim;
-        }
+        const auto numberOfStrings = std::max<hssize_t>(H5Sget_simple_extent_npoints(space), 1);
+
+        // define and allocate the read buffer, one null terminated row per string
+        std::vector<char> rdata(numberOfStrings * sdim, '\0');
 
         // Create the memory datatype.
         auto memtype = H5Tcopy(H5T_C_S1);
         auto status = H5Tset_size(memtype, sdim);
 
         // read the data
-        status = H5Aread(attLocation, memtype, rdata[0]);
+        status = H5Aread(attLocation, memtype, rdata.data());
         if (status < 0) {
+            H5Aclose(attLocation);
+            H5Tclose(memtype);
+            H5Sclose(space);
+            H5Tclose(filetype);
             throw std::runtime_error("cannot obtain attribute " + name);
         }
 
-        std::string data(rdata[0]);
+        std::string data(rdata.data());
 
         // cleanup
-        free(rdata[0]);
-        free(rdata);
-
         H5Aclose(attLocation);
         H5Tclose(memtype);
         H5Sclose(space);
@@ -204,7 +354,8 @@ class HdfObject : public std::enable_shared_from_this<HdfObject> {
         }
 
         // get the object as a dataspace
-        auto dataspace = H5Dget_space(locId); /* dataspace handle */
+        Refresh();
+        auto dataspace = H5Dget_space(Id()); /* dataspace handle */
         const auto size = H5Sget_simple_extent_npoints(dataspace);
 
         // get the requestedType
@@ -213,16 +364,77 @@ class HdfObject : public std::enable_shared_from_this<HdfObject> {
         // prepare data vector
         std::vector<T> data(size);
 
-        auto status = H5Dread(locId, requestedType, H5S_ALL, H5S_ALL, H5P_DEFAULT, &data[0]);
+        auto status = H5Dread(Id(), requestedType, H5S_ALL, H5S_ALL, H5P_DEFAULT, &data[0]);
         if (status < 0) {
             throw std::runtime_error("cannot obtain raw data for " + name);
         }
+        ThreadStatistics().datasetReads++;
+        ThreadStatistics().bytesRead += size * sizeof(T);
 
         H5Sclose(dataspace);
 
         return data;
     }
 
+    /**
+     * Reads a hyperslab of the dataset into the caller supplied buffer without any extra allocation
+     * @tparam T
+     * @param buffer must hold the product of count values
+     * @param start the first index in each dimension
+     * @param count the number of values in each dimension
+     * @param stride the step in each dimension, defaults to one
+     */
+    template <typename T>
+    void RawData(T *buffer, const std::vector<hsize_t> &start, const std::vector<hsize_t> &count, const std::vector<hsize_t> &stride = {}) const {
+        if (Type() != H5O_TYPE_DATASET) {
+            throw std::runtime_error("RawData can only be called on H5O_TYPE_DATASET objects");
+        }
+
+        // select the hyperslab in the file
+        Refresh();
+        auto dataspace = H5Dget_space(Id()); /* dataspace handle */
+        const auto ndims = H5Sget_simple_extent_ndims(dataspace);
+        if (start.size() != (std::size_t)ndims || count.size() != (std::size_t)ndims || (!stride.empty() && stride.size() != (std::size_t)ndims)) {
+            H5Sclose(dataspace);
+            throw std::invalid_argument("the hyperslab for " + path + " must match the " + std::to_string(ndims) + " dimensions of the dataset");
+        }
+        auto status = H5Sselect_hyperslab(dataspace, H5S_SELECT_SET, start.data(), stride.empty() ? NULL : stride.data(), count.data(), NULL);
+        if (status < 0) {
+            H5Sclose(dataspace);
+            throw std::invalid_argument("invalid hyperslab for " + path);
+        }
+
+        // the buffer is a contiguous block of the selected values
+        auto memspace = H5Screate_simple(ndims, count.data(), NULL);
+
+        // get the requestedType
+        auto requestedType = nativeHdfTypes[typeid(T)];
+
+        status = H5Dread(Id(), requestedType, memspace, dataspace, H5P_DEFAULT, buffer);
+        H5Sclose(memspace);
+        H5Sclose(dataspace);
+        if (status < 0) {
+            throw std::runtime_error("cannot obtain raw data for " + path);
+        }
+        ThreadStatistics().datasetReads++;
+        ThreadStatistics().bytesRead += std::accumulate(count.begin(), count.end(), (hsize_t)1, std::multiplies<>()) * sizeof(T);
+    }
+
+    /**
+     * Gets the raw data as a flattened array that is read once and shared by every caller, for datasets such
+     * as time that are used by more than one grid
+     * @tparam T
+     * @return
+     */
+    template <typename T>
+    std::shared_ptr<const std::vector<T>> SharedRawData() const {
+        auto &cached = sharedRawData[typeid(T)];
+        if (!cached) {
+            cached = std::make_shared<const std::vector<T>>(RawData<T>());
+        }
+        return std::static_pointer_cast<const std::vector<T>>(cached);
+    }
+
     /**
      * Provide simple function for outputing to stream
      * @param os
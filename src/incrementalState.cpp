@@ -0,0 +1,213 @@
+#include "incrementalState.hpp"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include "hash.hpp"
+
+using namespace petscXdmfGenerator;
+
+static const auto StateHeader = "petscXdmfGenerator-incremental 1";
+
+std::string petscXdmfGenerator::IncrementalState::JoinShapeTail(const std::vector<unsigned long long>& shape) {
+    std::string joined;
+    for (std::size_t i = 1; i < shape.size(); i++) {
+        joined += (i > 1 ? " " : "") + std::to_string(shape[i]);
+    }
+    return joined;
+}
+
+void petscXdmfGenerator::IncrementalState::AddToSignature(Hash& signature, const XdmfSpecification::FieldDescription& field) {
+    signature.Add(field.name).Add(field.path).Add(field.shape.size());
+    // the time extent is the only part of the shape that may grow
+    for (std::size_t i = field.HasTimeDimension() ? 1 : 0; i < field.shape.size(); i++) {
+        signature.Add(field.shape[i]);
+    }
+    signature.Add(field.componentDimension).Add((int)field.fieldLocation).Add((int)field.fieldType);
+    signature.Add((int)field.dataType.numberType).Add(field.dataType.precision);
+    for (const auto& component : field.components) {
+        signature.Add(component.name).Add(component.offset);
+    }
+    // the summaries of existing steps do not change, but adding or removing them changes every step
+    signature.Add(field.summaries.empty());
+}
+
+void petscXdmfGenerator::IncrementalState::AddToSignature(Hash& signature, const XdmfSpecification::TopologyDescription& topology) {
+    signature.Add(topology.path).Add(topology.number).Add(topology.numberCorners).Add(topology.dimension);
+    signature.Add((int)topology.dataType.numberType).Add(topology.dataType.precision);
+}
+
+uint64_t petscXdmfGenerator::IncrementalState::OptionsSignature(const GenerateOptions& options) {
+    // the selection decides which fields, times, and grids each step holds
+    Hash signature;
+    for (const auto* patterns : {&options.includeFields, &options.excludeFields}) {
+        signature.Add(patterns->size());
+        for (const auto& pattern : *patterns) {
+            signature.Add(pattern);
+        }
+    }
+    signature.Add(options.timeBegin).Add(options.timeEnd).Add(options.timeStride);
+    signature.Add(options.particleLevelsOfDetail.size());
+    for (const auto pointStride : options.particleLevelsOfDetail) {
+        signature.Add(pointStride);
+    }
+
+    // the existing steps are copied as written, so they must be formatted and summarized the same way as the new steps
+    signature.Add(options.compactOutput).Add(options.timeReferenceThreshold).Add(options.fieldSummaries);
+    return signature.Value();
+}
+
+uint64_t petscXdmfGenerator::IncrementalState::HashTime(const std::vector<double>& time, std::size_t count) {
+    Hash hash;
+    for (std::size_t t = 0; t < count && t < time.size(); t++) {
+        hash.Add(time[t]);
+    }
+    return hash.Value();
+}
+
+IncrementalState petscXdmfGenerator::IncrementalState::FromSpecification(const XdmfSpecification& specification, const std::filesystem::path& inputFilePath, const GenerateOptions& options) {
+    IncrementalState state;
+    state.optionsSignature = OptionsSignature(options);
+    state.inputSize = std::filesystem::file_size(inputFilePath);
+    state.inputModified = std::filesystem::last_write_time(inputFilePath).time_since_epoch().count();
+
+    Hash signature;
+    signature.Add(specification.hdf5File);
+    for (const auto& grid : specification.grids) {
+        signature.Add(grid.name);
+        AddToSignature(signature, grid.topology);
+        AddToSignature(signature, grid.hybridTopology);
+        AddToSignature(signature, grid.geometry);
+        for (const auto& field : grid.fields) {
+            AddToSignature(signature, field);
+        }
+        // an empty time list and a single time produce different documents
+        signature.Add(grid.time.empty());
+        signature.Add(grid.timeStart);
+        signature.Add(grid.timeStride);
+        signature.Add(grid.pointStride);
+
+        GridState gridState{.name = grid.name, .timeCount = grid.time.size(), .timeHash = HashTime(grid.time, grid.time.size())};
+        if (grid.geometry.HasTimeDimension()) {
+            gridState.datasets.push_back(DatasetState{.timeExtent = grid.geometry.shape[0], .shape = JoinShapeTail(grid.geometry.shape)});
+        }
+        for (const auto& field : grid.fields) {
+            if (field.HasTimeDimension()) {
+                gridState.datasets.push_back(DatasetState{.timeExtent = field.shape[0], .shape = JoinShapeTail(field.shape)});
+            }
+        }
+        state.grids.push_back(gridState);
+    }
+    state.signature = signature.Value();
+
+    return state;
+}
+
+std::optional<IncrementalState> petscXdmfGenerator::IncrementalState::Read(const std::filesystem::path& statePath) {
+    std::ifstream stateFile(statePath);
+    if (!stateFile) {
+        return {};
+    }
+
+    std::string line;
+    if (!std::getline(stateFile, line) || line != StateHeader) {
+        return {};
+    }
+
+    IncrementalState state;
+    while (std::getline(stateFile, line)) {
+        std::istringstream lineStream(line);
+        std::string key;
+        lineStream >> key;
+        if (key == "input") {
+            lineStream >> state.inputSize >> state.inputModified;
+        } else if (key == "signature") {
+            lineStream >> state.signature;
+        } else if (key == "options") {
+            lineStream >> state.optionsSignature;
+        } else if (key == "grid") {
+            // the name is the rest of the line
+            GridState grid;
+            lineStream >> grid.timeCount >> grid.timeHash >> grid.stepsBegin >> grid.stepsEnd >> std::ws;
+            std::getline(lineStream, grid.name);
+            state.grids.push_back(grid);
+        } else if (key == "dataset" && !state.grids.empty()) {
+            DatasetState dataset;
+            lineStream >> dataset.timeExtent >> std::ws;
+            std::getline(lineStream, dataset.shape);
+            state.grids.back().datasets.push_back(dataset);
+        } else {
+            return {};
+        }
+        if (lineStream.fail()) {
+            return {};
+        }
+    }
+    return state;
+}
+
+void petscXdmfGenerator::IncrementalState::Write(const std::filesystem::path& statePath) const {
+    std::ofstream stateFile(statePath);
+    stateFile << StateHeader << '\n';
+    stateFile << "input " << inputSize << ' ' << inputModified << '\n';
+    stateFile << "signature " << signature << '\n';
+    stateFile << "options " << optionsSignature << '\n';
+    for (const auto& grid : grids) {
+        stateFile << "grid " << grid.timeCount << ' ' << grid.timeHash << ' ' << grid.stepsBegin << ' ' << grid.stepsEnd << ' ' << grid.name << '\n';
+        for (const auto& dataset : grid.datasets) {
+            stateFile << "dataset " << dataset.timeExtent << ' ' << dataset.shape << '\n';
+        }
+    }
+    if (!stateFile) {
+        throw std::runtime_error("unable to write incremental state " + statePath.string());
+    }
+}
+
+bool petscXdmfGenerator::IncrementalState::SameInput(const std::filesystem::path& inputFilePath) const {
+    std::error_code error;
+    auto size = std::filesystem::file_size(inputFilePath, error);
+    if (error) {
+        return false;
+    }
+    auto modified = std::filesystem::last_write_time(inputFilePath, error);
+    return !error && size == inputSize && modified.time_since_epoch().count() == inputModified;
+}
+
+bool petscXdmfGenerator::IncrementalState::SameOptions(const GenerateOptions& options) const { return optionsSignature == OptionsSignature(options); }
+
+bool petscXdmfGenerator::IncrementalState::GrewFrom(const IncrementalState& previous, const XdmfSpecification& specification) const {
+    if (signature != previous.signature || optionsSignature != previous.optionsSignature || grids.size() != previous.grids.size()) {
+        return false;
+    }
+
+    for (std::size_t g = 0; g < grids.size(); g++) {
+        const auto& grid = grids[g];
+        const auto& previousGrid = previous.grids[g];
+
+        // there must be an existing time collection to add to, holding the same times
+        if (grid.name != previousGrid.name || previousGrid.stepsBegin < 0 || grid.timeCount < previousGrid.timeCount || grid.datasets.size() != previousGrid.datasets.size()) {
+            return false;
+        }
+        if (HashTime(specification.grids[g].time, previousGrid.timeCount) != previousGrid.timeHash) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void petscXdmfGenerator::IncrementalState::SetSteps(const std::string& gridName, std::streampos begin, std::streampos end) {
+    for (auto& grid : grids) {
+        if (grid.name == gridName) {
+            grid.stepsBegin = begin;
+            grid.stepsEnd = end;
+        }
+    }
+}
+
+const IncrementalState::GridState& petscXdmfGenerator::IncrementalState::Grid(const std::string& gridName) const {
+    for (const auto& grid : grids) {
+        if (grid.name == gridName) {
+            return grid;
+        }
+    }
+    throw std::invalid_argument("unknown grid " + gridName);
+}
@@ -0,0 +1,142 @@
+#ifndef PETSCXDMFGENERATOR_INCREMENTALSTATE_HPP
+#define PETSCXDMFGENERATOR_INCREMENTALSTATE_HPP
+
+#include <filesystem>
+#include <ios>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "generators.hpp"
+#include "xdmfSpecification.hpp"
+
+namespace petscXdmfGenerator {
+class Hash;
+
+/**
+ * Remembers what was written for the previous build of a file so that the next build only needs to add the new
+ * time steps.  The state is stored in a small text file next to the xdmf file.
+ */
+class IncrementalState {
+   public:
+    struct DatasetState {
+        // the time extent of the dataset when written
+        unsigned long long timeExtent = 0;
+        // the rest of the dataset shape as written in the xdmf Dimensions
+        std::string shape;
+    };
+
+    struct GridState {
+        std::string name;
+        std::size_t timeCount = 0;
+        uint64_t timeHash = 0;
+
+        // the location of the time collection steps in the xdmf file (-1 if there is no time collection)
+        long long stepsBegin = -1;
+        long long stepsEnd = -1;
+
+        // each time dependent dataset in the grid, in the order they are found in the specification
+        std::vector<DatasetState> datasets;
+    };
+
+   private:
+    // identify the input file
+    std::uintmax_t inputSize = 0;
+    long long inputModified = 0;
+
+    // a hash of the specification ignoring the time extents
+    uint64_t signature = 0;
+
+    // a hash of the options that change the document written for the same input
+    uint64_t optionsSignature = 0;
+
+    std::vector<GridState> grids;
+
+    // hashes the first count time values
+    static uint64_t HashTime(const std::vector<double>& time, std::size_t count);
+
+    // helper functions to compute the signature
+    static void AddToSignature(Hash& signature, const XdmfSpecification::FieldDescription& field);
+    static void AddToSignature(Hash& signature, const XdmfSpecification::TopologyDescription& topology);
+    static uint64_t OptionsSignature(const GenerateOptions& options);
+
+    // the shape after the time extent, as written in the xdmf Dimensions
+    static std::string JoinShapeTail(const std::vector<unsigned long long>& shape);
+
+   public:
+    /**
+     * Computes the state for a specification extracted from the input file
+     * @param specification
+     * @param inputFilePath
+     * @param options the options the specification was selected and will be written with
+     * @return
+     */
+    static IncrementalState FromSpecification(const XdmfSpecification& specification, const std::filesystem::path& inputFilePath, const GenerateOptions& options);
+
+    /**
+     * Reads the state, returning nothing if it does not exist or cannot be read
+     * @param statePath
+     * @return
+     */
+    static std::optional<IncrementalState> Read(const std::filesystem::path& statePath);
+
+    /**
+     * Writes the state to the file
+     * @param statePath
+     */
+    void Write(const std::filesystem::path& statePath) const;
+
+    /**
+     * The default location of the state for an xdmf file
+     * @param outputFilePath
+     * @return
+     */
+    static std::filesystem::path StatePath(const std::filesystem::path& outputFilePath) { return outputFilePath.string() + ".state"; }
+
+    /**
+     * Checks if the input file still has the same size and modification time
+     * @param inputFilePath
+     * @return
+     */
+    bool SameInput(const std::filesystem::path& inputFilePath) const;
+
+    /**
+     * Checks if the options select and write the document the same way as when this state was computed
+     * @param options
+     * @return
+     */
+    bool SameOptions(const GenerateOptions& options) const;
+
+    /**
+     * Checks if this state only differs from the previous state by new time steps
+     * @param previous
+     * @param specification the specification this state was computed from
+     * @return
+     */
+    bool GrewFrom(const IncrementalState& previous, const XdmfSpecification& specification) const;
+
+    /**
+     * Records where the steps for a grid were written
+     * @param gridName
+     * @param begin
+     * @param end
+     */
+    void SetSteps(const std::string& gridName, std::streampos begin, std::streampos end);
+
+    /**
+     * Gets the state for each grid
+     * @return
+     */
+    const std::vector<GridState>& Grids() const { return grids; }
+
+    /**
+     * Gets the state for the named grid
+     * @param gridName
+     * @return
+     */
+    const GridState& Grid(const std::string& gridName) const;
+};
+}  // namespace petscXdmfGenerator
+
+#endif  // PETSCXDMFGENERATOR_INCREMENTALSTATE_HPP
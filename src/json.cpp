@@ -0,0 +1,468 @@
+#include "json.hpp"
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cmath>
+#include <iterator>
+#include <stdexcept>
+
+using namespace petscXdmfGenerator;
+
+static const char* KindName(JsonValue::Kind kind) {
+    switch (kind) {
+        case JsonValue::NUL:
+            return "null";
+        case JsonValue::BOOLEAN:
+            return "boolean";
+        case JsonValue::NUMBER:
+            return "number";
+        case JsonValue::STRING:
+            return "string";
+        case JsonValue::ARRAY:
+            return "array";
+        case JsonValue::OBJECT:
+            return "object";
+    }
+    return "unknown";
+}
+
+static void RequireKind(JsonValue::Kind kind, JsonValue::Kind expected) {
+    if (kind != expected) {
+        throw std::runtime_error(std::string("expected a json ") + KindName(expected) + " but found a " + KindName(kind));
+    }
+}
+
+petscXdmfGenerator::JsonValue::JsonValue(bool value) : kind(BOOLEAN), text(value ? "true" : "false") {}
+
+petscXdmfGenerator::JsonValue::JsonValue(double value) : kind(NUMBER) {
+    if (!std::isfinite(value)) {
+        throw std::invalid_argument("json cannot hold the number " + std::to_string(value));
+    }
+    // the shortest form that reads back as the same double
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    text.assign(buffer, result.ptr);
+}
+
+petscXdmfGenerator::JsonValue::JsonValue(unsigned long long value) : kind(NUMBER), text(std::to_string(value)) {}
+
+petscXdmfGenerator::JsonValue::JsonValue(std::string value) : kind(STRING), text(std::move(value)) {}
+
+JsonValue petscXdmfGenerator::JsonValue::Array() {
+    JsonValue array;
+    array.kind = ARRAY;
+    return array;
+}
+
+JsonValue petscXdmfGenerator::JsonValue::Object() {
+    JsonValue object;
+    object.kind = OBJECT;
+    return object;
+}
+
+JsonValue petscXdmfGenerator::JsonValue::Number(std::string text) {
+    JsonValue number;
+    number.kind = NUMBER;
+    number.text = std::move(text);
+    return number;
+}
+
+JsonValue& petscXdmfGenerator::JsonValue::Append(JsonValue value) {
+    RequireKind(kind, ARRAY);
+    elements.push_back(std::move(value));
+    return *this;
+}
+
+JsonValue& petscXdmfGenerator::JsonValue::Add(std::string key, JsonValue value) {
+    RequireKind(kind, OBJECT);
+    members.emplace_back(std::move(key), std::move(value));
+    return *this;
+}
+
+const JsonValue& petscXdmfGenerator::JsonValue::operator[](const std::string& key) const {
+    RequireKind(kind, OBJECT);
+    for (const auto& [memberKey, value] : members) {
+        if (memberKey == key) {
+            return value;
+        }
+    }
+    throw std::runtime_error("missing json member " + key);
+}
+
+bool petscXdmfGenerator::JsonValue::Contains(const std::string& key) const {
+    RequireKind(kind, OBJECT);
+    for (const auto& member : members) {
+        if (member.first == key) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const std::vector<JsonValue>& petscXdmfGenerator::JsonValue::Elements() const {
+    RequireKind(kind, ARRAY);
+    return elements;
+}
+
+const std::string& petscXdmfGenerator::JsonValue::String() const {
+    RequireKind(kind, STRING);
+    return text;
+}
+
+bool petscXdmfGenerator::JsonValue::Boolean() const {
+    RequireKind(kind, BOOLEAN);
+    return text == "true";
+}
+
+double petscXdmfGenerator::JsonValue::Double() const {
+    RequireKind(kind, NUMBER);
+    double value = 0;
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (result.ec != std::errc() || result.ptr != text.data() + text.size()) {
+        throw std::runtime_error("json number " + text + " is out of range");
+    }
+    return value;
+}
+
+unsigned long long petscXdmfGenerator::JsonValue::Unsigned() const {
+    RequireKind(kind, NUMBER);
+    unsigned long long value = 0;
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (result.ec != std::errc() || result.ptr != text.data() + text.size()) {
+        throw std::runtime_error("json number " + text + " is not an unsigned integer");
+    }
+    return value;
+}
+
+static void WriteString(std::ostream& stream, const std::string& value) {
+    static const char hexDigits[] = "0123456789abcdef";
+    stream << '"';
+    for (unsigned char character : value) {
+        switch (character) {
+            case '"':
+                stream << "\\\"";
+                break;
+            case '\\':
+                stream << "\\\\";
+                break;
+            case '\n':
+                stream << "\\n";
+                break;
+            case '\r':
+                stream << "\\r";
+                break;
+            case '\t':
+                stream << "\\t";
+                break;
+            default:
+                if (character < 0x20) {
+                    stream << "\\u00" << hexDigits[character >> 4] << hexDigits[character & 0xF];
+                } else {
+                    stream << (char)character;
+                }
+        }
+    }
+    stream << '"';
+}
+
+void petscXdmfGenerator::JsonValue::Write(std::ostream& stream, int depth) const {
+    const std::string indent((depth + 1) * 2, ' ');
+    switch (kind) {
+        case NUL:
+            stream << "null";
+            break;
+        case BOOLEAN:
+        case NUMBER:
+            stream << text;
+            break;
+        case STRING:
+            WriteString(stream, text);
+            break;
+        case ARRAY: {
+            // arrays of numbers (shapes and times) are kept on a single line
+            bool simple = true;
+            for (const auto& element : elements) {
+                simple = simple && element.kind != ARRAY && element.kind != OBJECT;
+            }
+            stream << '[';
+            for (std::size_t e = 0; e < elements.size(); e++) {
+                stream << (e ? "," : "");
+                if (simple) {
+                    stream << (e ? " " : "");
+                } else {
+                    stream << '\n' << indent;
+                }
+                elements[e].Write(stream, depth + 1);
+            }
+            if (!simple && !elements.empty()) {
+                stream << '\n' << std::string(depth * 2, ' ');
+            }
+            stream << ']';
+            break;
+        }
+        case OBJECT:
+            stream << '{';
+            for (std::size_t m = 0; m < members.size(); m++) {
+                stream << (m ? "," : "") << '\n' << indent;
+                WriteString(stream, members[m].first);
+                stream << ": ";
+                members[m].second.Write(stream, depth + 1);
+            }
+            if (!members.empty()) {
+                stream << '\n' << std::string(depth * 2, ' ');
+            }
+            stream << '}';
+            break;
+    }
+}
+
+namespace {
+// a recursive descent parser over the whole document
+class JsonParser {
+   private:
+    const std::string& document;
+    std::size_t position = 0;
+
+    // the objects and arrays being read, limited so that a deeply nested document fails instead of overflowing the stack
+    std::size_t depth = 0;
+    inline static const std::size_t MaximumDepth = 256;
+
+    [[noreturn]] void Fail(const std::string& message) const { throw std::runtime_error("invalid json at offset " + std::to_string(position) + ": " + message); }
+
+    void SkipWhitespace() {
+        while (position < document.size() && (document[position] == ' ' || document[position] == '\t' || document[position] == '\n' || document[position] == '\r')) {
+            position++;
+        }
+    }
+
+    bool Consume(char character) {
+        SkipWhitespace();
+        if (position < document.size() && document[position] == character) {
+            position++;
+            return true;
+        }
+        return false;
+    }
+
+    void Expect(char character) {
+        if (!Consume(character)) {
+            Fail(std::string("expected '") + character + "'");
+        }
+    }
+
+    void Nest() {
+        if (++depth > MaximumDepth) {
+            Fail("objects and arrays are nested more than " + std::to_string(MaximumDepth) + " deep");
+        }
+    }
+
+    void ExpectWord(const char* word) {
+        for (; *word; word++, position++) {
+            if (position >= document.size() || document[position] != *word) {
+                Fail("unexpected value");
+            }
+        }
+    }
+
+    static void AppendUtf8(std::string& value, uint32_t codePoint) {
+        if (codePoint < 0x80) {
+            value += (char)codePoint;
+        } else if (codePoint < 0x800) {
+            value += (char)(0xC0 | (codePoint >> 6));
+            value += (char)(0x80 | (codePoint & 0x3F));
+        } else if (codePoint < 0x10000) {
+            value += (char)(0xE0 | (codePoint >> 12));
+            value += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+            value += (char)(0x80 | (codePoint & 0x3F));
+        } else {
+            value += (char)(0xF0 | (codePoint >> 18));
+            value += (char)(0x80 | ((codePoint >> 12) & 0x3F));
+            value += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+            value += (char)(0x80 | (codePoint & 0x3F));
+        }
+    }
+
+    uint32_t ReadHex() {
+        uint32_t value = 0;
+        if (position + 4 > document.size()) {
+            Fail("incomplete unicode escape");
+        }
+        auto result = std::from_chars(document.data() + position, document.data() + position + 4, value, 16);
+        if (result.ptr != document.data() + position + 4) {
+            Fail("invalid unicode escape");
+        }
+        position += 4;
+        return value;
+    }
+
+    std::string ReadString() {
+        Expect('"');
+        std::string value;
+        while (true) {
+            if (position >= document.size()) {
+                Fail("unterminated string");
+            }
+            char character = document[position++];
+            if (character == '"') {
+                return value;
+            }
+            if ((unsigned char)character < 0x20) {
+                Fail("control character in string");
+            }
+            if (character != '\\') {
+                value += character;
+                continue;
+            }
+            if (position >= document.size()) {
+                Fail("unterminated string");
+            }
+            switch (document[position++]) {
+                case '"':
+                    value += '"';
+                    break;
+                case '\\':
+                    value += '\\';
+                    break;
+                case '/':
+                    value += '/';
+                    break;
+                case 'b':
+                    value += '\b';
+                    break;
+                case 'f':
+                    value += '\f';
+                    break;
+                case 'n':
+                    value += '\n';
+                    break;
+                case 'r':
+                    value += '\r';
+                    break;
+                case 't':
+                    value += '\t';
+                    break;
+                case 'u': {
+                    auto codePoint = ReadHex();
+                    // characters outside the basic plane are written as a surrogate pair
+                    if (codePoint >= 0xD800 && codePoint < 0xDC00 && document.compare(position, 2, "\\u") == 0) {
+                        position += 2;
+                        auto low = ReadHex();
+                        if (low < 0xDC00 || low >= 0xE000) {
+                            Fail("invalid surrogate pair");
+                        }
+                        codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    AppendUtf8(value, codePoint);
+                    break;
+                }
+                default:
+                    Fail("invalid escape");
+            }
+        }
+    }
+
+    std::string ReadNumber() {
+        const auto start = position;
+        auto digits = [this]() {
+            const auto first = position;
+            while (position < document.size() && std::isdigit((unsigned char)document[position])) {
+                position++;
+            }
+            return position - first;
+        };
+
+        if (position < document.size() && document[position] == '-') {
+            position++;
+        }
+        const auto integerStart = position;
+        if (digits() == 0 || (document[integerStart] == '0' && position - integerStart > 1)) {
+            Fail("invalid number");
+        }
+        if (position < document.size() && document[position] == '.') {
+            position++;
+            if (digits() == 0) {
+                Fail("invalid number");
+            }
+        }
+        if (position < document.size() && (document[position] == 'e' || document[position] == 'E')) {
+            position++;
+            if (position < document.size() && (document[position] == '+' || document[position] == '-')) {
+                position++;
+            }
+            if (digits() == 0) {
+                Fail("invalid number");
+            }
+        }
+        return document.substr(start, position - start);
+    }
+
+   public:
+    explicit JsonParser(const std::string& document) : document(document) {}
+
+    JsonValue ReadValue() {
+        SkipWhitespace();
+        if (position >= document.size()) {
+            Fail("unexpected end of document");
+        }
+        switch (document[position]) {
+            case '{': {
+                position++;
+                Nest();
+                auto object = JsonValue::Object();
+                if (!Consume('}')) {
+                    do {
+                        SkipWhitespace();
+                        auto key = ReadString();
+                        Expect(':');
+                        object.Add(std::move(key), ReadValue());
+                    } while (Consume(','));
+                    Expect('}');
+                }
+                depth--;
+                return object;
+            }
+            case '[': {
+                position++;
+                Nest();
+                auto array = JsonValue::Array();
+                if (!Consume(']')) {
+                    do {
+                        array.Append(ReadValue());
+                    } while (Consume(','));
+                    Expect(']');
+                }
+                depth--;
+                return array;
+            }
+            case '"':
+                return JsonValue(ReadString());
+            case 't':
+                ExpectWord("true");
+                return JsonValue(true);
+            case 'f':
+                ExpectWord("false");
+                return JsonValue(false);
+            case 'n':
+                ExpectWord("null");
+                return JsonValue();
+            default:
+                return JsonValue::Number(ReadNumber());
+        }
+    }
+
+    void ExpectEnd() {
+        SkipWhitespace();
+        if (position != document.size()) {
+            Fail("unexpected content after the document");
+        }
+    }
+};
+}  // namespace
+
+JsonValue petscXdmfGenerator::JsonValue::Read(std::istream& stream) {
+    const std::string document((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    JsonParser parser(document);
+    auto value = parser.ReadValue();
+    parser.ExpectEnd();
+    return value;
+}
@@ -0,0 +1,100 @@
+#ifndef PETSCXDMFGENERATOR_JSON_HPP
+#define PETSCXDMFGENERATOR_JSON_HPP
+
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace petscXdmfGenerator {
+/**
+ * A minimal json document used to read and write specifications.  Numbers keep their text so that integers larger
+ * than a double can hold and doubles written with the shortest round trip form are read back exactly.  Object members
+ * keep the order they were added or read in.
+ */
+class JsonValue {
+   public:
+    enum Kind { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+
+   private:
+    Kind kind = NUL;
+
+    // the value of a boolean, the text of a number, or the value of a string
+    std::string text;
+    std::vector<JsonValue> elements;
+    std::vector<std::pair<std::string, JsonValue>> members;
+
+    void Write(std::ostream& stream, int depth) const;
+
+   public:
+    JsonValue() = default;
+    JsonValue(bool value);
+    JsonValue(double value);
+    JsonValue(unsigned long long value);
+    JsonValue(std::string value);
+    JsonValue(const char* value) : JsonValue(std::string(value)) {}
+
+    static JsonValue Array();
+    static JsonValue Object();
+
+    /**
+     * A number from its text, which must already be a valid json number
+     * @param text
+     * @return
+     */
+    static JsonValue Number(std::string text);
+
+    Kind Type() const { return kind; }
+
+    /**
+     * Appends an element to an array
+     * @param value
+     * @return this array
+     */
+    JsonValue& Append(JsonValue value);
+
+    /**
+     * Adds a member to an object
+     * @param key
+     * @param value
+     * @return this object
+     */
+    JsonValue& Add(std::string key, JsonValue value);
+
+    /**
+     * Gets a member of an object, throwing if it is missing
+     * @param key
+     * @return
+     */
+    const JsonValue& operator[](const std::string& key) const;
+
+    /**
+     * Checks for a member of an object
+     * @param key
+     * @return
+     */
+    bool Contains(const std::string& key) const;
+
+    // typed access to the value, each throws if the value has a different type
+    const std::vector<JsonValue>& Elements() const;
+    const std::string& String() const;
+    bool Boolean() const;
+    double Double() const;
+    unsigned long long Unsigned() const;
+
+    /**
+     * Writes the value with two space indentation
+     * @param stream
+     */
+    void Write(std::ostream& stream) const { Write(stream, 0); }
+
+    /**
+     * Reads a single json value, throwing std::runtime_error if the document is not valid json
+     * @param stream
+     * @return
+     */
+    static JsonValue Read(std::istream& stream);
+};
+}  // namespace petscXdmfGenerator
+
+#endif  // PETSCXDMFGENERATOR_JSON_HPP
@@ -0,0 +1,251 @@
+#include "mpiGenerators.hpp"
+#include <chrono>
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include "fileDescriptorStream.hpp"
+#include "generatorSupport.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+static double SecondsSince(Clock::time_point start) { return std::chrono::duration<double>(Clock::now() - start).count(); }
+
+/**
+ * A counter stored on the root rank that any rank can atomically increment without the root taking part, used to hand
+ * out the next file to whichever rank is free
+ */
+class SharedCounter {
+   private:
+    MPI_Win window = MPI_WIN_NULL;
+    uint64_t* value = nullptr;
+
+   public:
+    explicit SharedCounter(MPI_Comm communicator) {
+        int rank;
+        MPI_Comm_rank(communicator, &rank);
+        MPI_Win_allocate(rank == 0 ? sizeof(uint64_t) : 0, sizeof(uint64_t), MPI_INFO_NULL, communicator, &value, &window);
+        if (rank == 0) {
+            MPI_Win_lock(MPI_LOCK_EXCLUSIVE, 0, 0, window);
+            *value = 0;
+            MPI_Win_unlock(0, window);
+        }
+        MPI_Barrier(communicator);
+    }
+    ~SharedCounter() { MPI_Win_free(&window); }
+
+    SharedCounter(const SharedCounter&) = delete;
+    void operator=(const SharedCounter&) = delete;
+
+    // returns the value before it was incremented
+    uint64_t Next() {
+        const uint64_t one = 1;
+        uint64_t previous = 0;
+        MPI_Win_lock(MPI_LOCK_SHARED, 0, 0, window);
+        MPI_Fetch_and_op(&one, &previous, MPI_UINT64_T, 0, 0, MPI_SUM, window);
+        MPI_Win_unlock(0, window);
+        return previous;
+    }
+};
+
+// the records written by each rank are simple length prefixed values
+template <typename T>
+static void WriteValue(std::ostream& stream, const T& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+static T ReadValue(std::istream& stream) {
+    T value{};
+    stream.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return value;
+}
+
+static void WriteString(std::ostream& stream, const std::string& value) {
+    WriteValue<uint64_t>(stream, value.size());
+    stream.write(value.data(), (std::streamsize)value.size());
+}
+
+static std::string ReadString(std::istream& stream) {
+    std::string value(ReadValue<uint64_t>(stream), '\0');
+    stream.read(value.data(), (std::streamsize)value.size());
+    return value;
+}
+
+/**
+ * Gathers the bytes from every rank on the root rank
+ * @return the bytes from every rank in rank order on the root rank, empty on the other ranks
+ */
+static std::string GatherToRoot(MPI_Comm communicator, const std::string& local) {
+    int rank, size;
+    MPI_Comm_rank(communicator, &rank);
+    MPI_Comm_size(communicator, &size);
+
+    const int localCount = (int)local.size();
+    std::vector<int> counts(rank == 0 ? size : 0);
+    MPI_Gather(&localCount, 1, MPI_INT, counts.data(), 1, MPI_INT, 0, communicator);
+
+    std::vector<int> offsets(counts.size());
+    int total = 0;
+    for (std::size_t r = 0; r < counts.size(); r++) {
+        offsets[r] = total;
+        total += counts[r];
+    }
+    std::string gathered(total, '\0');
+    MPI_Gatherv(local.data(), localCount, MPI_CHAR, gathered.data(), counts.data(), offsets.data(), MPI_CHAR, 0, communicator);
+    return gathered;
+}
+
+static void AddStatistics(petscXdmfGenerator::GenerateStatistics& total, const petscXdmfGenerator::GenerateStatistics& statistics) {
+    total.cachedSpecifications += statistics.cachedSpecifications;
+    total.hdfOpens += statistics.hdfOpens;
+    total.hdfMetadataQueries += statistics.hdfMetadataQueries;
+    total.hdfLinkChecks += statistics.hdfLinkChecks;
+    total.hdfIterations += statistics.hdfIterations;
+    total.hdfAttributeChecks += statistics.hdfAttributeChecks;
+    total.hdfAttributeReads += statistics.hdfAttributeReads;
+    total.hdfDatasetReads += statistics.hdfDatasetReads;
+    total.hdfBytesRead += statistics.hdfBytesRead;
+    total.openSeconds += statistics.openSeconds;
+    total.specificationSeconds += statistics.specificationSeconds;
+    total.buildSeconds += statistics.buildSeconds;
+    total.writeSeconds += statistics.writeSeconds;
+    total.bytesWritten += statistics.bytesWritten;
+}
+
+namespace petscXdmfGenerator {
+std::vector<BatchResult> GenerateBatch(MPI_Comm communicator, const std::vector<std::filesystem::path>& inputFilePaths, std::filesystem::path outputDirectory, const GenerateOptions& options) {
+    int rank;
+    MPI_Comm_rank(communicator, &rank);
+
+    // each rank takes the next unconverted file
+    std::vector<std::pair<std::size_t, BatchResult>> converted;
+    {
+        SharedCounter nextIndex(communicator);
+        for (auto index = nextIndex.Next(); index < inputFilePaths.size(); index = nextIndex.Next()) {
+            BatchResult result;
+            result.inputFilePath = inputFilePaths[index];
+            result.outputFilePath = support::DefaultOutputFilePath(result.inputFilePath, outputDirectory);
+            try {
+                result.statistics = Generate(result.inputFilePath, result.outputFilePath, options);
+                result.success = true;
+            } catch (std::exception& exception) {
+                result.error = exception.what();
+            }
+            converted.emplace_back(index, std::move(result));
+        }
+    }
+
+    // the root reports every file, so only the outcome of each conversion is sent
+    std::ostringstream local;
+    for (const auto& [index, result] : converted) {
+        WriteValue<uint64_t>(local, index);
+        WriteValue<char>(local, result.success);
+        WriteString(local, result.error);
+        WriteValue(local, result.statistics);
+    }
+    auto gathered = GatherToRoot(communicator, local.str());
+    if (rank != 0) {
+        std::vector<BatchResult> results;
+        for (auto& [index, result] : converted) {
+            results.push_back(std::move(result));
+        }
+        return results;
+    }
+
+    std::vector<BatchResult> results(inputFilePaths.size());
+    std::istringstream records(gathered);
+    while (records.peek() != std::char_traits<char>::eof()) {
+        auto& result = results.at(ReadValue<uint64_t>(records));
+        result.success = ReadValue<char>(records);
+        result.error = ReadString(records);
+        result.statistics = ReadValue<GenerateStatistics>(records);
+    }
+    for (std::size_t index = 0; index < results.size(); index++) {
+        results[index].inputFilePath = inputFilePaths[index];
+        results[index].outputFilePath = support::DefaultOutputFilePath(inputFilePaths[index], outputDirectory);
+    }
+    return results;
+}
+
+GenerateStatistics GenerateSeries(MPI_Comm communicator, const std::vector<std::filesystem::path>& inputFilePaths, std::filesystem::path outputFilePath, const GenerateOptions& options) {
+    const auto start = Clock::now();
+    int rank;
+    MPI_Comm_rank(communicator, &rank);
+
+    // each rank extracts (and fingerprints the meshes of) the specification for the next unclaimed file
+    const auto fingerprintMeshes = options.shareStaticMeshes && inputFilePaths.size() > 1;
+    GenerateStatistics statistics;
+    std::ostringstream local;
+    {
+        SharedCounter nextIndex(communicator);
+        for (auto index = nextIndex.Next(); index < inputFilePaths.size(); index = nextIndex.Next()) {
+            WriteValue<uint64_t>(local, index);
+            try {
+                std::ostringstream specification;
+                support::LoadSpecification(inputFilePaths[index], options, statistics, false, fingerprintMeshes)->WriteBinary(specification);
+                WriteValue<char>(local, true);
+                WriteString(local, specification.str());
+            } catch (std::exception& exception) {
+                WriteValue<char>(local, false);
+                WriteString(local, "unable to read " + inputFilePaths[index].string() + ": " + exception.what());
+            }
+        }
+        WriteValue<uint64_t>(local, UINT64_MAX);
+        WriteValue(local, statistics);
+    }
+    auto gathered = GatherToRoot(communicator, local.str());
+
+    // the root puts the specifications back in time order
+    std::vector<std::shared_ptr<XdmfSpecification>> series(rank == 0 ? inputFilePaths.size() : 0);
+    std::string error;
+    if (rank == 0) {
+        statistics = {};
+        std::istringstream records(gathered);
+        while (records.peek() != std::char_traits<char>::eof()) {
+            auto index = ReadValue<uint64_t>(records);
+            if (index == UINT64_MAX) {
+                AddStatistics(statistics, ReadValue<GenerateStatistics>(records));
+                continue;
+            }
+            const bool success = ReadValue<char>(records);
+            auto value = ReadString(records);
+            if (!success) {
+                error = error.empty() ? value : error;
+                continue;
+            }
+            std::istringstream specification(value);
+            series.at(index) = XdmfSpecification::ReadBinary(specification);
+        }
+    }
+
+    // every rank reports the same failure
+    uint64_t errorLength = error.size();
+    MPI_Bcast(&errorLength, 1, MPI_UINT64_T, 0, communicator);
+    error.resize(errorLength);
+    MPI_Bcast(error.data(), (int)errorLength, MPI_CHAR, 0, communicator);
+    if (!error.empty()) {
+        throw std::runtime_error(error);
+    }
+
+    if (rank == 0) {
+        XdmfBuilder builder(series);
+        support::ConfigureBuilder(builder, options);
+        support::ShareStaticMeshes(series, builder, options);
+
+        // write to the file
+        const auto buildStart = Clock::now();
+        OutputFileStream xmlFile(outputFilePath);
+        builder.Build(xmlFile);
+        xmlFile.Close();
+        statistics.writeSeconds += xmlFile.Statistics().writeSeconds;
+        statistics.bytesWritten += xmlFile.Statistics().bytesWritten;
+        statistics.buildSeconds += SecondsSince(buildStart) - xmlFile.Statistics().writeSeconds;
+    }
+
+    statistics.totalSeconds = SecondsSince(start);
+    return statistics;
+}
+}  // namespace petscXdmfGenerator
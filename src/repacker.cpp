@@ -0,0 +1,185 @@
+#include "repacker.hpp"
+#include <algorithm>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+#include "scopedHid.hpp"
+
+using namespace petscXdmfGenerator;
+
+static void Check(herr_t status, const std::string& what) {
+    if (status < 0) {
+        throw std::runtime_error("unable to repack " + what);
+    }
+}
+
+static herr_t AddLinkName(hid_t, const char* name, const H5L_info_t*, void* names) {
+    static_cast<std::vector<std::string>*>(names)->emplace_back(name);
+    return 0;
+}
+
+static herr_t AddAttributeName(hid_t, const char* name, const H5A_info_t*, void* names) {
+    static_cast<std::vector<std::string>*>(names)->emplace_back(name);
+    return 0;
+}
+
+static const char* LayoutName(H5D_layout_t layout) {
+    switch (layout) {
+        case H5D_COMPACT:
+            return "compact";
+        case H5D_CHUNKED:
+            return "chunked";
+        case H5D_VIRTUAL:
+            return "virtual";
+        default:
+            return "contiguous";
+    }
+}
+
+petscXdmfGenerator::Repacker::Repacker(std::filesystem::path inputFilePath, std::set<std::string> rewrittenPaths)
+    : inputFilePath(std::move(inputFilePath)), rewrittenPaths(std::move(rewrittenPaths)) {}
+
+void petscXdmfGenerator::Repacker::Write(const std::filesystem::path& outputFilePath) const {
+    std::error_code error;
+    if (std::filesystem::equivalent(inputFilePath, outputFilePath, error)) {
+        throw std::invalid_argument("the repacked file must not replace " + inputFilePath.string());
+    }
+
+    // the hdf5 library is not thread safe
+    std::lock_guard<std::mutex> lock(HdfObject::LibraryMutex());
+    ScopedHid source(H5Fopen(inputFilePath.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT), H5Fclose, "a reader for " + inputFilePath.string());
+    ScopedHid destination(H5Fcreate(outputFilePath.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT), H5Fclose, "the file " + outputFilePath.string());
+    ScopedHid sourceRoot(H5Gopen(source, "/", H5P_DEFAULT), H5Gclose, "a reader for the root group");
+    ScopedHid destinationRoot(H5Gopen(destination, "/", H5P_DEFAULT), H5Gclose, "the root group");
+    CopyAttributes(sourceRoot, destinationRoot);
+    CopyGroup(sourceRoot, destinationRoot, "");
+    Check(H5Fflush(destination, H5F_SCOPE_GLOBAL), outputFilePath.string());
+}
+
+void petscXdmfGenerator::Repacker::CopyGroup(hid_t sourceGroup, hid_t destinationGroup, const std::string& groupPath) const {
+    std::vector<std::string> names;
+    Check(H5Literate(sourceGroup, H5_INDEX_NAME, H5_ITER_INC, nullptr, AddLinkName, &names), "the links in " + groupPath + "/");
+
+    for (const auto& name : names) {
+        const auto path = groupPath + "/" + name;
+        H5L_info_t linkInformation;
+        Check(H5Lget_info(sourceGroup, name.c_str(), &linkInformation, H5P_DEFAULT), path);
+
+        // soft and external links are recreated as is
+        if (linkInformation.type == H5L_TYPE_SOFT || linkInformation.type == H5L_TYPE_EXTERNAL) {
+            std::vector<char> value(linkInformation.u.val_size);
+            Check(H5Lget_val(sourceGroup, name.c_str(), value.data(), value.size(), H5P_DEFAULT), path);
+            if (linkInformation.type == H5L_TYPE_SOFT) {
+                Check(H5Lcreate_soft(value.data(), destinationGroup, name.c_str(), H5P_DEFAULT, H5P_DEFAULT), path);
+            } else {
+                const char* fileName = nullptr;
+                const char* objectName = nullptr;
+                Check(H5Lunpack_elink_val(value.data(), value.size(), nullptr, &fileName, &objectName), path);
+                Check(H5Lcreate_external(fileName, objectName, destinationGroup, name.c_str(), H5P_DEFAULT, H5P_DEFAULT), path);
+            }
+            continue;
+        }
+
+        H5O_info_t objectInformation;
+        Check(H5Oget_info_by_name(sourceGroup, name.c_str(), &objectInformation, H5P_DEFAULT), path);
+        if (objectInformation.type == H5O_TYPE_GROUP) {
+            ScopedHid sourceChild(H5Gopen(sourceGroup, name.c_str(), H5P_DEFAULT), H5Gclose, "a reader for " + path);
+            ScopedHid destinationChild(H5Gcreate(destinationGroup, name.c_str(), H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT), H5Gclose, "the group " + path);
+            CopyAttributes(sourceChild, destinationChild);
+            CopyGroup(sourceChild, destinationChild, path);
+        } else if (objectInformation.type == H5O_TYPE_DATASET && rewrittenPaths.count(path)) {
+            RewriteDataset(sourceGroup, destinationGroup, name);
+        } else {
+            Check(H5Ocopy(sourceGroup, name.c_str(), destinationGroup, name.c_str(), H5P_DEFAULT, H5P_DEFAULT), path);
+        }
+    }
+}
+
+void petscXdmfGenerator::Repacker::RewriteDataset(hid_t sourceGroup, hid_t destinationGroup, const std::string& name) {
+    ScopedHid dataset(H5Dopen(sourceGroup, name.c_str(), H5P_DEFAULT), H5Dclose, "a reader for " + name);
+    ScopedHid type(H5Dget_type(dataset), H5Tclose, "the type of " + name);
+    ScopedHid fileSpace(H5Dget_space(dataset), H5Sclose, "the dataspace of " + name);
+    ScopedHid properties(H5Dget_create_plist(dataset), H5Pclose, "the properties of " + name);
+
+    const auto rank = H5Sget_simple_extent_ndims(fileSpace);
+    if (rank < 2) {
+        throw std::invalid_argument("only time dependent datasets can be repacked, " + name + " has a single dimension");
+    }
+    std::vector<hsize_t> shape(rank);
+    H5Sget_simple_extent_dims(fileSpace, shape.data(), nullptr);
+
+    // each chunk holds a single step, split along the points only if a step is too large for a single chunk
+    const auto typeSize = H5Tget_size(type);
+    std::vector<hsize_t> chunk(shape);
+    chunk[0] = 1;
+    for (auto& extent : chunk) {
+        extent = std::max<hsize_t>(extent, 1);
+    }
+    while (chunk[1] > 1 && std::accumulate(chunk.begin(), chunk.end(), (hsize_t)typeSize, std::multiplies<>()) >= MaximumChunkBytes) {
+        chunk[1] = (chunk[1] + 1) / 2;
+    }
+    Check(H5Pset_chunk(properties, rank, chunk.data()), "the chunks for " + name);
+    ScopedHid rewritten(H5Dcreate(destinationGroup, name.c_str(), type, fileSpace, H5P_DEFAULT, properties, H5P_DEFAULT), H5Dclose, "the dataset " + name);
+
+    // copy a step at a time in the stored type so that memory use is bounded by a single step
+    std::vector<hsize_t> start(rank, 0);
+    std::vector<hsize_t> count(shape);
+    count[0] = 1;
+    ScopedHid memorySpace(H5Screate_simple(rank, count.data(), nullptr), H5Sclose, "the step dataspace for " + name);
+    std::vector<char> step(std::accumulate(count.begin(), count.end(), (hsize_t)typeSize, std::multiplies<>()));
+    for (start[0] = 0; start[0] < shape[0]; start[0]++) {
+        Check(H5Sselect_hyperslab(fileSpace, H5S_SELECT_SET, start.data(), nullptr, count.data(), nullptr), "the step selection for " + name);
+        Check(H5Dread(dataset, type, memorySpace, fileSpace, H5P_DEFAULT, step.data()), "a step of " + name);
+        Check(H5Dwrite(rewritten, type, memorySpace, fileSpace, H5P_DEFAULT, step.data()), "a step of " + name);
+    }
+    CopyAttributes(dataset, rewritten);
+}
+
+void petscXdmfGenerator::Repacker::CopyAttributes(hid_t source, hid_t destination) {
+    std::vector<std::string> names;
+    Check(H5Aiterate2(source, H5_INDEX_NAME, H5_ITER_INC, nullptr, AddAttributeName, &names), "the attributes");
+
+    for (const auto& name : names) {
+        ScopedHid attribute(H5Aopen(source, name.c_str(), H5P_DEFAULT), H5Aclose, "a reader for the attribute " + name);
+        ScopedHid type(H5Aget_type(attribute), H5Tclose, "the type of the attribute " + name);
+        ScopedHid space(H5Aget_space(attribute), H5Sclose, "the dataspace of the attribute " + name);
+
+        // the values are copied in the stored type, variable length values are released after they are written
+        std::vector<char> values(std::max<hssize_t>(H5Sget_simple_extent_npoints(space), 1) * H5Tget_size(type));
+        Check(H5Aread(attribute, type, values.data()), "the attribute " + name);
+        ScopedHid copy(H5Acreate(destination, name.c_str(), type, space, H5P_DEFAULT, H5P_DEFAULT), H5Aclose, "the attribute " + name);
+        const auto status = H5Awrite(copy, type, values.data());
+        if (H5Tdetect_class(type, H5T_VLEN) > 0 || H5Tis_variable_str(type) > 0) {
+            H5Dvlen_reclaim(type, space, H5P_DEFAULT, values.data());
+        }
+        Check(status, "the attribute " + name);
+    }
+}
+
+LayoutReport petscXdmfGenerator::Repacker::Analyze(const HdfObject& dataset) {
+    const auto shape = dataset.Shape();
+    const auto storage = dataset.Layout();
+    const auto typeSize = (uint64_t)dataset.DataType().size;
+
+    LayoutReport report{.path = dataset.Path(),
+                        .layout = LayoutName(storage.layout),
+                        .shape = std::vector<unsigned long long>(shape.begin(), shape.end()),
+                        .chunk = std::vector<unsigned long long>(storage.chunk.begin(), storage.chunk.end()),
+                        .filtered = !storage.filters.empty()};
+    if (shape.size() < 2) {
+        return report;
+    }
+    report.stepBytes = std::accumulate(shape.begin() + 1, shape.end(), typeSize, std::multiplies<>());
+
+    // a contiguous step is a single read, a chunked step reads (and decompresses) every chunk it touches
+    if (storage.layout == H5D_CHUNKED && storage.chunk.size() == shape.size()) {
+        report.chunksPerStep = 1;
+        for (std::size_t d = 1; d < shape.size(); d++) {
+            report.chunksPerStep *= (shape[d] + storage.chunk[d] - 1) / storage.chunk[d];
+        }
+        report.chunkBytesPerStep = report.chunksPerStep * std::accumulate(storage.chunk.begin(), storage.chunk.end(), typeSize, std::multiplies<>());
+        report.aligned = storage.chunk[0] == 1 && report.chunksPerStep <= 1;
+    }
+    return report;
+}
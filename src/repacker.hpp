@@ -0,0 +1,55 @@
+#ifndef PETSCXDMFGENERATOR_REPACKER_HPP
+#define PETSCXDMFGENERATOR_REPACKER_HPP
+
+#include <filesystem>
+#include <set>
+#include <string>
+#include "generators.hpp"
+#include "hdfObject.hpp"
+
+namespace petscXdmfGenerator {
+/**
+ * Copies an hdf5 file, rewriting the named time dependent datasets with one chunk per time step.  Every other object
+ * is copied unchanged with H5Ocopy.
+ */
+class Repacker {
+   private:
+    const std::filesystem::path inputFilePath;
+
+    // the absolute path of each dataset that is rewritten
+    const std::set<std::string> rewrittenPaths;
+
+    // chunks must be smaller than 4 GiB, so each rewritten chunk is kept below 2 GiB
+    inline const static hsize_t MaximumChunkBytes = (hsize_t)1 << 31;
+
+    // copies the links in the group, recreating the groups below it
+    void CopyGroup(hid_t sourceGroup, hid_t destinationGroup, const std::string& groupPath) const;
+
+    // rewrites a single dataset a step at a time
+    static void RewriteDataset(hid_t sourceGroup, hid_t destinationGroup, const std::string& name);
+
+    // copies every attribute from one object to another
+    static void CopyAttributes(hid_t source, hid_t destination);
+
+   public:
+    /**
+     * @param inputFilePath
+     * @param rewrittenPaths the absolute path of each dataset to rewrite
+     */
+    Repacker(std::filesystem::path inputFilePath, std::set<std::string> rewrittenPaths);
+
+    /**
+     * Writes the repacked file, replacing any existing file
+     * @param outputFilePath
+     */
+    void Write(const std::filesystem::path& outputFilePath) const;
+
+    /**
+     * Compares the storage of a time dependent dataset to the single step slabs the xdmf reads
+     * @param dataset
+     * @return
+     */
+    static LayoutReport Analyze(const HdfObject& dataset);
+};
+}  // namespace petscXdmfGenerator
+#endif  // PETSCXDMFGENERATOR_REPACKER_HPP
@@ -0,0 +1,37 @@
+#ifndef PETSCXDMFGENERATOR_SCOPEDHID_HPP
+#define PETSCXDMFGENERATOR_SCOPEDHID_HPP
+
+#include <stdexcept>
+#include <string>
+#include "hdfObject.hpp"
+
+namespace petscXdmfGenerator {
+/**
+ * Closes an hdf5 id when it goes out of scope, used when writing files directly with the hdf5 library
+ */
+class ScopedHid {
+   private:
+    const hid_t id;
+    herr_t (*const close)(hid_t);
+
+   public:
+    /**
+     * Takes ownership of the id, throwing if it could not be created
+     * @param id
+     * @param close the hdf5 function that closes this kind of id
+     * @param what describes the id in the error
+     */
+    ScopedHid(hid_t id, herr_t (*close)(hid_t), const std::string& what) : id(id), close(close) {
+        if (id < 0) {
+            throw std::runtime_error("unable to create " + what);
+        }
+    }
+    ~ScopedHid() { close(id); }
+
+    ScopedHid(const ScopedHid&) = delete;
+    void operator=(const ScopedHid&) = delete;
+
+    operator hid_t() const { return id; }
+};
+}  // namespace petscXdmfGenerator
+#endif  // PETSCXDMFGENERATOR_SCOPEDHID_HPP
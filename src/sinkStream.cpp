@@ -0,0 +1,66 @@
+#include "sinkStream.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+petscXdmfGenerator::SinkBuffer::SinkBuffer(Sink sink, std::size_t bufferSize) : sink(std::move(sink)), buffer(std::max<std::size_t>(bufferSize, 1)) {
+    setp(buffer.data(), buffer.data() + buffer.size());
+}
+
+void petscXdmfGenerator::SinkBuffer::WriteBuffer() {
+    const auto count = pptr() - pbase();
+    if (count == 0) {
+        return;
+    }
+
+    // reset the buffer first so nothing is passed twice if the sink throws
+    setp(buffer.data(), buffer.data() + buffer.size());
+    const auto start = std::chrono::steady_clock::now();
+    sink(buffer.data(), (std::size_t)count);
+    statistics.writeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    statistics.writeCalls++;
+    statistics.bytesWritten += count;
+    written += count;
+}
+
+petscXdmfGenerator::SinkBuffer::int_type petscXdmfGenerator::SinkBuffer::overflow(int_type character) {
+    WriteBuffer();
+    if (!traits_type::eq_int_type(character, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(character);
+        pbump(1);
+    }
+    return traits_type::not_eof(character);
+}
+
+std::streamsize petscXdmfGenerator::SinkBuffer::xsputn(const char* characters, std::streamsize count) {
+    std::streamsize copied = 0;
+    while (copied < count) {
+        if (pptr() == epptr()) {
+            WriteBuffer();
+        }
+        const auto chunk = std::min<std::streamsize>(count - copied, epptr() - pptr());
+        std::memcpy(pptr(), characters + copied, chunk);
+        pbump((int)chunk);
+        copied += chunk;
+    }
+    return copied;
+}
+
+int petscXdmfGenerator::SinkBuffer::sync() {
+    WriteBuffer();
+    return 0;
+}
+
+petscXdmfGenerator::SinkBuffer::pos_type petscXdmfGenerator::SinkBuffer::seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode mode) {
+    // only the current position can be queried (tellp)
+    if (offset != 0 || direction != std::ios_base::cur || !(mode & std::ios_base::out)) {
+        return pos_type(off_type(-1));
+    }
+    return pos_type(written + (pptr() - pbase()));
+}
+
+petscXdmfGenerator::SinkStream::SinkStream(SinkBuffer::Sink sink, std::size_t bufferSize) : std::ostream(nullptr), buffer(std::move(sink), bufferSize) {
+    rdbuf(&buffer);
+    // let an exception from the sink reach the caller instead of only setting badbit
+    exceptions(std::ios::badbit);
+}
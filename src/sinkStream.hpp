@@ -0,0 +1,69 @@
+#ifndef PETSCXDMFGENERATOR_SINKSTREAM_HPP
+#define PETSCXDMFGENERATOR_SINKSTREAM_HPP
+
+#include <functional>
+#include <iostream>
+#include <streambuf>
+#include <vector>
+#include "fileDescriptorStream.hpp"
+
+namespace petscXdmfGenerator {
+
+/**
+ * A stream buffer that collects the output and hands it to a caller supplied function in large blocks, so that the
+ * xdmf can be written into memory or any other destination without going through a file
+ */
+class SinkBuffer : public std::streambuf {
+   public:
+    using Sink = std::function<void(const char* data, std::size_t size)>;
+
+   private:
+    const Sink sink;
+    std::vector<char> buffer;
+
+    // the number of bytes already passed to the sink
+    std::streamoff written = 0;
+    WriteStatistics statistics;
+
+    // passes the buffered bytes to the sink
+    void WriteBuffer();
+
+   protected:
+    int_type overflow(int_type character) override;
+    std::streamsize xsputn(const char* characters, std::streamsize count) override;
+    int sync() override;
+    pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode mode) override;
+
+   public:
+    inline const static std::size_t DefaultBufferSize = 64 * 1024;
+
+    explicit SinkBuffer(Sink sink, std::size_t bufferSize = DefaultBufferSize);
+
+    /**
+     * the bytes passed to the sink so far, not including any that are still buffered
+     * @return
+     */
+    const WriteStatistics& Statistics() const { return statistics; }
+};
+
+/**
+ * An output stream that writes to a sink through a SinkBuffer.  An exception thrown by the sink is passed on to the
+ * caller of flush.
+ */
+class SinkStream : public std::ostream {
+   private:
+    SinkBuffer buffer;
+
+   public:
+    explicit SinkStream(SinkBuffer::Sink sink, std::size_t bufferSize = SinkBuffer::DefaultBufferSize);
+
+    /**
+     * the bytes passed to the sink so far, not including any that are still buffered
+     * @return
+     */
+    const WriteStatistics& Statistics() const { return buffer.Statistics(); }
+};
+
+}  // namespace petscXdmfGenerator
+
+#endif  // PETSCXDMFGENERATOR_SINKSTREAM_HPP
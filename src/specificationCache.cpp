@@ -0,0 +1,95 @@
+#include "specificationCache.hpp"
+#include <exception>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include "hash.hpp"
+
+using namespace petscXdmfGenerator;
+
+static const auto CacheHeader = "petscXdmfGenerator-cache 1";
+
+petscXdmfGenerator::SpecificationCache::SpecificationCache(std::filesystem::path directory) : directory(std::move(directory)) {
+    if (!this->directory.empty()) {
+        std::filesystem::create_directories(this->directory);
+    }
+}
+
+SpecificationCache::FileIdentity petscXdmfGenerator::SpecificationCache::Identify(const std::filesystem::path& inputFilePath) {
+    FileIdentity identity;
+    identity.path = std::filesystem::absolute(inputFilePath).lexically_normal().string();
+    identity.size = std::filesystem::file_size(inputFilePath);
+    identity.modified = std::filesystem::last_write_time(inputFilePath).time_since_epoch().count();
+
+    // the superblock (including the end of file address) is at the start of the file unless there is a user block
+    std::ifstream inputFile(inputFilePath, std::ios::binary);
+    std::string superblock(SuperblockBytes, '\0');
+    inputFile.read(superblock.data(), superblock.size());
+    superblock.resize(inputFile.gcount());
+    identity.superblockHash = Hash().Add(superblock).Value();
+
+    return identity;
+}
+
+std::filesystem::path petscXdmfGenerator::SpecificationCache::EntryPath(const FileIdentity& identity, const std::filesystem::path& inputFilePath) const {
+    if (directory.empty()) {
+        auto entryPath = inputFilePath;
+        entryPath += ".spec";
+        return entryPath;
+    }
+
+    // name each entry in the directory by the hash of the full path
+    std::stringstream name;
+    name << std::hex << Hash().Add(identity.path).Value() << ".spec";
+    return directory / name.str();
+}
+
+static void WriteIdentity(std::ostream& stream, const std::string& path, std::uintmax_t size, long long modified, uint64_t superblockHash) {
+    stream << CacheHeader << '\n' << path << '\n' << size << ' ' << modified << ' ' << superblockHash << '\n';
+}
+
+std::shared_ptr<XdmfSpecification> petscXdmfGenerator::SpecificationCache::Get(const std::filesystem::path& inputFilePath) const {
+    auto identity = Identify(inputFilePath);
+
+    std::ifstream entryFile(EntryPath(identity, inputFilePath), std::ios::binary);
+    if (!entryFile) {
+        return nullptr;
+    }
+
+    // check that the entry is for this exact file
+    FileIdentity entryIdentity;
+    std::string header;
+    std::getline(entryFile, header);
+    std::getline(entryFile, entryIdentity.path);
+    entryFile >> entryIdentity.size >> entryIdentity.modified >> entryIdentity.superblockHash;
+    entryFile.ignore(1);
+    if (!entryFile || header != CacheHeader || !(entryIdentity == identity)) {
+        return nullptr;
+    }
+
+    try {
+        return XdmfSpecification::ReadBinary(entryFile);
+    } catch (std::exception&) {
+        // treat an unreadable (or corrupt) entry as a miss
+        return nullptr;
+    }
+}
+
+void petscXdmfGenerator::SpecificationCache::Put(const std::filesystem::path& inputFilePath, const XdmfSpecification& specification) const {
+    auto identity = Identify(inputFilePath);
+    auto entryPath = EntryPath(identity, inputFilePath);
+
+    // write to a unique temporary file and move it into place so readers never see a partial entry
+    std::stringstream temporaryName;
+    temporaryName << entryPath.filename().string() << ".tmp" << std::this_thread::get_id();
+    auto temporaryPath = entryPath.parent_path() / temporaryName.str();
+    {
+        std::ofstream entryFile(temporaryPath, std::ios::binary);
+        WriteIdentity(entryFile, identity.path, identity.size, identity.modified, identity.superblockHash);
+        specification.WriteBinary(entryFile);
+        if (!entryFile) {
+            throw std::runtime_error("unable to write specification cache " + temporaryPath.string());
+        }
+    }
+    std::filesystem::rename(temporaryPath, entryPath);
+}
@@ -0,0 +1,54 @@
+#ifndef PETSCXDMFGENERATOR_SPECIFICATIONCACHE_HPP
+#define PETSCXDMFGENERATOR_SPECIFICATIONCACHE_HPP
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include "xdmfSpecification.hpp"
+
+namespace petscXdmfGenerator {
+/**
+ * Stores the specification extracted from each hdf5 file on disk so that an unchanged file never needs to be opened
+ * with hdf5 again.  Entries are keyed by the file path, size, modification time, and a hash of the superblock.
+ */
+class SpecificationCache {
+   private:
+    // where to store the cache, if empty each entry is stored next to its hdf5 file
+    const std::filesystem::path directory;
+
+    // the number of bytes at the start of the file hashed to detect changes (covers the superblock)
+    inline const static std::size_t SuperblockBytes = 4096;
+
+    struct FileIdentity {
+        std::string path;
+        std::uintmax_t size = 0;
+        long long modified = 0;
+        uint64_t superblockHash = 0;
+
+        bool operator==(const FileIdentity& other) const { return path == other.path && size == other.size && modified == other.modified && superblockHash == other.superblockHash; }
+    };
+
+    static FileIdentity Identify(const std::filesystem::path& inputFilePath);
+
+    std::filesystem::path EntryPath(const FileIdentity& identity, const std::filesystem::path& inputFilePath) const;
+
+   public:
+    explicit SpecificationCache(std::filesystem::path directory = {});
+
+    /**
+     * Gets the cached specification, or nullptr if there is no entry or the file has changed
+     * @param inputFilePath
+     * @return
+     */
+    std::shared_ptr<XdmfSpecification> Get(const std::filesystem::path& inputFilePath) const;
+
+    /**
+     * Stores the specification for the file
+     * @param inputFilePath
+     * @param specification
+     */
+    void Put(const std::filesystem::path& inputFilePath, const XdmfSpecification& specification) const;
+};
+}  // namespace petscXdmfGenerator
+
+#endif  // PETSCXDMFGENERATOR_SPECIFICATIONCACHE_HPP
@@ -0,0 +1,315 @@
+#include "vtkHdfBuilder.hpp"
+#include <map>
+#include <numeric>
+#include <stdexcept>
+#include "hdfObject.hpp"
+#include "scopedHid.hpp"
+
+using namespace petscXdmfGenerator;
+
+namespace {
+// a block of a source dataset copied into a block of a virtual dataset
+struct Mapping {
+    std::vector<hsize_t> sourceStart;
+    std::vector<hsize_t> sourceCount;
+    std::vector<hsize_t> virtualStart;
+    std::vector<hsize_t> virtualCount;
+};
+}  // namespace
+
+// the vtk cell type for the number of corners in each dimension
+static const std::map<unsigned long long, std::map<unsigned long long, uint8_t>> vtkCellTypes = {
+    {1, {{1, 1 /*VTK_VERTEX*/}, {2, 3 /*VTK_LINE*/}}},
+    {2, {{3, 5 /*VTK_TRIANGLE*/}, {4, 9 /*VTK_QUAD*/}}},
+    {3, {{4, 10 /*VTK_TETRA*/}, {6, 13 /*VTK_WEDGE*/}, {8, 12 /*VTK_HEXAHEDRON*/}}}};
+static const uint8_t VtkVertex = 1;
+
+// the offsets dataset is chunked so that it can be compressed
+static const hsize_t ChunkSize = 64 * 1024;
+
+static void Check(herr_t status, const std::string& what) {
+    if (status < 0) {
+        throw std::runtime_error("unable to write " + what);
+    }
+}
+
+static hid_t FileType(const XdmfSpecification::DataTypeDescription& dataType) {
+    switch (dataType.numberType) {
+        case FLOAT:
+            return dataType.precision == 4 ? H5T_IEEE_F32LE : H5T_IEEE_F64LE;
+        case INT:
+        case UINT: {
+            const bool isSigned = dataType.numberType == INT;
+            switch (dataType.precision) {
+                case 1:
+                    return isSigned ? H5T_STD_I8LE : H5T_STD_U8LE;
+                case 2:
+                    return isSigned ? H5T_STD_I16LE : H5T_STD_U16LE;
+                case 4:
+                    return isSigned ? H5T_STD_I32LE : H5T_STD_U32LE;
+                default:
+                    return isSigned ? H5T_STD_I64LE : H5T_STD_U64LE;
+            }
+        }
+        case CHAR:
+            return H5T_STD_I8LE;
+        case UCHAR:
+            return H5T_STD_U8LE;
+    }
+    throw std::invalid_argument("unknown number type");
+}
+
+// PETSc leaves the trailing 1 off scalar fields, the specification adds it back
+static std::vector<hsize_t> StoredShape(const XdmfSpecification::FieldDescription& field) {
+    std::vector<hsize_t> shape(field.shape.begin(), field.shape.end());
+    if (field.fieldType == SCALAR && field.components.empty() && shape.size() > 2) {
+        shape.pop_back();
+    }
+    return shape;
+}
+
+template <class T>
+static hid_t MemoryType();
+template <>
+hid_t MemoryType<int64_t>() {
+    return H5T_NATIVE_INT64;
+}
+template <>
+hid_t MemoryType<double>() {
+    return H5T_NATIVE_DOUBLE;
+}
+
+template <class T>
+static void WriteAttribute(hid_t object, const std::string& name, const std::vector<T>& values) {
+    const hsize_t size = values.size();
+    ScopedHid space(H5Screate_simple(1, &size, nullptr), H5Sclose, "the dataspace for " + name);
+    ScopedHid attribute(H5Acreate(object, name.c_str(), H5T_STD_I64LE, space, H5P_DEFAULT, H5P_DEFAULT), H5Aclose, "the attribute " + name);
+    Check(H5Awrite(attribute, MemoryType<T>(), values.data()), "the attribute " + name);
+}
+
+static void WriteAttribute(hid_t object, const std::string& name, const std::string& value) {
+    ScopedHid type(H5Tcopy(H5T_C_S1), H5Tclose, "the type for " + name);
+    Check(H5Tset_size(type, value.size()), "the type for " + name);
+    Check(H5Tset_strpad(type, H5T_STR_NULLPAD), "the type for " + name);
+    ScopedHid space(H5Screate(H5S_SCALAR), H5Sclose, "the dataspace for " + name);
+    ScopedHid attribute(H5Acreate(object, name.c_str(), type, space, H5P_DEFAULT, H5P_DEFAULT), H5Aclose, "the attribute " + name);
+    Check(H5Awrite(attribute, type, value.data()), "the attribute " + name);
+}
+
+// writes a small, or at least cheaply computed, dataset
+template <class T>
+static void WriteValues(hid_t group, const std::string& name, const std::vector<T>& values, hid_t fileType) {
+    const hsize_t size = values.size();
+    ScopedHid space(H5Screate_simple(1, &size, nullptr), H5Sclose, "the dataspace for " + name);
+    ScopedHid properties(H5Pcreate(H5P_DATASET_CREATE), H5Pclose, "the properties for " + name);
+    if (size > ChunkSize) {
+        const hsize_t chunk = ChunkSize;
+        Check(H5Pset_chunk(properties, 1, &chunk), "the chunks for " + name);
+        if (H5Zfilter_avail(H5Z_FILTER_DEFLATE) > 0) {
+            Check(H5Pset_shuffle(properties), "the filters for " + name);
+            Check(H5Pset_deflate(properties, 6), "the filters for " + name);
+        }
+    }
+    ScopedHid dataset(H5Dcreate(group, name.c_str(), fileType, space, H5P_DEFAULT, properties, H5P_DEFAULT), H5Dclose, "the dataset " + name);
+    Check(H5Dwrite(dataset, MemoryType<T>(), H5S_ALL, H5S_ALL, H5P_DEFAULT, values.data()), "the dataset " + name);
+}
+
+// a dataset that holds a single repeated value takes no space, every read returns the fill value
+static void WriteConstant(hid_t group, const std::string& name, hsize_t size, uint8_t value) {
+    ScopedHid space(H5Screate_simple(1, &size, nullptr), H5Sclose, "the dataspace for " + name);
+    ScopedHid properties(H5Pcreate(H5P_DATASET_CREATE), H5Pclose, "the properties for " + name);
+    Check(H5Pset_fill_value(properties, H5T_NATIVE_UINT8, &value), "the fill value for " + name);
+    Check(H5Pset_fill_time(properties, H5D_FILL_TIME_IFSET), "the fill value for " + name);
+    Check(H5Pset_alloc_time(properties, H5D_ALLOC_TIME_LATE), "the allocation for " + name);
+    ScopedHid dataset(H5Dcreate(group, name.c_str(), H5T_STD_U8LE, space, H5P_DEFAULT, properties, H5P_DEFAULT), H5Dclose, "the dataset " + name);
+}
+
+// a dataset that reads each block from the source dataset in the hdf5 file
+static void WriteVirtual(hid_t group, const std::string& name, hid_t fileType, const std::vector<hsize_t>& virtualShape, const std::string& sourceFile, const std::string& sourcePath,
+                         const std::vector<hsize_t>& sourceShape, const std::vector<Mapping>& mappings) {
+    ScopedHid virtualSpace(H5Screate_simple((int)virtualShape.size(), virtualShape.data(), nullptr), H5Sclose, "the dataspace for " + name);
+    ScopedHid sourceSpace(H5Screate_simple((int)sourceShape.size(), sourceShape.data(), nullptr), H5Sclose, "the source dataspace for " + name);
+    ScopedHid properties(H5Pcreate(H5P_DATASET_CREATE), H5Pclose, "the properties for " + name);
+
+    // anything not mapped (such as the z coordinate of two dimensional points) reads as zero
+    const double zero = 0;
+    Check(H5Pset_fill_value(properties, H5T_NATIVE_DOUBLE, &zero), "the fill value for " + name);
+
+    for (const auto& mapping : mappings) {
+        Check(H5Sselect_hyperslab(virtualSpace, H5S_SELECT_SET, mapping.virtualStart.data(), nullptr, mapping.virtualCount.data(), nullptr), "the selection for " + name);
+        Check(H5Sselect_hyperslab(sourceSpace, H5S_SELECT_SET, mapping.sourceStart.data(), nullptr, mapping.sourceCount.data(), nullptr), "the source selection for " + name);
+        Check(H5Pset_virtual(properties, virtualSpace, sourceFile.c_str(), sourcePath.c_str(), sourceSpace), "the mapping for " + name);
+    }
+    ScopedHid dataset(H5Dcreate(group, name.c_str(), fileType, virtualSpace, H5P_DEFAULT, properties, H5P_DEFAULT), H5Dclose, "the dataset " + name);
+}
+
+// maps a field (or the geometry) into a virtual dataset that stacks the values at each time step
+static void WriteField(hid_t group, const std::string& name, const std::string& sourceFile, const XdmfSpecification::GridDescription& grid, const XdmfSpecification::FieldDescription& field,
+                       hsize_t steps, hsize_t columns = 0) {
+    const auto sourceShape = StoredShape(field);
+    const bool timeDependent = field.HasTimeDimension();
+    const hsize_t rows = field.GetDof();
+
+    // the components (if any) follow the rows
+    const std::size_t componentRank = sourceShape.size() - (timeDependent ? 2 : 1);
+    const hsize_t components = componentRank ? sourceShape.back() : 1;
+    const hsize_t virtualColumns = columns ? columns : components;
+
+    // each time step in the source (there may be fewer than the grid while the file is being written) is a block of rows
+    hsize_t stepsAvailable = timeDependent ? 0 : 1;
+    while (timeDependent && stepsAvailable < steps && grid.TimeRow(stepsAvailable) < sourceShape[0]) {
+        stepsAvailable++;
+    }
+    const hsize_t virtualRows = timeDependent ? steps * rows : rows;
+    std::vector<hsize_t> virtualShape = {virtualRows};
+    if (componentRank || columns) {
+        virtualShape.push_back(virtualColumns);
+    }
+
+    std::vector<Mapping> mappings;
+    for (hsize_t step = 0; step < stepsAvailable; step++) {
+        Mapping mapping;
+        if (timeDependent) {
+            mapping.sourceStart.push_back(grid.TimeRow(step));
+            mapping.sourceCount.push_back(1);
+        }
+        mapping.sourceStart.push_back(0);
+        mapping.sourceCount.push_back(rows);
+        mapping.virtualStart.push_back(step * rows);
+        mapping.virtualCount.push_back(rows);
+        if (componentRank) {
+            mapping.sourceStart.push_back(0);
+            mapping.sourceCount.push_back(components);
+        }
+        if (virtualShape.size() > 1) {
+            mapping.virtualStart.push_back(0);
+            mapping.virtualCount.push_back(components);
+        }
+        mappings.push_back(std::move(mapping));
+    }
+
+    WriteVirtual(group, name, FileType(field.dataType), virtualShape, sourceFile, field.path, sourceShape, mappings);
+}
+
+// the offset of each time step in a dataset written by WriteField
+static std::vector<int64_t> StepOffsets(const XdmfSpecification::FieldDescription& field, std::size_t steps) {
+    std::vector<int64_t> offsets(steps, 0);
+    if (field.HasTimeDimension()) {
+        for (std::size_t step = 0; step < steps; step++) {
+            offsets[step] = (int64_t)(step * field.GetDof());
+        }
+    }
+    return offsets;
+}
+
+petscXdmfGenerator::VtkHdfBuilder::VtkHdfBuilder(std::shared_ptr<XdmfSpecification> specification) : specification(std::move(specification)) {}
+
+std::vector<std::filesystem::path> petscXdmfGenerator::VtkHdfBuilder::OutputFilePaths(const std::filesystem::path& outputFilePath) const {
+    std::vector<std::filesystem::path> outputFilePaths;
+    for (const auto& grid : specification->Grids()) {
+        if (outputFilePaths.empty()) {
+            outputFilePaths.push_back(outputFilePath);
+        } else {
+            auto gridFilePath = outputFilePath;
+            gridFilePath.replace_filename(outputFilePath.stem().string() + "." + grid.name + Extension);
+            outputFilePaths.push_back(gridFilePath);
+        }
+    }
+    return outputFilePaths;
+}
+
+std::vector<std::filesystem::path> petscXdmfGenerator::VtkHdfBuilder::Build(const std::filesystem::path& outputFilePath) const {
+    auto outputFilePaths = OutputFilePaths(outputFilePath);
+
+    // the hdf5 library is not thread safe
+    std::lock_guard<std::mutex> lock(HdfObject::LibraryMutex());
+    for (std::size_t g = 0; g < outputFilePaths.size(); g++) {
+        Build(specification->Grids()[g], outputFilePaths[g]);
+    }
+    return outputFilePaths;
+}
+
+void petscXdmfGenerator::VtkHdfBuilder::Build(const XdmfSpecification::GridDescription& grid, const std::filesystem::path& outputFilePath) const {
+    if (grid.hybridTopology.number > 0) {
+        throw std::invalid_argument("the grid " + grid.name + " has a hybrid topology, which cannot be written to vtkhdf");
+    }
+    if (grid.pointStride != 1) {
+        throw std::invalid_argument("the grid " + grid.name + " is a level of detail grid, which cannot be written to vtkhdf");
+    }
+    const auto& sourceFile = specification->Hdf5File();
+    const std::size_t steps = grid.time.empty() ? 1 : grid.time.size();
+    const hsize_t points = grid.geometry.GetDof();
+
+    // particles have no cells, so each point is a vertex
+    const bool vertices = grid.topology.numberCorners == 0;
+    hsize_t cells = points;
+    hsize_t corners = 1;
+    uint8_t cellType = VtkVertex;
+    if (!vertices) {
+        cells = grid.topology.number, corners = grid.topology.numberCorners;
+        auto dimension = vtkCellTypes.find(grid.topology.dimension);
+        if (dimension == vtkCellTypes.end() || dimension->second.count(corners) == 0) {
+            throw std::invalid_argument("the grid " + grid.name + " has " + std::to_string(corners) + " corner cells in " + std::to_string(grid.topology.dimension) + "D, which have no vtk cell type");
+        }
+        cellType = dimension->second.at(corners);
+    }
+
+    ScopedHid file(H5Fcreate(outputFilePath.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT), H5Fclose, "the file " + outputFilePath.string());
+    ScopedHid root(H5Gcreate(file, "VTKHDF", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT), H5Gclose, "the VTKHDF group");
+    WriteAttribute<int64_t>(root, "Version", {2, 0});
+    WriteAttribute(root, "Type", "UnstructuredGrid");
+
+    // a single partition that keeps the same size at every step
+    WriteValues<int64_t>(root, "NumberOfPoints", {(int64_t)points}, H5T_STD_I64LE);
+    WriteValues<int64_t>(root, "NumberOfCells", {(int64_t)cells}, H5T_STD_I64LE);
+    WriteValues<int64_t>(root, "NumberOfConnectivityIds", {(int64_t)(cells * corners)}, H5T_STD_I64LE);
+
+    // vtk always stores three coordinates
+    WriteField(root, "Points", sourceFile, grid, grid.geometry, steps, 3);
+
+    if (vertices) {
+        std::vector<int64_t> connectivity(points);
+        std::iota(connectivity.begin(), connectivity.end(), 0);
+        WriteValues(root, "Connectivity", connectivity, H5T_STD_I64LE);
+    } else {
+        const std::vector<hsize_t> cellShape = {cells, corners};
+        WriteVirtual(root, "Connectivity", FileType(grid.topology.dataType), {cells * corners}, sourceFile, grid.topology.path, cellShape,
+                     {Mapping{.sourceStart = {0, 0}, .sourceCount = cellShape, .virtualStart = {0}, .virtualCount = {cells * corners}}});
+    }
+    WriteConstant(root, "Types", cells, cellType);
+
+    std::vector<int64_t> offsets(cells + 1);
+    for (hsize_t c = 0; c <= cells; c++) {
+        offsets[c] = (int64_t)(c * corners);
+    }
+    WriteValues(root, "Offsets", offsets, H5T_STD_I64LE);
+
+    // fields are split by location
+    ScopedHid pointData(H5Gcreate(root, "PointData", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT), H5Gclose, "the PointData group");
+    ScopedHid cellData(H5Gcreate(root, "CellData", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT), H5Gclose, "the CellData group");
+    for (const auto& field : grid.fields) {
+        WriteField(field.fieldLocation == NODE ? pointData : cellData, field.name, sourceFile, grid, field, steps);
+    }
+
+    // steady state grids are not temporal
+    if (grid.time.empty()) {
+        return;
+    }
+    ScopedHid stepsGroup(H5Gcreate(root, "Steps", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT), H5Gclose, "the Steps group");
+    WriteAttribute<int64_t>(stepsGroup, "NSteps", {(int64_t)steps});
+    WriteValues(stepsGroup, "Values", grid.time, H5T_IEEE_F64LE);
+
+    // the partition, cells, and connectivity are shared by every step
+    const std::vector<int64_t> zeros(steps, 0);
+    WriteValues(stepsGroup, "PartOffsets", zeros, H5T_STD_I64LE);
+    WriteValues(stepsGroup, "NumberOfParts", std::vector<int64_t>(steps, 1), H5T_STD_I64LE);
+    WriteValues(stepsGroup, "PointOffsets", StepOffsets(grid.geometry, steps), H5T_STD_I64LE);
+    WriteValues(stepsGroup, "CellOffsets", zeros, H5T_STD_I64LE);
+    WriteValues(stepsGroup, "ConnectivityIdOffsets", zeros, H5T_STD_I64LE);
+
+    ScopedHid pointDataOffsets(H5Gcreate(stepsGroup, "PointDataOffsets", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT), H5Gclose, "the PointDataOffsets group");
+    ScopedHid cellDataOffsets(H5Gcreate(stepsGroup, "CellDataOffsets", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT), H5Gclose, "the CellDataOffsets group");
+    for (const auto& field : grid.fields) {
+        WriteValues(field.fieldLocation == NODE ? pointDataOffsets : cellDataOffsets, field.name, StepOffsets(field, steps), H5T_STD_I64LE);
+    }
+}
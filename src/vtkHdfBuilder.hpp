@@ -0,0 +1,47 @@
+#ifndef PETSCXDMFGENERATOR_VTKHDFBUILDER_HPP
+#define PETSCXDMFGENERATOR_VTKHDFBUILDER_HPP
+
+#include <filesystem>
+#include <memory>
+#include <vector>
+#include "xdmfSpecification.hpp"
+
+namespace petscXdmfGenerator {
+/**
+ * Writes a VTKHDF (version 2.0) UnstructuredGrid file for each grid in a specification.  The points, connectivity, and
+ * fields are virtual datasets that read straight from the PETSc datasets, so only the small arrays that PETSc does not
+ * store (cell types, offsets, and the temporal bookkeeping) are written and no heavy data is copied.  The virtual
+ * datasets name the hdf5 file relative to the output, so the output must stay next to the hdf5 file.
+ */
+class VtkHdfBuilder {
+   private:
+    const std::shared_ptr<XdmfSpecification> specification;
+
+    // writes a single grid to its own file
+    void Build(const XdmfSpecification::GridDescription& grid, const std::filesystem::path& outputFilePath) const;
+
+   public:
+    explicit VtkHdfBuilder(std::shared_ptr<XdmfSpecification> specification);
+
+    /**
+     * The file written for each grid.  The first grid is written to the output file path and every other grid is
+     * written next to it as <stem>.<grid name>.vtkhdf.
+     * @param outputFilePath
+     * @return
+     */
+    std::vector<std::filesystem::path> OutputFilePaths(const std::filesystem::path& outputFilePath) const;
+
+    /**
+     * Writes the file for each grid, replacing any existing files
+     * @param outputFilePath
+     * @return the files written
+     */
+    std::vector<std::filesystem::path> Build(const std::filesystem::path& outputFilePath) const;
+
+    /**
+     * The extension used for VTKHDF files
+     */
+    inline static const char* Extension = ".vtkhdf";
+};
+}  // namespace petscXdmfGenerator
+#endif  // PETSCXDMFGENERATOR_VTKHDFBUILDER_HPP
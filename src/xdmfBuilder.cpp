@@ -1,35 +1,69 @@
-
 #include "xdmfBuilder.hpp"
 #include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <exception>
 #include <map>
+#include <mutex>
+#include <sstream>
 #include <string>
+#include <thread>
 
 static const auto DataItem = "DataItem";
 static const auto Grid = "Grid";
 
 using namespace petscXdmfGenerator;
-static std::map<unsigned long long, std::map<unsigned long long, std::string>> cellMap = {{1, {{0, "Polyvertex"}, {1, "Polyvertex"}, {2, "Polyline"}}},
-                                                                                          {2, {{0, "Polyvertex"}, {3, "Triangle"}, {4, "Quadrilateral"}}},
-                                                                                          {3, {{0, "Polyvertex"}, {4, "Tetrahedron"}, {6, "Wedge"}, {8, "Hexahedron"}}}};
+// the tables are shared by every build thread, so they are only ever read with find or at
+static const std::map<unsigned long long, std::map<unsigned long long, std::string>> cellMap = {{1, {{0, "Polyvertex"}, {1, "Polyvertex"}, {2, "Polyline"}}},
+                                                                                                {2, {{0, "Polyvertex"}, {3, "Triangle"}, {4, "Quadrilateral"}}},
+                                                                                                {3, {{0, "Polyvertex"}, {4, "Tetrahedron"}, {6, "Wedge"}, {8, "Hexahedron"}}}};
 
-static std::map<FieldType, std::string> typeMap = {{SCALAR, "Scalar"}, {VECTOR, "Vector"}, {TENSOR, "Tensor6"}, {MATRIX, "Matrix"}};
+static const std::map<FieldType, std::string> typeMap = {{SCALAR, "Scalar"}, {VECTOR, "Vector"}, {TENSOR, "Tensor6"}, {MATRIX, "Matrix"}};
 
-static std::map<FieldLocation, std::string> locationMap = {{NODE, "Node"}, {CELL, "Cell"}};
+static const std::map<FieldLocation, std::string> locationMap = {{NODE, "Node"}, {CELL, "Cell"}};
 
-static std::map<unsigned long long, std::map<FieldType, std::vector<std::string>>> typeExt = {{2, {{VECTOR, {"x", "y"}}, {TENSOR, {"xx", "yy", "xy"}}}},
-                                                                                              {3, {{VECTOR, {"x", "y", "z"}}, {TENSOR, {"xx", "yy", "zz", "xy", "yz", "xz"}}}}};
+static const std::map<NumberType, std::string> numberTypeMap = {{FLOAT, "Float"}, {INT, "Int"}, {UINT, "UInt"}, {CHAR, "Char"}, {UCHAR, "UChar"}};
 
-XdmfBuilder::XdmfBuilder(std::shared_ptr<XdmfSpecification> specification) : specification(specification) {}
+static const std::map<unsigned long long, std::map<FieldType, std::vector<std::string>>> typeExt = {{2, {{VECTOR, {"x", "y"}}, {TENSOR, {"xx", "yy", "xy"}}}},
+                                                                                                    {3, {{VECTOR, {"x", "y", "z"}}, {TENSOR, {"xx", "yy", "zz", "xy", "yz", "xz"}}}}};
 
-std::unique_ptr<petscXdmfGenerator::XmlElement> petscXdmfGenerator::XdmfBuilder::Build() {
-    // build the preamble
+// looks up the xdmf name for a value, throwing instead of adding a missing value to the table
+template <typename Key>
+static const std::string& XdmfName(const std::map<Key, std::string>& names, Key key, const std::string& what) {
+    auto name = names.find(key);
+    if (name == names.end()) {
+        throw std::invalid_argument("there is no xdmf " + what + " for " + std::to_string(key));
+    }
+    return name->second;
+}
+
+static const std::string& TopologyType(const petscXdmfGenerator::XdmfSpecification::TopologyDescription& topology) {
+    if (auto cells = cellMap.find(topology.dimension); cells != cellMap.end()) {
+        if (auto name = cells->second.find(topology.numberCorners); name != cells->second.end()) {
+            return name->second;
+        }
+    }
+    throw std::invalid_argument("there is no xdmf topology for cells of dimension " + std::to_string(topology.dimension) + " with " + std::to_string(topology.numberCorners) + " corners in " +
+                                topology.path);
+}
+
+XdmfBuilder::XdmfBuilder(std::shared_ptr<XdmfSpecification> specification) : specifications({specification}) {}
+
+XdmfBuilder::XdmfBuilder(std::vector<std::shared_ptr<XdmfSpecification>> series, SeriesLayout layout) : specifications(std::move(series)), layout(layout) {
+    if (specifications.empty()) {
+        throw std::invalid_argument("at least one specification is required to build an xdmf file");
+    }
+}
+
+std::unique_ptr<petscXdmfGenerator::XmlElement> petscXdmfGenerator::XdmfBuilder::GenerateDocument() const {
+    // build the preamble with an entity for each file
     std::string preamble =
         "<?xml version=\"1.0\" ?>\n"
-        "<!DOCTYPE Xdmf SYSTEM \"Xdmf.dtd\" [\n"
-        "<!ENTITY HeavyData \"" +
-        specification->hdf5File +
-        "\">\n"
-        "]>";
+        "<!DOCTYPE Xdmf SYSTEM \"Xdmf.dtd\" [\n";
+    for (std::size_t s = 0; s < specifications.size(); s++) {
+        preamble += "<!ENTITY " + HeavyDataEntity(s) + " \"" + specifications[s]->hdf5File + "\">\n";
+    }
+    preamble += "]>";
 
     auto documentPointer = std::make_unique<XmlElement>("Xdmf", preamble);
     auto& document = *documentPointer;
@@ -38,52 +72,328 @@ std::unique_ptr<petscXdmfGenerator::XmlElement> petscXdmfGenerator::XdmfBuilder:
     auto& domainElement = document["Domain"];
     domainElement("Name") = "domain";
 
+    return documentPointer;
+}
+
+std::unique_ptr<petscXdmfGenerator::XmlElement> petscXdmfGenerator::XdmfBuilder::Build() {
+    auto documentPointer = GenerateDocument();
+    BuildDomain((*documentPointer)[0], nullptr, nullptr);
+    return documentPointer;
+}
+
+void petscXdmfGenerator::XdmfBuilder::Build(std::ostream& stream) { Build(stream, StepHooks()); }
+
+void petscXdmfGenerator::XdmfBuilder::Build(std::ostream& stream, const StepHooks& hooks) {
+    auto documentPointer = GenerateDocument();
+    auto& domainElement = (*documentPointer)[0];
+
+    // write the headers before any grid is generated
+    documentPointer->PrintOpen(stream, DocumentDepth, format);
+    domainElement.PrintOpen(stream, DomainDepth, format);
+
+    BuildDomain(domainElement, &stream, &hooks);
+
+    domainElement.PrintClose(stream, DomainDepth, format);
+    documentPointer->PrintClose(stream, DocumentDepth, format);
+}
+
+void petscXdmfGenerator::XdmfBuilder::BuildDomain(petscXdmfGenerator::XmlElement& domainElement, std::ostream* stream, const StepHooks* hooks) {
+    // each grid name gets a single collection, in the order first seen in the series
+    std::vector<std::string> gridNames;
+    for (const auto& specification : specifications) {
+        for (const auto& xdmfGrid : specification->grids) {
+            if (std::find(gridNames.begin(), gridNames.end(), xdmfGrid.name) == gridNames.end()) {
+                gridNames.push_back(xdmfGrid.name);
+            }
+        }
+    }
+
     // add in each grid
-    for (auto& xdmfGrid : specification->grids) {
-        // store a central reference for time invariant data
-        if (!xdmfGrid.geometry.HasTimeDimension()) {
-            if (xdmfGrid.topology.number > 0) {
-                WriteCells(domainElement, xdmfGrid.topology);
+    for (const auto& gridName : gridNames) {
+        // collect the grid from each file
+        std::vector<std::pair<std::size_t, XdmfSpecification::GridDescription*>> sources;
+        std::vector<double> time;
+        for (std::size_t s = 0; s < specifications.size(); s++) {
+            for (auto& xdmfGrid : specifications[s]->grids) {
+                if (xdmfGrid.name != gridName) {
+                    continue;
+                }
+                sources.emplace_back(s, &xdmfGrid);
+
+                // every partition holds the same steps, so the times come from the first partition
+                if (layout == SPATIAL_PARTITIONS) {
+                    if (sources.size() == 1) {
+                        time = xdmfGrid.time.empty() ? std::vector<double>{-1} : xdmfGrid.time;
+                    } else if (xdmfGrid.time != sources.front().second->time) {
+                        throw std::invalid_argument("each partition of " + gridName + " must hold the same times, " + specifications[s]->hdf5File + " does not match " +
+                                                    specifications[sources.front().first]->hdf5File);
+                    }
+                } else if (xdmfGrid.time.empty()) {
+                    // files without time are placed in the series by index
+                    time.push_back(specifications.size() > 1 ? (double)s : -1);  // make sure we do at least one time
+                } else {
+                    time.insert(time.end(), xdmfGrid.time.begin(), xdmfGrid.time.end());
+                }
             }
-            if (xdmfGrid.hybridTopology.number > 0) {
-                WriteCells(domainElement, xdmfGrid.hybridTopology);
+        }
+
+        // store a central reference for time invariant data
+        for (auto& [s, xdmfGrid] : sources) {
+            heavyDataIndex = s;
+            if (!xdmfGrid->geometry.HasTimeDimension()) {
+                if (xdmfGrid->topology.number > 0 && !ShareReference(xdmfGrid->topology.path)) {
+                    WriteCells(domainElement, xdmfGrid->topology);
+                }
+                if (xdmfGrid->hybridTopology.number > 0 && !ShareReference(xdmfGrid->hybridTopology.path)) {
+                    WriteCells(domainElement, xdmfGrid->hybridTopology);
+                }
+                // and the vertices
+                if (xdmfGrid->geometry.GetDof() > 0 && !ShareReference(xdmfGrid->geometry.path)) {
+                    WriteVertices(domainElement, xdmfGrid->geometry);
+                }
+            } else {
+                DeclareData(domainElement, xdmfGrid->geometry);
             }
-            // and the vertices
-            if (xdmfGrid.geometry.GetDof() > 0) {
-                WriteVertices(domainElement, xdmfGrid.geometry);
+
+            // time dependent data is declared once and each step selects its slab from the declaration
+            for (const auto& field : xdmfGrid->fields) {
+                if (field.HasTimeDimension()) {
+                    DeclareData(domainElement, field);
+                }
             }
         }
 
+        // when streaming, write out the time invariant data before any grid is generated
+        if (stream) {
+            domainElement.FlushChildren(*stream, DomainDepth, format);
+        }
+
         // check if we should use time
-        if (xdmfGrid.time.empty()) {
-            xdmfGrid.time.push_back(-1);  // make sure we do at least one time
+        auto useTime = !(time.size() < 2 && time[0] == -1);
+
+        // long time lists from a single file can be read from the time dataset instead, unless only some of the times are written
+        const XdmfSpecification::FieldDescription* timeDataset = nullptr;
+        if (timeReferenceThreshold > 0 && time.size() >= timeReferenceThreshold && sources.size() == 1 && !sources.front().second->timeDataset.path.empty() &&
+            sources.front().second->timeStart == 0 && time.size() == sources.front().second->timeDataset.shape.front()) {
+            heavyDataIndex = sources.front().first;
+            timeDataset = &sources.front().second->timeDataset;
         }
-        auto useTime = !(xdmfGrid.time.size() < 2 && xdmfGrid.time[0] == -1);
 
         // specify if we add each grid to the domain or a timeGridBase
-        auto& gridBase = useTime ? GenerateTimeGrid(domainElement, xdmfGrid.time) : domainElement;
+        auto& gridBase = useTime ? GenerateTimeGrid(domainElement, time, timeDataset) : domainElement;
+        const auto gridBaseDepth = useTime ? DomainDepth + 1 : DomainDepth;
 
-        // march over and add each grid for each time
-        for (std::size_t timeIndex = 0; timeIndex < xdmfGrid.time.size(); timeIndex++) {
-            auto gridTimeIndex = xdmfGrid.geometry.HasTimeDimension() ? timeIndex : TimeInvariant;
+        // when streaming, open the time grid and write out its time list, keeping only the open grid in memory
+        if (stream && useTime) {
+            gridBase.PrintOpen(*stream, gridBaseDepth, format);
+            gridBase.FlushChildren(*stream, gridBaseDepth, format);
+        }
 
-            // add in the hybrid header
-            auto& timeIndexBase = xdmfGrid.hybridTopology.number > 0 ? GenerateHybridSpaceGrid(gridBase, xdmfGrid.name) : gridBase;
-            if (xdmfGrid.hybridTopology.number > 0) {
-                GenerateSpaceGrid(timeIndexBase, xdmfGrid.hybridTopology, xdmfGrid.geometry, gridTimeIndex, xdmfGrid.name);
+        // steps that were already written are copied by the caller instead of being built again
+        std::size_t existingSteps = 0;
+        std::streampos stepsBegin = -1;
+        if (stream && useTime && hooks) {
+            stepsBegin = stream->tellp();
+            if (hooks->existingSteps.count(gridName)) {
+                existingSteps = hooks->existingSteps.at(gridName);
+                hooks->writeExistingSteps(gridName, *stream);
             }
+        }
 
-            // write the space header
-            auto& spaceGrid = GenerateSpaceGrid(timeIndexBase, xdmfGrid.topology, xdmfGrid.geometry, gridTimeIndex, xdmfGrid.name);
+        // collect each grid for each time in each file that needs to be built, a partitioned step builds every partition
+        partitions = layout == SPATIAL_PARTITIONS ? sources : decltype(sources)();
+        const auto stepSources = layout == SPATIAL_PARTITIONS ? decltype(sources){sources.front()} : sources;
+        std::vector<Step> steps;
+        std::size_t stepCount = 0;
+        for (auto& [s, xdmfGrid] : stepSources) {
+            const auto numberOfTimes = std::max<std::size_t>(1, xdmfGrid->time.size());
+            for (std::size_t timeIndex = 0; timeIndex < numberOfTimes; timeIndex++) {
+                if (stepCount++ >= existingSteps) {
+                    steps.push_back(Step{.specificationIndex = s, .grid = xdmfGrid, .timeIndex = timeIndex});
+                }
+            }
+        }
 
-            // add in each field
-            for (auto& field : xdmfGrid.fields) {
-                WriteField(spaceGrid, field, timeIndex);
+        if (stream && buildThreads != 1 && steps.size() > 1 && StepsOnlyUseReferences(sources)) {
+            BuildStepsInParallel(steps, gridBaseDepth, *stream);
+        } else {
+            for (const auto& step : steps) {
+                BuildStep(gridBase, step);
+
+                // each grid is written as soon as it is complete
+                if (stream) {
+                    gridBase.FlushChildren(*stream, gridBaseDepth, format);
+                }
             }
         }
+
+        if (stream && useTime && hooks && hooks->stepsWritten) {
+            hooks->stepsWritten(gridName, stepsBegin, stream->tellp());
+        }
+
+        // close the time grid (the only child left in the domain)
+        if (stream && useTime) {
+            gridBase.PrintClose(*stream, gridBaseDepth, format);
+            domainElement.ClearChildren();
+        }
     }
+}
 
-    return documentPointer;
+void petscXdmfGenerator::XdmfBuilder::BuildStep(petscXdmfGenerator::XmlElement& gridBase, const Step& step) {
+    if (partitions.empty()) {
+        BuildSpaceGrid(gridBase, step, step.grid->name);
+        return;
+    }
+
+    // each partition is a separate grid in the spatial collection for the step, named <grid>_<partition> so viewers can select each one
+    auto& spatialGrid = GenerateSpatialGrid(gridBase, step.grid->name);
+    for (std::size_t p = 0; p < partitions.size(); p++) {
+        const auto& [s, xdmfGrid] = partitions[p];
+        BuildSpaceGrid(spatialGrid, Step{.specificationIndex = s, .grid = xdmfGrid, .timeIndex = step.timeIndex}, step.grid->name + "_" + std::to_string(p));
+    }
+}
+
+void petscXdmfGenerator::XdmfBuilder::BuildSpaceGrid(petscXdmfGenerator::XmlElement& gridBase, const Step& step, const std::string& gridName) {
+    heavyDataIndex = step.specificationIndex;
+    auto xdmfGrid = step.grid;
+    pointStride = xdmfGrid->pointStride;
+
+    // the times may be a selection of the rows in the time dependent datasets
+    const auto timeRow = xdmfGrid->TimeRow(step.timeIndex);
+    auto gridTimeIndex = xdmfGrid->geometry.HasTimeDimension() ? timeRow : TimeInvariant;
+
+    // add in the hybrid header
+    auto& timeIndexBase = xdmfGrid->hybridTopology.number > 0 ? GenerateHybridSpaceGrid(gridBase, gridName) : gridBase;
+    if (xdmfGrid->hybridTopology.number > 0) {
+        GenerateSpaceGrid(timeIndexBase, xdmfGrid->hybridTopology, xdmfGrid->geometry, gridTimeIndex, gridName);
+    }
+
+    // write the space header
+    auto& spaceGrid = GenerateSpaceGrid(timeIndexBase, xdmfGrid->topology, xdmfGrid->geometry, gridTimeIndex, gridName);
+
+    // add in each field
+    for (auto& field : xdmfGrid->fields) {
+        WriteField(spaceGrid, field, timeRow, step.timeIndex);
+    }
+}
+
+bool petscXdmfGenerator::XdmfBuilder::StepsOnlyUseReferences(const std::vector<std::pair<std::size_t, XdmfSpecification::GridDescription*>>& sources) {
+    // time invariant cells and vertices without a reference are written into the first step that uses them
+    for (auto& [s, xdmfGrid] : sources) {
+        heavyDataIndex = s;
+        if (xdmfGrid->geometry.HasTimeDimension()) {
+            continue;
+        }
+        if (!HasReference(xdmfGrid->geometry.path)) {
+            return false;
+        }
+        if (xdmfGrid->topology.numberCorners != 0 && !HasReference(xdmfGrid->topology.path)) {
+            return false;
+        }
+        if (xdmfGrid->hybridTopology.number > 0 && xdmfGrid->hybridTopology.numberCorners != 0 && !HasReference(xdmfGrid->hybridTopology.path)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void petscXdmfGenerator::XdmfBuilder::BuildStepsInParallel(const std::vector<Step>& steps, std::size_t gridBaseDepth, std::ostream& stream) const {
+    const std::size_t numberOfThreads = std::min<std::size_t>(steps.size(), buildThreads == 0 ? std::max(1u, std::thread::hardware_concurrency()) : buildThreads);
+
+    // split the steps into blocks so that each thread builds several steps at a time
+    const std::size_t stepsPerBlock = std::max<std::size_t>(1, steps.size() / (numberOfThreads * BlocksPerThread));
+    const std::size_t numberOfBlocks = (steps.size() + stepsPerBlock - 1) / stepsPerBlock;
+
+    // only a limited number of blocks are built ahead of the block being written
+    const std::size_t maximumBlocksAhead = numberOfThreads * 2;
+
+    struct Block {
+        std::string text;
+        bool built = false;
+    };
+    std::vector<Block> blocks(numberOfBlocks);
+    std::size_t nextBlock = 0;
+    std::size_t blocksWritten = 0;
+    std::exception_ptr error;
+    std::mutex mutex;
+    std::condition_variable blockChanged;
+
+    auto buildBlocks = [&]() {
+        // each thread uses its own copy of the references and its own document
+        XdmfBuilder builder(*this);
+        XmlElement gridBase("Grid");
+        std::ostringstream blockText;
+
+        while (true) {
+            std::size_t block;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                blockChanged.wait(lock, [&] { return error || nextBlock >= numberOfBlocks || nextBlock < blocksWritten + maximumBlocksAhead; });
+                if (error || nextBlock >= numberOfBlocks) {
+                    return;
+                }
+                block = nextBlock++;
+            }
+
+            try {
+                blockText.str("");
+                const auto end = std::min(steps.size(), (block + 1) * stepsPerBlock);
+                for (auto step = block * stepsPerBlock; step < end; step++) {
+                    builder.BuildStep(gridBase, steps[step]);
+                    gridBase.FlushChildren(blockText, gridBaseDepth, format);
+                }
+
+                std::lock_guard<std::mutex> lock(mutex);
+                blocks[block].text = blockText.str();
+                blocks[block].built = true;
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                error = std::current_exception();
+            }
+            blockChanged.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < numberOfThreads; t++) {
+        threads.emplace_back(buildBlocks);
+    }
+
+    // write each block in order as soon as it is built
+    for (std::size_t block = 0; block < numberOfBlocks; block++) {
+        std::string text;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            blockChanged.wait(lock, [&] { return error || blocks[block].built; });
+            if (error) {
+                break;
+            }
+            text = std::move(blocks[block].text);
+        }
+
+        // a failed write stops the build threads so that they are joined before the error reaches the caller
+        bool failed = false;
+        try {
+            stream << text;
+            std::lock_guard<std::mutex> lock(mutex);
+            blocksWritten = block + 1;
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            error = std::current_exception();
+            failed = true;
+        }
+        blockChanged.notify_all();
+        if (failed) {
+            break;
+        }
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
 }
 
 void petscXdmfGenerator::XdmfBuilder::WriteCells(petscXdmfGenerator::XmlElement& element, const XdmfSpecification::TopologyDescription& topologyDescription, unsigned long long timeStep) {
@@ -95,10 +405,10 @@ void petscXdmfGenerator::XdmfBuilder::WriteCells(petscXdmfGenerator::XmlElement&
         dataItem("Name") = Hdf5PathToName(topologyDescription.path);
         dataItem("ItemType") = "Uniform";
         dataItem("Format") = "HDF";
-        dataItem("Precision") = "8";
-        dataItem("NumberType") = "Float";
+        dataItem("Precision") = std::to_string(topologyDescription.dataType.precision);
+        dataItem("NumberType") = XdmfName(numberTypeMap, topologyDescription.dataType.numberType, "number type");
         dataItem("Dimensions") = std::to_string(topologyDescription.number) + " " + std::to_string(topologyDescription.numberCorners);
-        dataItem() = "&HeavyData;:" + topologyDescription.path;
+        dataItem() = HeavyDataPath(topologyDescription.path);
 
         if (timeStep == TimeInvariant) {
             AddReference(topologyDescription.path, dataItem.Path());
@@ -118,7 +428,8 @@ void petscXdmfGenerator::XdmfBuilder::WriteVertices(petscXdmfGenerator::XmlEleme
     }
 }
 
-petscXdmfGenerator::XmlElement& petscXdmfGenerator::XdmfBuilder::GenerateTimeGrid(petscXdmfGenerator::XmlElement& element, const std::vector<double>& time) {
+petscXdmfGenerator::XmlElement& petscXdmfGenerator::XdmfBuilder::GenerateTimeGrid(petscXdmfGenerator::XmlElement& element, const std::vector<double>& time,
+                                                                                  const XdmfSpecification::FieldDescription* timeDataset) {
     auto& gridItem = element[Grid];
     gridItem("Name") = "TimeSeries";
     gridItem("GridType") = "Collection";
@@ -128,10 +439,18 @@ petscXdmfGenerator::XmlElement& petscXdmfGenerator::XdmfBuilder::GenerateTimeGri
     timeElement("TimeType") = "List";
 
     auto& dataItem = timeElement[DataItem];
-    dataItem("Format") = "XML";
-    dataItem("NumberType") = "Float";
-    dataItem("Dimensions") = std::to_string(time.size());
-    dataItem() = JoinVector(time);
+    if (timeDataset) {
+        dataItem("DataType") = XdmfName(numberTypeMap, timeDataset->dataType.numberType, "number type");
+        dataItem("Dimensions") = JoinVector(timeDataset->shape);
+        dataItem("Format") = "HDF";
+        dataItem("Precision") = std::to_string(timeDataset->dataType.precision);
+        dataItem() = HeavyDataPath(timeDataset->path);
+    } else {
+        dataItem("Format") = "XML";
+        dataItem("NumberType") = "Float";
+        dataItem("Dimensions") = std::to_string(time.size());
+        dataItem() = JoinVector(time);
+    }
 
     return gridItem;
 }
@@ -143,6 +462,14 @@ petscXdmfGenerator::XmlElement& petscXdmfGenerator::XdmfBuilder::GenerateHybridS
     return hybridGridItem;
 }
 
+petscXdmfGenerator::XmlElement& petscXdmfGenerator::XdmfBuilder::GenerateSpatialGrid(petscXdmfGenerator::XmlElement& element, const std::string& domainName) {
+    auto& spatialGridItem = element[Grid];
+    spatialGridItem("Name") = domainName;
+    spatialGridItem("GridType") = "Collection";
+    spatialGridItem("CollectionType") = "Spatial";
+    return spatialGridItem;
+}
+
 petscXdmfGenerator::XmlElement& petscXdmfGenerator::XdmfBuilder::GenerateSpaceGrid(petscXdmfGenerator::XmlElement& element, const XdmfSpecification::TopologyDescription& topologyDescription,
                                                                                    const XdmfSpecification::FieldDescription& geometryDescription, unsigned long long timeStep,
                                                                                    const std::string& domainName) {
@@ -152,9 +479,9 @@ petscXdmfGenerator::XmlElement& petscXdmfGenerator::XdmfBuilder::GenerateSpaceGr
 
     {
         auto& topology = gridItem["Topology"];
-        topology("TopologyType") = cellMap[topologyDescription.dimension][topologyDescription.numberCorners];
+        topology("TopologyType") = TopologyType(topologyDescription);
         if (topologyDescription.numberCorners == 0) {
-            topology("NodesPerElement") = std::to_string(topologyDescription.number);
+            topology("NodesPerElement") = std::to_string((topologyDescription.number + pointStride - 1) / pointStride);
 
         } else {
             topology("NumberOfElements") = std::to_string(topologyDescription.number);
@@ -169,58 +496,146 @@ petscXdmfGenerator::XmlElement& petscXdmfGenerator::XdmfBuilder::GenerateSpaceGr
     return gridItem;
 }
 
+void petscXdmfGenerator::XdmfBuilder::DeclareData(petscXdmfGenerator::XmlElement& element, const petscXdmfGenerator::XdmfSpecification::FieldDescription& fieldDescription) {
+    // a dataset may already be declared by another grid
+    if (HasReference(fieldDescription.path)) {
+        return;
+    }
+
+    auto& dataItem = element[DataItem];
+    dataItem("Name") = Hdf5PathToName(fieldDescription.path);
+    dataItem("DataType") = XdmfName(numberTypeMap, fieldDescription.dataType.numberType, "number type");
+    dataItem("Dimensions") = JoinVector(fieldDescription.shape);
+    dataItem("Format") = "HDF";
+    dataItem("Precision") = std::to_string(fieldDescription.dataType.precision);
+    dataItem() = HeavyDataPath(fieldDescription.path);
+    AddReference(fieldDescription.path, dataItem.Path());
+}
+
 XmlElement& petscXdmfGenerator::XdmfBuilder::WriteData(petscXdmfGenerator::XmlElement& element, const petscXdmfGenerator::XdmfSpecification::FieldDescription& fieldDescription,
-                                                       unsigned long long timeStep) {
+                                                       unsigned long long timeStep, const XdmfSpecification::ComponentDescription* component) {
     // determine if we need to use a HyperSlab
     if (fieldDescription.HasTimeDimension()) {
+        // a component selects a single value from each point in the field
+        const unsigned long long componentOffset = component ? component->offset : 0;
+        const unsigned long long componentStride = component ? fieldDescription.GetDimension() : 1;
+        const unsigned long long componentDimension = component ? 1 : fieldDescription.GetDimension();
+
+        // a level of detail grid reads every nth point
+        const unsigned long long pointCount = (fieldDescription.GetDof() + pointStride - 1) / pointStride;
+
         auto& dataItem = element[DataItem];
         dataItem("ItemType") = "HyperSlab";
-        dataItem("Dimensions") = Join(1, fieldDescription.GetDof(), fieldDescription.GetDimension());
+        dataItem("Dimensions") = Join(1, pointCount, componentDimension);
         dataItem("Type") = "HyperSlab";
 
         {
             auto& dataItemItem = dataItem[DataItem];
             dataItemItem("Dimensions") = Join(3, 3);
             dataItemItem("Format") = "XML";
-            dataItemItem() = Join(timeStep, 0, fieldDescription.componentOffset) + " " + Join(1, 1, fieldDescription.componentStride) + " " +
-                             Join(1, fieldDescription.GetDof(), fieldDescription.GetDimension());  // start, stride, size
+            dataItemItem() = Join(timeStep, 0, componentOffset, 1, pointStride, componentStride, 1, pointCount, componentDimension);  // start, stride, size
         }
-        {
+        if (HasReference(fieldDescription.path)) {
+            UseReference(dataItem, fieldDescription.path);
+        } else {
             auto& dataItemItem = dataItem[DataItem];
-            dataItemItem("DataType") = "Float";
+            dataItemItem("DataType") = XdmfName(numberTypeMap, fieldDescription.dataType.numberType, "number type");
             dataItemItem("Dimensions") = JoinVector(fieldDescription.shape);
             dataItemItem("Format") = "HDF";
-            dataItemItem("Precision") = "8";
-            dataItemItem() = "&HeavyData;:" + fieldDescription.path;
+            dataItemItem("Precision") = std::to_string(fieldDescription.dataType.precision);
+            dataItemItem() = HeavyDataPath(fieldDescription.path);
         }
         return dataItem;
     } else {
         auto& dataItemItem = element[DataItem];
         dataItemItem("Name") = Hdf5PathToName(fieldDescription.path);
-        dataItemItem("DataType") = "Float";
+        dataItemItem("DataType") = XdmfName(numberTypeMap, fieldDescription.dataType.numberType, "number type");
         dataItemItem("Dimensions") = JoinVector(fieldDescription.shape);
         dataItemItem("Format") = "HDF";
-        dataItemItem("Precision") = "8";
-        dataItemItem() = "&HeavyData;:" + fieldDescription.path;
+        dataItemItem("Precision") = std::to_string(fieldDescription.dataType.precision);
+        dataItemItem() = HeavyDataPath(fieldDescription.path);
         return dataItemItem;
     }
 }
 
-void petscXdmfGenerator::XdmfBuilder::WriteField(petscXdmfGenerator::XmlElement& element, petscXdmfGenerator::XdmfSpecification::FieldDescription& fieldDescription, unsigned long long timeStep) {
+void petscXdmfGenerator::XdmfBuilder::WriteField(petscXdmfGenerator::XmlElement& element, petscXdmfGenerator::XdmfSpecification::FieldDescription& fieldDescription, unsigned long long timeStep,
+                                                 std::size_t timeIndex) {
+    // each component is written as a scalar view of the shared field data
+    for (const auto& component : fieldDescription.components) {
+        auto& attribute = element["Attribute"];
+        attribute("Name") = component.name;
+        attribute("Type") = XdmfName(typeMap, SCALAR, "attribute type");
+        attribute("Center") = XdmfName(locationMap, fieldDescription.fieldLocation, "attribute center");
+
+        WriteSummary(attribute, fieldDescription, timeIndex, &component);
+        WriteData(attribute, fieldDescription, timeStep, &component);
+    }
+    if (!fieldDescription.components.empty()) {
+        return;
+    }
+
     auto& attribute = element["Attribute"];
     attribute("Name") = fieldDescription.name;
-    attribute("Type") = typeMap[fieldDescription.fieldType];
-    attribute("Center") = locationMap[fieldDescription.fieldLocation];
+    attribute("Type") = XdmfName(typeMap, fieldDescription.fieldType, "attribute type");
+    attribute("Center") = XdmfName(locationMap, fieldDescription.fieldLocation, "attribute center");
 
+    WriteSummary(attribute, fieldDescription, timeIndex);
     WriteData(attribute, fieldDescription, timeStep);
 }
 
+void petscXdmfGenerator::XdmfBuilder::WriteSummary(petscXdmfGenerator::XmlElement& attribute, const XdmfSpecification::FieldDescription& fieldDescription, std::size_t timeIndex,
+                                                   const XdmfSpecification::ComponentDescription* component) {
+    // the summaries hold a row for each time in the grid's time list, not for each row of the dataset
+    const auto columns = fieldDescription.componentDimension;
+    const auto row = fieldDescription.HasTimeDimension() ? timeIndex : 0;
+    if (columns == 0 || (row + 1) * columns > fieldDescription.summaries.size()) {
+        return;
+    }
+
+    // a component uses its own summary, the whole field combines every component (each holds the same number of points)
+    const auto first = fieldDescription.summaries.begin() + (std::ptrdiff_t)(row * columns + (component ? component->offset : 0));
+    const auto last = component ? first + 1 : first + (std::ptrdiff_t)columns;
+    auto minimum = first->minimum, maximum = first->maximum, mean = 0.0;
+    for (auto summary = first; summary != last; ++summary) {
+        minimum = std::fmin(minimum, summary->minimum);
+        maximum = std::fmax(maximum, summary->maximum);
+        mean += summary->mean / (double)(last - first);
+    }
+
+    auto& range = attribute["Information"];
+    range("Name") = "Range";
+    range("Value") = Join(minimum, maximum);
+    auto& average = attribute["Information"];
+    average("Name") = "Mean";
+    average("Value") = Join(mean);
+}
+
 void XdmfBuilder::UseReference(XmlElement& element, std::string id) {
     auto& reference = element[DataItem];
     reference("Reference") = "XML";
-    reference() = xmlReferences.at(id);
+    reference() = xmlReferences.at(HeavyDataPath(id));
 }
+bool XdmfBuilder::ShareReference(const std::string& hdf5Path) {
+    auto shared = sharedHeavyData.find({heavyDataIndex, hdf5Path});
+    if (shared == sharedHeavyData.end()) {
+        return false;
+    }
+
+    // the earlier file must already hold the reference, which is true for any file earlier in the series
+    const auto index = heavyDataIndex;
+    heavyDataIndex = shared->second;
+    auto source = xmlReferences.find(HeavyDataPath(hdf5Path));
+    heavyDataIndex = index;
+    if (source == xmlReferences.end()) {
+        return false;
+    }
+    xmlReferences[HeavyDataPath(hdf5Path)] = source->second;
+    return true;
+}
+
 std::string XdmfBuilder::Hdf5PathToName(std::string hdf5Path) {
     std::replace(hdf5Path.begin(), hdf5Path.end(), '/', '_');
-    return hdf5Path;
+
+    // names must be unique across every file in a series
+    return specifications.size() > 1 ? HeavyDataEntity(heavyDataIndex) + hdf5Path : hdf5Path;
 }
@@ -1,69 +1,219 @@
 #ifndef PETSCXDMFGENERATOR_XDMF_HPP
 #define PETSCXDMFGENERATOR_XDMF_HPP
 
-#include <numeric>
-#include <sstream>
+#include <charconv>
+#include <functional>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 #include "hdfObject.hpp"
 #include "xdmfSpecification.hpp"
 #include "xmlElement.hpp"
 
 namespace petscXdmfGenerator {
+/**
+ * How the specifications given to a builder are combined: one file per time step range, or one file per partition of the domain
+ */
+enum SeriesLayout { TEMPORAL_SERIES, SPATIAL_PARTITIONS };
+
 class XdmfBuilder {
+   public:
+    /**
+     * Hooks that allow a streamed document to reuse steps that were written by a previous build
+     */
+    struct StepHooks {
+        // the number of leading steps in each grid's time collection that should not be built again
+        std::map<std::string, std::size_t> existingSteps;
+
+        // writes the existing steps for the named grid to the stream
+        std::function<void(const std::string& gridName, std::ostream& stream)> writeExistingSteps;
+
+        // reports where the steps for each grid's time collection were written in the stream
+        std::function<void(const std::string& gridName, std::streampos begin, std::streampos end)> stepsWritten;
+    };
+
    private:
-    const std::shared_ptr<XdmfSpecification> specification;
+    // a single file, or one specification per file in a temporal series
+    const std::vector<std::shared_ptr<XdmfSpecification>> specifications;
+    const SeriesLayout layout = TEMPORAL_SERIES;
     std::map<std::string, std::string> xmlReferences;
 
+    // the earlier specification holding an identical copy of a time invariant dataset, by specification index and dataset path
+    std::map<std::pair<std::size_t, std::string>, std::size_t> sharedHeavyData;
+
+    // the index of the specification (file) currently being written
+    std::size_t heavyDataIndex = 0;
+
+    // the rows between each point read by the grid currently being written
+    unsigned long long pointStride = 1;
+
+    // the number of threads used to build the steps when streaming, zero uses the hardware concurrency
+    std::size_t buildThreads = 1;
+
+    // the format used when streaming
+    XmlFormat format = PRETTY;
+
+    // time lists with at least this many values reference the time dataset instead of being written out, zero always writes them
+    std::size_t timeReferenceThreshold = 0;
+
+    // a single grid at a single time in a time collection
+    struct Step {
+        std::size_t specificationIndex;
+        XdmfSpecification::GridDescription* grid;
+        std::size_t timeIndex;
+    };
+
+    // the grid from each partition file for the grid being built, every step holds each partition when the layout is spatial
+    std::vector<std::pair<std::size_t, XdmfSpecification::GridDescription*>> partitions;
+
     // store constant values
     inline const static unsigned long long TimeInvariant = -1;
+    inline const static std::size_t DocumentDepth = 0;
+    inline const static std::size_t DomainDepth = 1;
+    inline const static std::size_t BlocksPerThread = 4;
+    inline const static std::size_t MaximumNumberLength = 32;
+
+    // create the Xdmf document with an empty domain
+    std::unique_ptr<XmlElement> GenerateDocument() const;
+
+    // add each grid to the domain, writing and releasing each grid as it is completed if a stream is provided
+    void BuildDomain(XmlElement& domainElement, std::ostream* stream, const StepHooks* hooks);
+
+    // add the grid for a single step to the grid base, a spatial collection of every partition when partitioned
+    void BuildStep(XmlElement& gridBase, const Step& step);
+
+    // add the grid for a single step from a single file, named gridName
+    void BuildSpaceGrid(XmlElement& gridBase, const Step& step, const std::string& gridName);
+
+    // true if building the steps in the grid only reads the shared references
+    bool StepsOnlyUseReferences(const std::vector<std::pair<std::size_t, XdmfSpecification::GridDescription*>>& sources);
+
+    // build blocks of steps on separate threads and write the text of each block in order
+    void BuildStepsInParallel(const std::vector<Step>& steps, std::size_t gridBaseDepth, std::ostream& stream) const;
 
     // internal helper  write functions
     void WriteCells(petscXdmfGenerator::XmlElement& element, const XdmfSpecification::TopologyDescription& topologyDescription, unsigned long long timeStep = TimeInvariant);
     void WriteVertices(XmlElement& element, const XdmfSpecification::FieldDescription& geometryDescription, unsigned long long timeStep = TimeInvariant);
-    XmlElement& WriteData(petscXdmfGenerator::XmlElement& element, const petscXdmfGenerator::XdmfSpecification::FieldDescription& fieldDescription, unsigned long long timeStep);
-    void WriteField(petscXdmfGenerator::XmlElement& element, petscXdmfGenerator::XdmfSpecification::FieldDescription& fieldDescription, unsigned long long timeStep);
-    static XmlElement& GenerateTimeGrid(XmlElement& element, const std::vector<double>& time);
+    void DeclareData(XmlElement& element, const XdmfSpecification::FieldDescription& fieldDescription);
+    XmlElement& WriteData(petscXdmfGenerator::XmlElement& element, const petscXdmfGenerator::XdmfSpecification::FieldDescription& fieldDescription, unsigned long long timeStep,
+                          const XdmfSpecification::ComponentDescription* component = nullptr);
+    void WriteField(petscXdmfGenerator::XmlElement& element, petscXdmfGenerator::XdmfSpecification::FieldDescription& fieldDescription, unsigned long long timeStep, std::size_t timeIndex);
+    static void WriteSummary(XmlElement& attribute, const XdmfSpecification::FieldDescription& fieldDescription, std::size_t timeIndex,
+                             const XdmfSpecification::ComponentDescription* component = nullptr);
+    XmlElement& GenerateTimeGrid(XmlElement& element, const std::vector<double>& time, const XdmfSpecification::FieldDescription* timeDataset);
     static XmlElement& GenerateHybridSpaceGrid(XmlElement& element, const std::string& domainName);
+    static XmlElement& GenerateSpatialGrid(XmlElement& element, const std::string& domainName);
     XmlElement& GenerateSpaceGrid(XmlElement& element, const XdmfSpecification::TopologyDescription& topologyDescription, const XdmfSpecification::FieldDescription& geometryDescription,
                                   unsigned long long timeStep, const std::string& domainName);
 
+    // appends the shortest text that reads back as exactly the same value
     template <typename T>
-    inline static std::string toString(T value) {
-        std::stringstream asString;
-        asString << value;
-        return asString.str();
+    inline static void AppendValue(std::string& text, const T& value) {
+        if constexpr (std::is_arithmetic_v<T>) {
+            char buffer[MaximumNumberLength];
+            auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            text.append(buffer, result.ptr);
+        } else {
+            text += value;
+        }
     }
 
     template <typename T>
-    inline static std::string JoinVector(const std::vector<T>& vector, const std::string&& delim = " ") {
-        std::string joined = std::accumulate(begin(vector), end(vector), std::string{}, [&delim](std::string r, T p) { return r.empty() ? toString(p) : std::move(r) + delim + toString(p); });
+    inline static std::string JoinVector(const std::vector<T>& vector, std::string_view delim = " ") {
+        std::string joined;
+        joined.reserve(vector.size() * ((std::is_floating_point_v<T> ? 12 : 6) + delim.size()));
+        for (std::size_t i = 0; i < vector.size(); i++) {
+            if (i > 0) {
+                joined += delim;
+            }
+            AppendValue(joined, vector[i]);
+        }
         return joined;
     }
 
     template <typename... Types>
-    inline static std::string Join(Types&&... args) {
-        std::stringstream joined;
-        ((joined << args << ' '), ...);
-
-        auto joinedString = joined.str();
-        if (!joinedString.empty()) {
-            joinedString.pop_back();
+    inline static std::string Join(const Types&... args) {
+        std::string joined;
+        ((AppendValue(joined, args), joined += ' '), ...);
+        if (!joined.empty()) {
+            joined.pop_back();
         }
-        return joinedString;
+        return joined;
     }
 
     std::string Hdf5PathToName(std::string hdf5Path);
 
-    inline void AddReference(const std::string& hdf5Path, const std::string& xmlPath) { xmlReferences[hdf5Path] = xmlPath + "[@Name=\"" + Hdf5PathToName(hdf5Path) + "\"]"; }
+    // the xml entity that holds the file name for each specification
+    std::string HeavyDataEntity(std::size_t index) const { return specifications.size() > 1 ? "HeavyData" + std::to_string(index) : "HeavyData"; }
+
+    // the DataItem value pointing to the dataset in the current file
+    inline std::string HeavyDataPath(const std::string& hdf5Path) const { return "&" + HeavyDataEntity(heavyDataIndex) + ";:" + hdf5Path; }
+
+    inline void AddReference(const std::string& hdf5Path, const std::string& xmlPath) { xmlReferences[HeavyDataPath(hdf5Path)] = xmlPath + "[@Name=\"" + Hdf5PathToName(hdf5Path) + "\"]"; }
 
-    inline bool HasReference(const std::string& hdf5Path) { return xmlReferences.count(hdf5Path) != 0; }
+    inline bool HasReference(const std::string& hdf5Path) { return xmlReferences.count(HeavyDataPath(hdf5Path)) != 0; }
 
     void UseReference(XmlElement& element, std::string id);
 
+    // points the current file's dataset at the reference of an identical dataset in an earlier file, false if it is not shared
+    bool ShareReference(const std::string& hdf5Path);
+
    public:
     explicit XdmfBuilder(std::shared_ptr<XdmfSpecification> specification);
+
+    /**
+     * Builds a single temporal collection from a series of files.  In a temporal series each time step points at its
+     * own file, while partitions of the same steps (such as one file per rank group) produce a spatial collection of
+     * uniform grids for each step, one for each partition, so that viewers can load the partitions in parallel.
+     * @param series the specification for each file in time order, or for each partition
+     * @param layout how the files are combined
+     */
+    explicit XdmfBuilder(std::vector<std::shared_ptr<XdmfSpecification>> series, SeriesLayout layout = TEMPORAL_SERIES);
     std::unique_ptr<XmlElement> Build();
+
+    /**
+     * Sets the number of threads used to build the steps of each time collection when streaming.  Each thread builds
+     * its own blocks of steps and the blocks are written in order, so the output is identical to a serial build.
+     * @param threads the number of threads, or zero to use the hardware concurrency
+     */
+    void SetBuildThreads(std::size_t threads) { buildThreads = threads; }
+
+    /**
+     * Sets the format used when streaming the document
+     * @param format
+     */
+    void SetFormat(XmlFormat format) { this->format = format; }
+
+    /**
+     * Sets the number of time values at which the time list references the time dataset in the hdf5 file instead
+     * of being written into the document.  Only a grid whose times all come from a single file can be referenced.
+     * @param threshold the number of values, or zero to always write the values
+     */
+    void SetTimeReferenceThreshold(std::size_t threshold) { timeReferenceThreshold = threshold; }
+
+    /**
+     * Marks a time invariant dataset in one file of a series as identical to the same dataset in an earlier file.
+     * Every step then references the earlier file's DataItem, so viewers can reuse the mesh instead of reading it again.
+     * @param specificationIndex the file holding the duplicate
+     * @param hdf5Path the path of the dataset in both files
+     * @param sourceIndex the earlier file whose dataset is referenced
+     */
+    void ShareHeavyData(std::size_t specificationIndex, const std::string& hdf5Path, std::size_t sourceIndex) { sharedHeavyData[{specificationIndex, hdf5Path}] = sourceIndex; }
+
+    /**
+     * Builds and writes the document directly to the stream.  Each grid is written and released as soon as it is
+     * produced, so memory use does not grow with the number of time steps.
+     * @param stream
+     */
+    void Build(std::ostream& stream);
+
+    /**
+     * Builds and writes the document directly to the stream, skipping any existing steps in each time collection
+     * @param stream
+     * @param hooks
+     */
+    void Build(std::ostream& stream, const StepHooks& hooks);
 };
 }  // namespace petscXdmfGenerator
 
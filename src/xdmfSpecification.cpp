@@ -1,16 +1,109 @@
 #include "xdmfSpecification.hpp"
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
 #include <stdexcept>
+#include "hdfObject.hpp"
+#include "json.hpp"
 
 using namespace petscXdmfGenerator;
 
 const static std::map<std::string, FieldType> petscTypeLookUpFromFieldType = {{"scalar", SCALAR}, {"vector", VECTOR}, {"tensor", TENSOR}, {"matrix", MATRIX}};
 const static std::map<int, FieldType> petscTypeLookUpFromNC = {{1, SCALAR}, {2, VECTOR}, {3, VECTOR}};
 
+// identify the binary format, the version is written in native byte order so files from another byte order are rejected
+const static char binaryMagic[8] = {'P', 'X', 'S', 'P', 'E', 'C', '\0', '\0'};
+const static uint32_t binaryVersion = 8;
+
+// identify the json layout, which only changes when the meaning of an existing member changes
+const static char* jsonFormat = "petscXdmfGenerator.specification";
+const static unsigned long long jsonVersion = 1;
+
+// the json names for each enum
+const static std::vector<std::string> fieldLocationNames = {"NODE", "CELL"};
+const static std::vector<std::string> fieldTypeNames = {"SCALAR", "VECTOR", "TENSOR", "MATRIX", "NONE"};
+const static std::vector<std::string> numberTypeNames = {"FLOAT", "INT", "UINT", "CHAR", "UCHAR"};
+
+template <typename T>
+static T EnumFromJson(const JsonValue& value, const std::vector<std::string>& names) {
+    auto name = std::find(names.begin(), names.end(), value.String());
+    if (name == names.end()) {
+        throw std::runtime_error("unknown specification value " + value.String());
+    }
+    return static_cast<T>(name - names.begin());
+}
+
+template <typename T>
+static void WriteValue(std::ostream& stream, const T& value) {
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+static T ReadValue(std::istream& stream) {
+    T value;
+    if (!stream.read(reinterpret_cast<char*>(&value), sizeof(T))) {
+        throw std::runtime_error("unexpected end of binary specification");
+    }
+    return value;
+}
+
+static void WriteString(std::ostream& stream, const std::string& value) {
+    WriteValue<uint64_t>(stream, value.size());
+    stream.write(value.data(), value.size());
+}
+
+// reads the number of items that follow, checking that the stream still holds at least the given bytes for each so a
+// corrupt length is rejected before anything is allocated for it
+static std::size_t ReadCount(std::istream& stream, std::size_t bytesEach) {
+    const auto count = ReadValue<uint64_t>(stream);
+    const auto position = stream.tellg();
+    if (position < 0) {
+        return count;
+    }
+    stream.seekg(0, std::ios::end);
+    const auto remaining = (uint64_t)(stream.tellg() - position);
+    stream.seekg(position);
+    if (!stream || count > remaining / std::max<std::size_t>(bytesEach, 1)) {
+        throw std::runtime_error("binary specification holds " + std::to_string(count) + " items but only " + std::to_string(remaining) + " bytes remain");
+    }
+    return count;
+}
+
+static std::string ReadString(std::istream& stream) {
+    std::string value(ReadCount(stream, 1), '\0');
+    if (!stream.read(value.data(), value.size())) {
+        throw std::runtime_error("unexpected end of binary specification");
+    }
+    return value;
+}
+
+template <typename T>
+static void WriteVector(std::ostream& stream, const std::vector<T>& values) {
+    WriteValue<uint64_t>(stream, values.size());
+    stream.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+
+template <typename T>
+static std::vector<T> ReadVector(std::istream& stream) {
+    std::vector<T> values(ReadCount(stream, sizeof(T)));
+    if (!stream.read(reinterpret_cast<char*>(values.data()), values.size() * sizeof(T))) {
+        throw std::runtime_error("unexpected end of binary specification");
+    }
+    return values;
+}
+
 void petscXdmfGenerator::XdmfSpecification::GenerateFieldsFromPetsc(std::vector<FieldDescription>& fields, const std::vector<std::shared_ptr<petscXdmfGenerator::HdfObject>>& hdfFields,
                                                                     petscXdmfGenerator::FieldLocation location) {
     for (auto& hdfField : hdfFields) {
-        FieldDescription description{.name = hdfField->Name(), .path = hdfField->Path(), .shape = hdfField->Shape(), .fieldLocation = location};
+        // only datasets can be fields
+        if (hdfField->Type() != H5O_TYPE_DATASET) {
+            continue;
+        }
+        FieldDescription description{.name = hdfField->Name(), .path = hdfField->Path(), .shape = hdfField->Shape(), .fieldLocation = location, .dataType = DataTypeFromHdf(*hdfField)};
 
         if (hdfField->HasAttribute("vector_field_type")) {
             auto vector_field_type = hdfField->AttributeString("vector_field_type");
@@ -45,28 +138,251 @@ void petscXdmfGenerator::XdmfSpecification::GenerateFieldsFromPetsc(std::vector<
         // determine the dimensions from the shape
         description.componentDimension = description.shape.size() > 2 ? description.shape[2] : description.shape[1];
 
-        // If this is a components field, separate into each component
+        // If this is a components field, add a view for each component
         if (description.fieldType != NONE) {
             if (separateIntoComponents) {
                 for (unsigned long long c = 0; c < description.GetDimension(); c++) {
-                    // create a temporary fieldDescription for each component
-                    petscXdmfGenerator::XdmfSpecification::FieldDescription componentFieldDescription{.name = description.name + std::to_string(c),
-                                                                                                      .path = description.path,
-                                                                                                      .shape = description.shape,
-                                                                                                      .componentOffset = static_cast<unsigned long long>(c),
-                                                                                                      .componentStride = description.GetDimension(),
-                                                                                                      .componentDimension = 1,
-                                                                                                      .fieldLocation = description.fieldLocation,
-                                                                                                      .fieldType = SCALAR};
-
-                    fields.push_back(componentFieldDescription);
+                    description.components.push_back(ComponentDescription{.name = description.name + std::to_string(c), .offset = c});
                 }
-            } else {
-                fields.push_back(description);
             }
+            fields.push_back(std::move(description));
+        }
+    }
+}
+petscXdmfGenerator::XdmfSpecification::XdmfSpecification(std::string hdf5File, std::vector<GridDescription> grids) : hdf5File(std::move(hdf5File)), grids(std::move(grids)) {}
+
+XdmfSpecification& petscXdmfGenerator::XdmfSpecification::AddGrid(GridDescription grid) {
+    grids.push_back(std::move(grid));
+    return *this;
+}
+
+void petscXdmfGenerator::XdmfSpecification::Select(const std::function<bool(const std::string&)>& keepField, double timeBegin, double timeEnd, std::size_t timeStride) {
+    if (timeStride == 0) {
+        throw std::invalid_argument("the time stride must be at least one");
+    }
+    for (auto& grid : grids) {
+        grid.fields.erase(std::remove_if(grid.fields.begin(), grid.fields.end(), [&keepField](const FieldDescription& field) { return !keepField(field.name); }), grid.fields.end());
+
+        // steady state grids have no times to select
+        if (grid.time.empty()) {
+            continue;
+        }
+        auto inWindow = [timeBegin, timeEnd](double time) { return time >= timeBegin && time <= timeEnd; };
+        const auto first = (std::size_t)(std::find_if(grid.time.begin(), grid.time.end(), inWindow) - grid.time.begin());
+        const auto end = (std::size_t)(grid.time.rend() - std::find_if(grid.time.rbegin(), grid.time.rend(), inWindow));
+        if (first >= end) {
+            throw std::invalid_argument("none of the times for " + grid.name + " are between " + std::to_string(timeBegin) + " and " + std::to_string(timeEnd));
+        }
+
+        std::vector<double> selected;
+        for (auto t = first; t < end; t += timeStride) {
+            selected.push_back(grid.time[t]);
+        }
+        // summaries follow the time list, so a saved specification keeps the summaries of the times that remain
+        for (auto& field : grid.fields) {
+            const auto columns = field.componentDimension;
+            if (!field.HasTimeDimension() || field.summaries.size() != grid.time.size() * columns) {
+                continue;
+            }
+            std::vector<ValueSummary> summaries;
+            for (auto t = first; t < end; t += timeStride) {
+                summaries.insert(summaries.end(), field.summaries.begin() + (std::ptrdiff_t)(t * columns), field.summaries.begin() + (std::ptrdiff_t)((t + 1) * columns));
+            }
+            field.summaries = std::move(summaries);
         }
+
+        grid.timeStart = grid.TimeRow(first);
+        grid.timeStride *= timeStride;
+        grid.time = std::move(selected);
     }
 }
+
+void petscXdmfGenerator::XdmfSpecification::AddLevelsOfDetail(const std::vector<unsigned long long>& pointStrides) {
+    for (const auto pointStride : pointStrides) {
+        if (pointStride < 2) {
+            throw std::invalid_argument("each level of detail must read fewer points, " + std::to_string(pointStride) + " is not a stride greater than one");
+        }
+    }
+
+    // only particle grids (without cells) whose points are read a step at a time can be strided
+    std::vector<GridDescription> detailed;
+    for (auto& grid : grids) {
+        detailed.push_back(grid);
+        if (grid.topology.numberCorners != 0 || grid.hybridTopology.number > 0 || !grid.geometry.HasTimeDimension() || grid.pointStride != 1) {
+            continue;
+        }
+        for (const auto pointStride : pointStrides) {
+            auto& level = detailed.emplace_back(grid);
+            level.name = grid.name + "_lod" + std::to_string(pointStride);
+            level.pointStride = pointStride;
+
+            // fields without time are read whole, so they cannot be strided
+            level.fields.erase(std::remove_if(level.fields.begin(), level.fields.end(), [](const FieldDescription& field) { return !field.HasTimeDimension(); }), level.fields.end());
+        }
+    }
+    grids = std::move(detailed);
+}
+
+void petscXdmfGenerator::XdmfSpecification::Summarize(std::shared_ptr<petscXdmfGenerator::HdfObject> root, std::size_t blockValues) {
+    for (auto& grid : grids) {
+        // only the rows written for the time list are read, one summary row for each time
+        const auto steps = std::max<std::size_t>(1, grid.time.size());
+        for (auto& field : grid.fields) {
+            auto dataset = root->Get(field.path);
+            if (!dataset) {
+                throw std::runtime_error("cannot summarize " + field.path + ", it is not in " + hdf5File);
+            }
+
+            // scalar fields may be stored without the component dimension
+            const auto storedShape = dataset->Shape();
+            const std::size_t pointDimension = field.HasTimeDimension() ? 1 : 0;
+            const auto rows = field.HasTimeDimension() ? steps : 1;
+            const auto points = storedShape.size() > pointDimension ? storedShape[pointDimension] : 0;
+            const auto columns = std::max<std::size_t>(1, field.componentDimension);
+            const auto blockPoints = std::max<std::size_t>(1, blockValues / columns);
+
+            std::vector<hsize_t> start(storedShape.size(), 0);
+            std::vector<hsize_t> count(storedShape);
+            std::vector<double> block;
+            std::vector<double> minimum(columns), maximum(columns), sum(columns);
+            std::vector<unsigned long long> finite(columns);
+            field.summaries.clear();
+            for (std::size_t timeIndex = 0; timeIndex < rows; timeIndex++) {
+                std::fill(minimum.begin(), minimum.end(), std::numeric_limits<double>::infinity());
+                std::fill(maximum.begin(), maximum.end(), -std::numeric_limits<double>::infinity());
+                std::fill(sum.begin(), sum.end(), 0.0);
+                std::fill(finite.begin(), finite.end(), 0);
+
+                // read the row a block of points at a time so memory use does not grow with the field
+                for (hsize_t first = 0; first < points; first += blockPoints) {
+                    if (pointDimension > 0) {
+                        start.front() = grid.TimeRow(timeIndex);
+                        count.front() = 1;
+                    }
+                    start[pointDimension] = first;
+                    count[pointDimension] = std::min<hsize_t>(blockPoints, points - first);
+                    block.resize(count[pointDimension] * columns);
+                    dataset->RawData(block.data(), start, count);
+
+                    for (std::size_t p = 0; p < count[pointDimension]; p++) {
+                        const double* values = block.data() + p * columns;
+                        for (std::size_t c = 0; c < columns; c++) {
+                            if (std::isfinite(values[c])) {
+                                minimum[c] = std::min(minimum[c], values[c]);
+                                maximum[c] = std::max(maximum[c], values[c]);
+                                sum[c] += values[c];
+                                finite[c]++;
+                            }
+                        }
+                    }
+                }
+
+                for (std::size_t c = 0; c < columns; c++) {
+                    if (finite[c] == 0) {
+                        const auto none = std::numeric_limits<double>::quiet_NaN();
+                        field.summaries.push_back(ValueSummary{.minimum = none, .maximum = none, .mean = none});
+                    } else {
+                        field.summaries.push_back(ValueSummary{.minimum = minimum[c], .maximum = maximum[c], .mean = sum[c] / (double)finite[c]});
+                    }
+                }
+            }
+        }
+    }
+}
+
+// visits the path and fingerprint of each mesh dataset in a grid whose geometry does not change with time
+template <typename Grid, typename Visit>
+static void ForEachStaticMesh(Grid& grid, Visit visit) {
+    if (grid.geometry.HasTimeDimension()) {
+        return;
+    }
+    if (grid.topology.number > 0) {
+        visit(grid.topology.path, grid.topology.contentHash);
+    }
+    if (grid.hybridTopology.number > 0) {
+        visit(grid.hybridTopology.path, grid.hybridTopology.contentHash);
+    }
+    if (grid.geometry.GetDof() > 0) {
+        visit(grid.geometry.path, grid.geometry.contentHash);
+    }
+}
+
+void petscXdmfGenerator::XdmfSpecification::FingerprintMeshes(std::shared_ptr<petscXdmfGenerator::HdfObject> root) {
+    for (auto& grid : grids) {
+        ForEachStaticMesh(grid, [&root](const std::string& path, uint64_t& contentHash) {
+            auto dataset = root->Get(path);
+            contentHash = dataset ? dataset->ContentHash() : 0;
+        });
+    }
+}
+
+bool petscXdmfGenerator::XdmfSpecification::IsFingerprinted() const {
+    bool fingerprinted = true;
+    for (const auto& grid : grids) {
+        ForEachStaticMesh(grid, [&fingerprinted](const std::string&, const uint64_t& contentHash) { fingerprinted = fingerprinted && contentHash != 0; });
+    }
+    return fingerprinted;
+}
+
+void petscXdmfGenerator::XdmfSpecification::ClearSummaries() {
+    for (auto& grid : grids) {
+        for (auto& field : grid.fields) {
+            field.summaries.clear();
+        }
+    }
+}
+
+static void ValidateField(const XdmfSpecification::FieldDescription& field, const std::string& gridName) {
+    const auto name = gridName + "/" + field.name;
+    if (field.path.empty()) {
+        throw std::invalid_argument("the field " + name + " has no path");
+    }
+    if (field.shape.size() < 2 || field.shape.size() > 3) {
+        throw std::invalid_argument("the field " + name + " must have a shape of (dof, components) or (time, dof, components)");
+    }
+    for (const auto& component : field.components) {
+        if (component.offset >= field.componentDimension) {
+            throw std::invalid_argument("the component " + component.name + " is outside of the field " + name);
+        }
+    }
+}
+
+void petscXdmfGenerator::XdmfSpecification::Validate() const {
+    if (hdf5File.empty()) {
+        throw std::invalid_argument("the specification has no hdf5 file");
+    }
+    for (const auto& grid : grids) {
+        if (grid.name.empty()) {
+            throw std::invalid_argument("each grid in the specification must be named");
+        }
+        ValidateField(grid.geometry, grid.name);
+        for (const auto& field : grid.fields) {
+            ValidateField(field, grid.name);
+            const auto summaryRows = field.HasTimeDimension() ? std::max<std::size_t>(1, grid.time.size()) : 1;
+            if (!field.summaries.empty() && field.summaries.size() != summaryRows * field.componentDimension) {
+                throw std::invalid_argument("the field " + grid.name + "/" + field.name + " must have a summary for each component at each time");
+            }
+        }
+        for (const auto* topology : {&grid.topology, &grid.hybridTopology}) {
+            if (topology->numberCorners != 0 && topology->path.empty()) {
+                throw std::invalid_argument("the topology for " + grid.name + " has cells but no path");
+            }
+        }
+        if (!grid.timeDataset.path.empty() && grid.timeDataset.shape.empty()) {
+            throw std::invalid_argument("the time dataset for " + grid.name + " has no shape");
+        }
+        if (grid.timeStride == 0) {
+            throw std::invalid_argument("the time stride for " + grid.name + " must be at least one");
+        }
+        if (grid.pointStride == 0) {
+            throw std::invalid_argument("the point stride for " + grid.name + " must be at least one");
+        }
+        if (grid.pointStride != 1 && (grid.topology.numberCorners != 0 || !grid.geometry.HasTimeDimension())) {
+            throw std::invalid_argument("only time dependent particle grids can be strided, " + grid.name + " is not");
+        }
+    }
+}
+
 std::shared_ptr<XdmfSpecification> petscXdmfGenerator::XdmfSpecification::FromPetscHdf(std::shared_ptr<petscXdmfGenerator::HdfObject> rootObject) {
     auto specification = std::make_shared<XdmfSpecification>();
 
@@ -81,7 +397,7 @@ std::shared_ptr<XdmfSpecification> petscXdmfGenerator::XdmfSpecification::FromPe
         // store the geometry
         auto verticesObject = geometryObject->Get("vertices");
         mainGrid.geometry.name = verticesObject->Name(), mainGrid.geometry.path = verticesObject->Path(), mainGrid.geometry.shape = verticesObject->Shape(), mainGrid.geometry.fieldLocation = NODE,
-        mainGrid.geometry.fieldType = VECTOR, mainGrid.geometry.componentDimension = mainGrid.geometry.shape.size() > 2 ? mainGrid.geometry.shape[2] : mainGrid.geometry.shape[1];
+        mainGrid.geometry.fieldType = VECTOR, mainGrid.geometry.dataType = DataTypeFromHdf(*verticesObject), mainGrid.geometry.componentDimension = mainGrid.geometry.shape.size() > 2 ? mainGrid.geometry.shape[2] : mainGrid.geometry.shape[1];
 
         // check for and get the topology
         std::shared_ptr<petscXdmfGenerator::HdfObject> topologyObject = FindPetscHdfChild(rootObject, "topology");
@@ -91,6 +407,7 @@ std::shared_ptr<XdmfSpecification> petscXdmfGenerator::XdmfSpecification::FromPe
             mainGrid.topology.number = cellObject->Shape()[0];
             mainGrid.topology.numberCorners = cellObject->Shape()[1];
             mainGrid.topology.dimension = cellObject->Attribute<unsigned long long>("cell_dim");
+            mainGrid.topology.dataType = DataTypeFromHdf(*cellObject);
         }
 
         // hybrid topology
@@ -100,17 +417,19 @@ std::shared_ptr<XdmfSpecification> petscXdmfGenerator::XdmfSpecification::FromPe
             mainGrid.hybridTopology.path = cellObject->Path();
             mainGrid.hybridTopology.number = cellObject->Shape()[0];
             mainGrid.hybridTopology.numberCorners = cellObject->Shape()[1];
+            mainGrid.hybridTopology.dimension = cellObject->HasAttribute("cell_dim") ? cellObject->Attribute<unsigned long long>("cell_dim") : mainGrid.topology.dimension;
+            mainGrid.hybridTopology.dataType = DataTypeFromHdf(*cellObject);
         }
 
         // get the time
-        mainGrid.time = rootObject->Contains("time") ? rootObject->Get("time")->RawData<double>() : std::vector<double>();
+        DescribeTime(mainGrid, rootObject);
 
         // get the vertex fields and map into a vertex map
         if (rootObject->Contains("vertex_fields")) {
-            GenerateFieldsFromPetsc(mainGrid.fields, rootObject->Get("vertex_fields")->Items(), NODE);
+            GenerateFieldsFromPetsc(mainGrid.fields, rootObject->Get("vertex_fields")->Children(), NODE);
         }
         if (rootObject->Contains("cell_fields")) {
-            GenerateFieldsFromPetsc(mainGrid.fields, rootObject->Get("cell_fields")->Items(), CELL);
+            GenerateFieldsFromPetsc(mainGrid.fields, rootObject->Get("cell_fields")->Children(), CELL);
         }
 
         // add to the list of grids
@@ -124,14 +443,14 @@ std::shared_ptr<XdmfSpecification> petscXdmfGenerator::XdmfSpecification::FromPe
 
         // add in any other fields
         if (rootObject->Contains("particle_fields")) {
-            GenerateFieldsFromPetsc(particleGrid.fields, rootObject->Get("particle_fields")->Items(), NODE);
+            GenerateFieldsFromPetsc(particleGrid.fields, rootObject->Get("particle_fields")->Children(), NODE);
         }
 
         if (rootObject->Contains("particles")) {
             std::shared_ptr<petscXdmfGenerator::HdfObject> geometryObject = rootObject->Get("particles")->Get("coordinates");
             // store the geometry
             particleGrid.geometry.name = geometryObject->Name(), particleGrid.geometry.path = geometryObject->Path(), particleGrid.geometry.shape = geometryObject->Shape(),
-            particleGrid.geometry.fieldLocation = NODE, particleGrid.geometry.fieldType = VECTOR,
+            particleGrid.geometry.fieldLocation = NODE, particleGrid.geometry.fieldType = VECTOR, particleGrid.geometry.dataType = DataTypeFromHdf(*geometryObject),
             particleGrid.geometry.componentDimension = particleGrid.geometry.shape.size() > 2 ? particleGrid.geometry.shape[2] : particleGrid.geometry.shape[1];
         } else {
             // grad the geometry from the particle_fields
@@ -151,7 +470,7 @@ std::shared_ptr<XdmfSpecification> petscXdmfGenerator::XdmfSpecification::FromPe
         particleGrid.topology.dimension = particleGrid.geometry.GetDimension();
 
         // get the time
-        particleGrid.time = rootObject->Contains("time") ? rootObject->Get("time")->RawData<double>() : std::vector<double>();
+        DescribeTime(particleGrid, rootObject);
 
         // add to the list of grids
         specification->grids.push_back(particleGrid);
@@ -159,12 +478,367 @@ std::shared_ptr<XdmfSpecification> petscXdmfGenerator::XdmfSpecification::FromPe
 
     return specification;
 }
+XdmfSpecification::DataTypeDescription XdmfSpecification::DataTypeFromHdf(const petscXdmfGenerator::HdfObject& dataset) {
+    auto dataType = dataset.DataType();
+    switch (dataType.typeClass) {
+        case H5T_FLOAT:
+            return DataTypeDescription{.numberType = FLOAT, .precision = dataType.size};
+        case H5T_INTEGER:
+            // xdmf stores single byte integers as characters
+            if (dataType.size == 1) {
+                return DataTypeDescription{.numberType = dataType.isSigned ? CHAR : UCHAR, .precision = dataType.size};
+            }
+            return DataTypeDescription{.numberType = dataType.isSigned ? INT : UINT, .precision = dataType.size};
+        default:
+            throw std::runtime_error("Cannot describe the data type of " + dataset.Path());
+    }
+}
+
+void XdmfSpecification::DescribeTime(GridDescription& grid, std::shared_ptr<petscXdmfGenerator::HdfObject>& root) {
+    if (!root->Contains("time")) {
+        return;
+    }
+    auto timeObject = root->Get("time");
+    grid.time = *timeObject->SharedRawData<double>();
+    grid.timeDataset.name = timeObject->Name(), grid.timeDataset.path = timeObject->Path(), grid.timeDataset.shape = timeObject->Shape(), grid.timeDataset.fieldType = SCALAR,
+    grid.timeDataset.dataType = DataTypeFromHdf(*timeObject);
+}
+
 std::shared_ptr<petscXdmfGenerator::HdfObject> XdmfSpecification::FindPetscHdfChild(std::shared_ptr<petscXdmfGenerator::HdfObject>& root, std::string name) {
-    if (root->Contains("viz") && root->Get("viz")->Contains(name)) {
-        return root->Get("viz")->Get(name);
-    } else if (root->Contains(name)) {
-        return root->Get(name);
+    if (auto viz = root->Get("viz")) {
+        if (auto child = viz->Get(name)) {
+            return child;
+        }
+    }
+
+    return root->Get(name);
+}
+
+void XdmfSpecification::WriteBinary(std::ostream& stream, const TopologyDescription& topology) {
+    WriteString(stream, topology.path);
+    WriteValue(stream, topology.number);
+    WriteValue(stream, topology.numberCorners);
+    WriteValue(stream, topology.dimension);
+    WriteValue<int32_t>(stream, topology.dataType.numberType);
+    WriteValue(stream, topology.dataType.precision);
+    WriteValue(stream, topology.contentHash);
+}
+
+void XdmfSpecification::WriteBinary(std::ostream& stream, const FieldDescription& field) {
+    WriteString(stream, field.name);
+    WriteString(stream, field.path);
+    WriteVector(stream, field.shape);
+    WriteValue(stream, field.componentDimension);
+    WriteValue<int32_t>(stream, field.fieldLocation);
+    WriteValue<int32_t>(stream, field.fieldType);
+    WriteValue<int32_t>(stream, field.dataType.numberType);
+    WriteValue(stream, field.dataType.precision);
+    WriteValue<uint64_t>(stream, field.components.size());
+    for (const auto& component : field.components) {
+        WriteString(stream, component.name);
+        WriteValue(stream, component.offset);
+    }
+    WriteValue<uint64_t>(stream, field.summaries.size());
+    for (const auto& summary : field.summaries) {
+        WriteValue(stream, summary.minimum);
+        WriteValue(stream, summary.maximum);
+        WriteValue(stream, summary.mean);
+    }
+    WriteValue(stream, field.contentHash);
+}
+
+void XdmfSpecification::ReadBinary(std::istream& stream, TopologyDescription& topology) {
+    topology.path = ReadString(stream);
+    topology.number = ReadValue<unsigned long long>(stream);
+    topology.numberCorners = ReadValue<unsigned long long>(stream);
+    topology.dimension = ReadValue<unsigned long long>(stream);
+    topology.dataType.numberType = static_cast<NumberType>(ReadValue<int32_t>(stream));
+    topology.dataType.precision = ReadValue<unsigned long long>(stream);
+    topology.contentHash = ReadValue<uint64_t>(stream);
+}
+
+void XdmfSpecification::ReadBinary(std::istream& stream, FieldDescription& field) {
+    field.name = ReadString(stream);
+    field.path = ReadString(stream);
+    field.shape = ReadVector<unsigned long long>(stream);
+    field.componentDimension = ReadValue<unsigned long long>(stream);
+    field.fieldLocation = static_cast<FieldLocation>(ReadValue<int32_t>(stream));
+    field.fieldType = static_cast<FieldType>(ReadValue<int32_t>(stream));
+    field.dataType.numberType = static_cast<NumberType>(ReadValue<int32_t>(stream));
+    field.dataType.precision = ReadValue<unsigned long long>(stream);
+    field.components.resize(ReadCount(stream, sizeof(uint64_t) + sizeof(unsigned long long)));
+    for (auto& component : field.components) {
+        component.name = ReadString(stream);
+        component.offset = ReadValue<unsigned long long>(stream);
+    }
+    field.summaries.resize(ReadCount(stream, 3 * sizeof(double)));
+    for (auto& summary : field.summaries) {
+        summary.minimum = ReadValue<double>(stream);
+        summary.maximum = ReadValue<double>(stream);
+        summary.mean = ReadValue<double>(stream);
+    }
+    field.contentHash = ReadValue<uint64_t>(stream);
+}
+
+void XdmfSpecification::WriteBinary(std::ostream& stream) const {
+    stream.write(binaryMagic, sizeof(binaryMagic));
+    WriteValue(stream, binaryVersion);
+
+    WriteString(stream, hdf5File);
+    WriteValue<uint64_t>(stream, grids.size());
+    for (const auto& grid : grids) {
+        WriteString(stream, grid.name);
+        WriteBinary(stream, grid.topology);
+        WriteBinary(stream, grid.hybridTopology);
+        WriteBinary(stream, grid.geometry);
+        WriteValue<uint64_t>(stream, grid.fields.size());
+        for (const auto& field : grid.fields) {
+            WriteBinary(stream, field);
+        }
+        WriteVector(stream, grid.time);
+        WriteBinary(stream, grid.timeDataset);
+        WriteValue(stream, grid.timeStart);
+        WriteValue(stream, grid.timeStride);
+        WriteValue(stream, grid.pointStride);
+    }
+}
+
+std::shared_ptr<XdmfSpecification> XdmfSpecification::ReadBinary(std::istream& stream) {
+    char magic[sizeof(binaryMagic)];
+    if (!stream.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), binaryMagic) || ReadValue<uint32_t>(stream) != binaryVersion) {
+        throw std::runtime_error("unrecognized binary specification");
+    }
+
+    auto specification = std::make_shared<XdmfSpecification>();
+    specification->hdf5File = ReadString(stream);
+    specification->grids.resize(ReadCount(stream, sizeof(uint64_t)));
+    for (auto& grid : specification->grids) {
+        grid.name = ReadString(stream);
+        ReadBinary(stream, grid.topology);
+        ReadBinary(stream, grid.hybridTopology);
+        ReadBinary(stream, grid.geometry);
+        grid.fields.resize(ReadCount(stream, sizeof(uint64_t)));
+        for (auto& field : grid.fields) {
+            ReadBinary(stream, field);
+        }
+        grid.time = ReadVector<double>(stream);
+        ReadBinary(stream, grid.timeDataset);
+        grid.timeStart = ReadValue<unsigned long long>(stream);
+        grid.timeStride = ReadValue<unsigned long long>(stream);
+        grid.pointStride = ReadValue<unsigned long long>(stream);
+    }
+    return specification;
+}
+
+JsonValue XdmfSpecification::ToJson(const DataTypeDescription& dataType) {
+    return JsonValue::Object().Add("numberType", numberTypeNames.at(dataType.numberType)).Add("precision", dataType.precision);
+}
+
+// json numbers cannot hold every 64 bit hash, so the fingerprints are written as hexadecimal strings
+static std::string HashToJson(uint64_t contentHash) {
+    std::ostringstream hex;
+    hex << std::hex << std::setw(16) << std::setfill('0') << contentHash;
+    return hex.str();
+}
+
+static uint64_t HashFromJson(const JsonValue& value) {
+    const auto& hex = value.String();
+    std::size_t parsed = 0;
+    uint64_t contentHash = 0;
+    try {
+        contentHash = std::stoull(hex, &parsed, 16);
+    } catch (const std::logic_error&) {
+        parsed = 0;
+    }
+    if (hex.empty() || parsed != hex.size()) {
+        throw std::runtime_error("the content hash " + hex + " is not a hexadecimal number");
+    }
+    return contentHash;
+}
+
+JsonValue XdmfSpecification::ToJson(const TopologyDescription& topology) {
+    auto jsonTopology = JsonValue::Object()
+                            .Add("path", topology.path)
+                            .Add("number", topology.number)
+                            .Add("numberCorners", topology.numberCorners)
+                            .Add("dimension", topology.dimension)
+                            .Add("dataType", ToJson(topology.dataType));
+    if (topology.contentHash != 0) {
+        jsonTopology.Add("contentHash", HashToJson(topology.contentHash));
     }
+    return jsonTopology;
+}
+
+JsonValue XdmfSpecification::ToJson(const FieldDescription& field) {
+    auto shape = JsonValue::Array();
+    for (auto extent : field.shape) {
+        shape.Append(extent);
+    }
+    auto components = JsonValue::Array();
+    for (const auto& component : field.components) {
+        components.Append(JsonValue::Object().Add("name", component.name).Add("offset", component.offset));
+    }
+    auto jsonField = JsonValue::Object()
+                         .Add("name", field.name)
+                         .Add("path", field.path)
+                         .Add("shape", std::move(shape))
+                         .Add("componentDimension", field.componentDimension)
+                         .Add("fieldLocation", fieldLocationNames.at(field.fieldLocation))
+                         .Add("fieldType", fieldTypeNames.at(field.fieldType))
+                         .Add("dataType", ToJson(field.dataType))
+                         .Add("components", std::move(components));
+
+    // each summary is [minimum, maximum, mean], json has no NaN so a component without finite values is null
+    if (!field.summaries.empty()) {
+        auto summaries = JsonValue::Array();
+        auto number = [](double value) { return std::isfinite(value) ? JsonValue(value) : JsonValue(); };
+        for (const auto& summary : field.summaries) {
+            summaries.Append(JsonValue::Array().Append(number(summary.minimum)).Append(number(summary.maximum)).Append(number(summary.mean)));
+        }
+        jsonField.Add("summaries", std::move(summaries));
+    }
+    if (field.contentHash != 0) {
+        jsonField.Add("contentHash", HashToJson(field.contentHash));
+    }
+    return jsonField;
+}
+
+XdmfSpecification::DataTypeDescription XdmfSpecification::DataTypeFromJson(const JsonValue& value) {
+    return DataTypeDescription{.numberType = EnumFromJson<NumberType>(value["numberType"], numberTypeNames), .precision = value["precision"].Unsigned()};
+}
+
+XdmfSpecification::TopologyDescription XdmfSpecification::TopologyFromJson(const JsonValue& value) {
+    return TopologyDescription{.path = value["path"].String(),
+                               .number = value["number"].Unsigned(),
+                               .numberCorners = value["numberCorners"].Unsigned(),
+                               .dimension = value["dimension"].Unsigned(),
+                               .dataType = DataTypeFromJson(value["dataType"]),
+                               .contentHash = value.Contains("contentHash") ? HashFromJson(value["contentHash"]) : 0};
+}
+
+XdmfSpecification::FieldDescription XdmfSpecification::FieldFromJson(const JsonValue& value) {
+    FieldDescription field{.name = value["name"].String(),
+                           .path = value["path"].String(),
+                           .componentDimension = value["componentDimension"].Unsigned(),
+                           .fieldLocation = EnumFromJson<FieldLocation>(value["fieldLocation"], fieldLocationNames),
+                           .fieldType = EnumFromJson<FieldType>(value["fieldType"], fieldTypeNames),
+                           .dataType = DataTypeFromJson(value["dataType"])};
+    for (const auto& extent : value["shape"].Elements()) {
+        field.shape.push_back(extent.Unsigned());
+    }
+    for (const auto& component : value["components"].Elements()) {
+        field.components.push_back(ComponentDescription{.name = component["name"].String(), .offset = component["offset"].Unsigned()});
+    }
+    if (value.Contains("summaries")) {
+        auto number = [](const JsonValue& value) { return value.Type() == JsonValue::NUL ? std::numeric_limits<double>::quiet_NaN() : value.Double(); };
+        for (const auto& summary : value["summaries"].Elements()) {
+            const auto& values = summary.Elements();
+            if (values.size() != 3) {
+                throw std::runtime_error("each summary of " + field.name + " must hold the minimum, maximum, and mean");
+            }
+            field.summaries.push_back(ValueSummary{.minimum = number(values[0]), .maximum = number(values[1]), .mean = number(values[2])});
+        }
+    }
+    if (value.Contains("contentHash")) {
+        field.contentHash = HashFromJson(value["contentHash"]);
+    }
+    return field;
+}
+
+void XdmfSpecification::WriteJson(std::ostream& stream) const {
+    auto jsonGrids = JsonValue::Array();
+    for (const auto& grid : grids) {
+        auto fields = JsonValue::Array();
+        for (const auto& field : grid.fields) {
+            fields.Append(ToJson(field));
+        }
+        auto time = JsonValue::Array();
+        for (auto value : grid.time) {
+            time.Append(value);
+        }
+        jsonGrids.Append(JsonValue::Object()
+                             .Add("name", grid.name)
+                             .Add("topology", ToJson(grid.topology))
+                             .Add("hybridTopology", ToJson(grid.hybridTopology))
+                             .Add("geometry", ToJson(grid.geometry))
+                             .Add("fields", std::move(fields))
+                             .Add("time", std::move(time))
+                             .Add("timeDataset", ToJson(grid.timeDataset))
+                             .Add("timeStart", grid.timeStart)
+                             .Add("timeStride", grid.timeStride)
+                             .Add("pointStride", grid.pointStride));
+    }
+
+    JsonValue::Object().Add("format", jsonFormat).Add("version", jsonVersion).Add("hdf5File", hdf5File).Add("grids", std::move(jsonGrids)).Write(stream);
+    stream << '\n';
+}
+
+std::shared_ptr<XdmfSpecification> XdmfSpecification::ReadJson(std::istream& stream) {
+    auto document = JsonValue::Read(stream);
+    if (document.Type() != JsonValue::OBJECT || !document.Contains("format") || document["format"].String() != jsonFormat) {
+        throw std::runtime_error("unrecognized json specification");
+    }
+    if (document["version"].Unsigned() != jsonVersion) {
+        throw std::runtime_error("unsupported json specification version " + std::to_string(document["version"].Unsigned()));
+    }
+
+    auto specification = std::make_shared<XdmfSpecification>(document["hdf5File"].String());
+    for (const auto& jsonGrid : document["grids"].Elements()) {
+        GridDescription grid;
+        grid.name = jsonGrid["name"].String();
+        grid.topology = TopologyFromJson(jsonGrid["topology"]);
+        grid.hybridTopology = TopologyFromJson(jsonGrid["hybridTopology"]);
+        grid.geometry = FieldFromJson(jsonGrid["geometry"]);
+        for (const auto& field : jsonGrid["fields"].Elements()) {
+            grid.fields.push_back(FieldFromJson(field));
+        }
+        for (const auto& value : jsonGrid["time"].Elements()) {
+            grid.time.push_back(value.Double());
+        }
+        grid.timeDataset = FieldFromJson(jsonGrid["timeDataset"]);
+
+        // the time selection and point stride are optional so that specifications written before it was added can still be read
+        if (jsonGrid.Contains("timeStart")) {
+            grid.timeStart = jsonGrid["timeStart"].Unsigned();
+        }
+        if (jsonGrid.Contains("timeStride")) {
+            grid.timeStride = jsonGrid["timeStride"].Unsigned();
+        }
+        if (jsonGrid.Contains("pointStride")) {
+            grid.pointStride = jsonGrid["pointStride"].Unsigned();
+        }
+        specification->grids.push_back(std::move(grid));
+    }
+    specification->Validate();
+    return specification;
+}
+
+bool XdmfSpecification::IsSpecificationFile(const std::filesystem::path& filePath) { return filePath.extension() == JsonExtension || filePath.extension() == BinaryExtension; }
+
+void XdmfSpecification::Save(const std::filesystem::path& filePath) const {
+    std::ofstream file(filePath, std::ios::binary);
+    if (filePath.extension() == JsonExtension) {
+        WriteJson(file);
+    } else {
+        WriteBinary(file);
+    }
+    file.close();
+    if (!file) {
+        throw std::runtime_error("unable to write specification " + filePath.string());
+    }
+}
 
-    return nullptr;
+std::shared_ptr<XdmfSpecification> XdmfSpecification::Load(const std::filesystem::path& filePath) {
+    std::ifstream file(filePath, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("unable to open specification " + filePath.string());
+    }
+
+    // the binary form always starts with its magic, anything else is read as json
+    if (file.peek() == binaryMagic[0]) {
+        auto specification = ReadBinary(file);
+        specification->Validate();
+        return specification;
+    }
+    return ReadJson(file);
 }
@@ -1,55 +1,146 @@
 #include "xmlElement.hpp"
+#include <algorithm>
 
-petscXdmfGenerator::XmlElement::XmlElement(std::string name, std::string preamble, std::string currentPath) : preamble(preamble), name(name), path(currentPath + "/" + name) {}
+petscXdmfGenerator::XmlElement::XmlElement(std::string name, std::string preamble) : arena(nullptr), preamble(preamble), ownedArena(std::make_unique<XmlArena>()) {
+    arena = ownedArena.get();
+    this->name = arena->Intern(name);
+}
+
+petscXdmfGenerator::XmlElement::XmlElement(ArenaKey, XmlArena& arena, XmlElement* parent, std::string_view name) : arena(&arena), parent(parent), name(name) {}
+
+petscXdmfGenerator::XmlElement::~XmlElement() = default;
 
 namespace petscXdmfGenerator {
 std::ostream& operator<<(std::ostream& os, const petscXdmfGenerator::XmlElement& object) {
-    os << object.preamble;
-    os << "<" << object.name;
-    for (const auto& attribute : object.attributes) {
-        os << " " << attribute.first << "=\"" << attribute.second << "\"";
-    }
-    os << ">";
-    os << object.value;
-    for (const auto& element : object.elements) {
-        os << *(element);
-    }
-    os << "</" << object.name << ">";
-
+    object.Print(os, 0, COMPACT);
     return os;
 }
 }  // namespace petscXdmfGenerator
 
+// indentation is written from a single block of spaces instead of building a string at every depth
+static void Indent(std::ostream& stream, size_t depth) {
+    static const std::string spaces(128, ' ');
+    for (auto width = depth * 2; width > 0;) {
+        const auto chunk = std::min(width, spaces.size());
+        stream.write(spaces.data(), chunk);
+        width -= chunk;
+    }
+}
+
 petscXdmfGenerator::XmlElement& petscXdmfGenerator::XmlElement::operator[](const std::string&& childName) {
-    elements.push_back(std::make_unique<XmlElement>(childName, "", path));
-    return *elements[elements.size() - 1];
+    auto& element = arena->Acquire(this, arena->Intern(childName));
+    elements.push_back(&element);
+    return element;
 }
 
 petscXdmfGenerator::XmlElement& petscXdmfGenerator::XmlElement::operator[](const size_t&& index) { return *elements[index]; }
 
-std::string& petscXdmfGenerator::XmlElement::operator()(const std::string&& childName) { return attributes[childName]; }
+std::string& petscXdmfGenerator::XmlElement::operator()(const std::string&& childName) {
+    // attributes are kept sorted so they print in the same order as before
+    auto attribute = std::lower_bound(attributes.begin(), attributes.end(), childName, [](const auto& a, const std::string& n) { return a.first < n; });
+    if (attribute == attributes.end() || attribute->first != childName) {
+        attribute = attributes.emplace(attribute, arena->Intern(childName), std::string());
+    }
+    return attribute->second;
+}
 
 std::string& petscXdmfGenerator::XmlElement::operator()() { return value; }
 
-void petscXdmfGenerator::XmlElement::PrettyPrint(std::ostream& stream, size_t depth) {
-    const auto t = std::string(2, ' ');
-    const auto d = std::string(depth * 2, ' ');
+std::string petscXdmfGenerator::XmlElement::Path() const {
+    std::string path;
+    if (parent) {
+        path = parent->Path();
+    }
+    path += "/";
+    path += name;
+    return path;
+}
 
+void petscXdmfGenerator::XmlElement::Print(std::ostream& stream, size_t depth, XmlFormat format) const {
+    PrintOpen(stream, depth, format);
+    for (const auto& element : elements) {
+        element->Print(stream, depth + 1, format);
+    }
+    PrintClose(stream, depth, format);
+}
+
+void petscXdmfGenerator::XmlElement::PrintOpen(std::ostream& stream, size_t depth, XmlFormat format) const {
+    // new lines are written without flushing the stream
+    const bool pretty = format == PRETTY;
     if (preamble.size() > 0) {
-        stream << d << preamble;
+        if (pretty) {
+            Indent(stream, depth);
+        }
+        stream << preamble;
+    }
+    if (pretty) {
+        stream << '\n';
+        Indent(stream, depth);
     }
-    stream << std::endl << d << "<" << name;
+    stream << '<' << name;
     for (const auto& attribute : attributes) {
-        stream << " " << attribute.first << "=\"" << attribute.second << "\"";
+        stream << ' ' << attribute.first << "=\"" << attribute.second << '"';
     }
-    stream << ">";
+    stream << '>';
 
     if (!value.empty()) {
-        stream << std::endl << d << t << value;
+        if (pretty) {
+            stream << '\n';
+            Indent(stream, depth + 1);
+        }
+        stream << value;
     }
+}
+
+void petscXdmfGenerator::XmlElement::PrintClose(std::ostream& stream, size_t depth, XmlFormat format) const {
+    if (format == PRETTY) {
+        stream << '\n';
+        Indent(stream, depth);
+    }
+    stream << "</" << name << '>';
+}
+
+void petscXdmfGenerator::XmlElement::FlushChildren(std::ostream& stream, size_t depth, XmlFormat format) {
+    for (const auto& element : elements) {
+        element->Print(stream, depth + 1, format);
+    }
+    ClearChildren();
+}
+
+void petscXdmfGenerator::XmlElement::ClearChildren() {
     for (const auto& element : elements) {
-        element->PrettyPrint(stream, depth + 1);
+        arena->Release(*element);
     }
+    elements.clear();
+}
+
+void petscXdmfGenerator::XmlElement::Reset(XmlElement* newParent, std::string_view newName) {
+    // clear but keep any capacity for reuse
+    parent = newParent;
+    name = newName;
+    preamble.clear();
+    value.clear();
+    attributes.clear();
+    elements.clear();
+}
 
-    stream << std::endl << d << "</" << name << ">";
+std::string_view petscXdmfGenerator::XmlArena::Intern(const std::string& name) { return *names.insert(name).first; }
+
+petscXdmfGenerator::XmlElement& petscXdmfGenerator::XmlArena::Acquire(XmlElement* parent, std::string_view name) {
+    if (freeElements.empty()) {
+        return elements.emplace_back(XmlElement::ArenaKey(), *this, parent, name);
+    }
+
+    auto& element = *freeElements.back();
+    freeElements.pop_back();
+    element.Reset(parent, name);
+    return element;
+}
+
+void petscXdmfGenerator::XmlArena::Release(XmlElement& element) {
+    for (const auto& child : element.elements) {
+        Release(*child);
+    }
+    element.elements.clear();
+    freeElements.push_back(&element);
 }
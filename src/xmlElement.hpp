@@ -1,28 +1,71 @@
 #ifndef PETSCXDMFGENERATOR_XMLELEMENT_HPP
 #define PETSCXDMFGENERATOR_XMLELEMENT_HPP
 
+#include <deque>
 #include <iostream>
-#include <map>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace petscXdmfGenerator {
 
+class XmlArena;
+
+/**
+ * Pretty output puts each tag and value on its own indented line, compact output has no added white space
+ */
+enum XmlFormat { PRETTY, COMPACT };
+
 class XmlElement {
+   public:
+    /**
+     * Only the arena can create child elements
+     */
+    class ArenaKey {
+        ArenaKey() {}
+        friend class XmlArena;
+    };
+
    private:
+    // the arena that owns this element's children
+    XmlArena* arena;
+    XmlElement* parent = nullptr;
+
+    // names are interned in the arena
+    std::string_view name;
     std::string preamble;
-    std::string name;
     std::string value;
-    std::string path;
-    std::map<std::string, std::string> attributes;
-    std::vector<std::unique_ptr<XmlElement>> elements;
+
+    // attributes are stored sorted by name
+    std::vector<std::pair<std::string_view, std::string>> attributes;
+    std::vector<XmlElement*> elements;
+
+    // the arena is owned by the root of the document
+    std::unique_ptr<XmlArena> ownedArena;
 
    public:
     XmlElement(const XmlElement&) = delete;
     void operator=(const XmlElement&) = delete;
 
-    explicit XmlElement(std::string name, std::string preamble = "", std::string currentPath = "");
+    /**
+     * creates the root of a new document
+     * @param name
+     * @param preamble
+     */
+    explicit XmlElement(std::string name, std::string preamble = "");
+
+    /**
+     * creates a child element inside of the arena
+     * @param arena
+     * @param parent
+     * @param name
+     */
+    XmlElement(ArenaKey, XmlArena& arena, XmlElement* parent, std::string_view name);
+
+    ~XmlElement();
 
     /**
      * creates a new child element with the name
@@ -39,7 +82,7 @@ class XmlElement {
     XmlElement& operator[](const std::size_t&& index);
 
     /**
-     * gets/sets the attribute
+     * gets/sets the attribute.  The reference is only valid until the next attribute is added.
      * @param childName
      * @return
      */
@@ -53,10 +96,10 @@ class XmlElement {
     std::string& operator()();
 
     /**
-     * Get the path to this element
+     * Get the path to this element, computed from the parent chain
      * @return
      */
-    const std::string& Path() const { return path; }
+    std::string Path() const;
 
     /**
      * prints the xml object to the stream
@@ -72,7 +115,86 @@ class XmlElement {
      * @param object
      * @return
      */
-    void PrettyPrint(std::ostream& stream, size_t depth = 0);
+    void PrettyPrint(std::ostream& stream, size_t depth = 0) const { Print(stream, depth, PRETTY); }
+
+    /**
+     * prints the xml object to the stream in the requested format
+     * @param stream
+     * @param depth
+     * @param format
+     */
+    void Print(std::ostream& stream, size_t depth = 0, XmlFormat format = PRETTY) const;
+
+    /**
+     * prints the preamble, opening tag, and value of this element without any children or the closing tag
+     * @param stream
+     * @param depth
+     * @param format
+     */
+    void PrintOpen(std::ostream& stream, size_t depth = 0, XmlFormat format = PRETTY) const;
+
+    /**
+     * prints the closing tag of this element
+     * @param stream
+     * @param depth
+     * @param format
+     */
+    void PrintClose(std::ostream& stream, size_t depth = 0, XmlFormat format = PRETTY) const;
+
+    /**
+     * prints each of the current children at depth + 1 and then releases them
+     * @param stream
+     * @param depth the depth of this element
+     * @param format
+     */
+    void FlushChildren(std::ostream& stream, size_t depth = 0, XmlFormat format = PRETTY);
+
+    /**
+     * releases all children without printing them
+     */
+    void ClearChildren();
+
+   private:
+    // clears the element so that it can be reused by the arena
+    void Reset(XmlElement* newParent, std::string_view newName);
+
+    friend class XmlArena;
+};
+
+/**
+ * Owns every element and interned name in a document.  Released elements are kept in a pool and reused, so a
+ * document that is built and flushed incrementally reaches a steady state with no further allocation.
+ */
+class XmlArena {
+   private:
+    // a deque keeps element addresses stable as the arena grows
+    std::deque<XmlElement> elements;
+    std::vector<XmlElement*> freeElements;
+
+    // the builder only ever uses a few dozen tag/attribute names
+    std::unordered_set<std::string> names;
+
+   public:
+    /**
+     * returns a view of the name that is valid for the lifetime of the arena
+     * @param name
+     * @return
+     */
+    std::string_view Intern(const std::string& name);
+
+    /**
+     * gets a new or recycled element
+     * @param parent
+     * @param name
+     * @return
+     */
+    XmlElement& Acquire(XmlElement* parent, std::string_view name);
+
+    /**
+     * returns the element and all of its children to the pool
+     * @param element
+     */
+    void Release(XmlElement& element);
 };
 
 }  // namespace petscXdmfGenerator
@@ -1,6 +1,11 @@
+#include <fcntl.h>
 #include <gtest/gtest.h>
+#include <hdf5.h>
+#include <unistd.h>
 #include <filesystem>
 #include <fstream>
+#include <functional>
+#include <regex>
 #include <sstream>
 #include "generators.hpp"
 
@@ -32,6 +37,970 @@ TEST_P(PETScHdf5ToXdmfTestFixture, ShouldGenerateExpectedXml) {
     ASSERT_EQ(resultStream.str(), expectedOutput.str());
 }
 
+TEST_P(PETScHdf5ToXdmfTestFixture, ShouldGenerateExpectedXmlFromAnOpenFileWithoutClosingIt) {
+    // arrange
+    std::ifstream expectedResultFile(expectedOutputFilePath);
+    std::stringstream expectedOutput;
+    expectedOutput << expectedResultFile.rdbuf();
+
+    auto fileId = H5Fopen(inputFilePath.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+    ASSERT_GE(fileId, 0);
+    auto rootGroupId = H5Gopen2(fileId, "/", H5P_DEFAULT);
+    ASSERT_GE(rootGroupId, 0);
+
+    // act
+    std::string buffer = "replaced";
+    petscXdmfGenerator::Generate(fileId, buffer);
+    std::string sinkOutput;
+    std::size_t blocks = 0;
+    auto statistics = petscXdmfGenerator::Generate(rootGroupId, [&](const char* data, std::size_t size) {
+        sinkOutput.append(data, size);
+        blocks++;
+    });
+
+    // assert
+    ASSERT_EQ(buffer, expectedOutput.str());
+    ASSERT_EQ(sinkOutput, expectedOutput.str());
+    ASSERT_GE(blocks, 1u);
+    ASSERT_EQ(statistics.bytesWritten, expectedOutput.str().size());
+    ASSERT_GT(H5Iis_valid(rootGroupId), 0);
+    ASSERT_GT(H5Iis_valid(fileId), 0);
+    H5Gclose(rootGroupId);
+    ASSERT_GE(H5Fclose(fileId), 0);
+}
+
+TEST_P(PETScHdf5ToXdmfTestFixture, ShouldGenerateExpectedXmlFromASavedSpecification) {
+    // arrange
+    std::ifstream expectedResultFile(expectedOutputFilePath);
+    std::stringstream expectedOutput;
+    expectedOutput << expectedResultFile.rdbuf();
+
+    // each instance may run at the same time as the others, so each uses its own directory
+    auto directory = std::filesystem::temp_directory_path() / ("petscXdmfGeneratorSpecificationTest." + GetParam());
+    std::filesystem::create_directories(directory);
+    auto jsonFilePath = directory / (GetParam() + ".json");
+    auto binaryFilePath = directory / (GetParam() + ".pxspec");
+
+    // act
+    auto specification = petscXdmfGenerator::ReadSpecification(inputFilePath);
+    specification->Save(jsonFilePath);
+    specification->Save(binaryFilePath);
+
+    // rebuild the specification through the public api
+    petscXdmfGenerator::XdmfSpecification copy(specification->Hdf5File());
+    for (const auto& grid : specification->Grids()) {
+        copy.AddGrid(grid);
+    }
+
+    std::stringstream jsonOutput, binaryOutput, copyOutput;
+    petscXdmfGenerator::Generate(jsonFilePath, jsonOutput);
+    petscXdmfGenerator::Generate(petscXdmfGenerator::XdmfSpecification::Load(binaryFilePath), binaryOutput);
+    petscXdmfGenerator::Generate(std::make_shared<petscXdmfGenerator::XdmfSpecification>(copy), copyOutput);
+
+    // assert
+    ASSERT_EQ(jsonOutput.str(), expectedOutput.str());
+    ASSERT_EQ(binaryOutput.str(), expectedOutput.str());
+    ASSERT_EQ(copyOutput.str(), expectedOutput.str());
+    std::filesystem::remove_all(directory);
+}
+
 INSTANTIATE_TEST_SUITE_P(Tests, PETScHdf5ToXdmfTestFixture,
                          ::testing::Values("flowField.0", "steadyState.0", "swarmStaticMesh.0", "flowWithParticles.0", "particlesOnly.0", "particlesDynamic3D", "flowWithMultipleComponents",
-                                           "particleWithExtraFields"));
\ No newline at end of file
+                                           "particleWithExtraFields"));
+TEST(PETScHdf5ToXdmfBatchTests, ShouldGenerateExpectedXmlForEachFileAndReportFailures) {
+    // arrange
+    auto outputDirectory = std::filesystem::temp_directory_path() / "petscXdmfGeneratorBatchTests";
+    std::filesystem::remove_all(outputDirectory);
+    std::filesystem::create_directories(outputDirectory);
+
+    auto inputFilePaths = petscXdmfGenerator::ExpandInputPaths(
+        {"inputs/flow*.hdf5", "inputs/steadyState.0.hdf5", "inputs/swarmStaticMesh.0.hdf5", "inputs/particlesOnly.0.hdf5", "inputs/particlesDynamic3D.hdf5", "inputs/particleWithExtraFields.hdf5"});
+    ASSERT_EQ(inputFilePaths.size(), 8u);
+    inputFilePaths.push_back("inputs/missingFile.hdf5");
+
+    // act
+    auto results = petscXdmfGenerator::GenerateBatch(inputFilePaths, 3, outputDirectory);
+
+    // assert
+    ASSERT_EQ(results.size(), inputFilePaths.size());
+    for (const auto& result : results) {
+        if (result.inputFilePath.filename() == "missingFile.hdf5") {
+            ASSERT_FALSE(result.success);
+            ASSERT_FALSE(result.error.empty());
+            continue;
+        }
+        ASSERT_TRUE(result.success) << result.error;
+
+        std::ifstream expectedResultFile(std::filesystem::path("outputs") / result.outputFilePath.filename());
+        std::stringstream expectedOutput;
+        expectedOutput << expectedResultFile.rdbuf();
+
+        std::ifstream resultFile(result.outputFilePath);
+        std::stringstream resultOutput;
+        resultOutput << resultFile.rdbuf();
+
+        ASSERT_EQ(resultOutput.str(), expectedOutput.str()) << result.inputFilePath;
+    }
+
+    std::filesystem::remove_all(outputDirectory);
+}
+
+TEST(PETScHdf5ToXdmfBatchTests, ShouldReportTheWorkDoneByEachPipelineStage) {
+    // arrange
+    auto outputDirectory = std::filesystem::temp_directory_path() / "petscXdmfGeneratorPipelineTests";
+    std::filesystem::remove_all(outputDirectory);
+    std::filesystem::create_directories(outputDirectory);
+
+    auto inputFilePaths = petscXdmfGenerator::ExpandInputPaths({"inputs/flow*.hdf5", "inputs/steadyState.0.hdf5", "inputs/particlesOnly.0.hdf5"});
+    inputFilePaths.insert(inputFilePaths.begin() + 1, "inputs/missingFile.hdf5");
+
+    // the smallest queues make every stage wait on its neighbours
+    petscXdmfGenerator::PipelineOptions pipelineOptions{.specificationQueueDepth = 1, .writeQueueDepth = 1};
+    petscXdmfGenerator::PipelineStatistics pipelineStatistics;
+
+    // act
+    auto results = petscXdmfGenerator::GenerateBatch(inputFilePaths, 2, outputDirectory, {}, pipelineOptions, &pipelineStatistics);
+
+    // assert
+    ASSERT_EQ(results.size(), inputFilePaths.size());
+    ASSERT_FALSE(results[1].success);
+    for (std::size_t r = 0; r < results.size(); r++) {
+        if (r == 1) {
+            continue;
+        }
+        ASSERT_TRUE(results[r].success) << results[r].error;
+        ASSERT_EQ(results[r].statistics.bytesWritten, std::filesystem::file_size(results[r].outputFilePath));
+
+        std::ifstream expectedResultFile(std::filesystem::path("outputs") / results[r].outputFilePath.filename());
+        std::stringstream expectedOutput;
+        expectedOutput << expectedResultFile.rdbuf();
+        std::ifstream resultFile(results[r].outputFilePath);
+        std::stringstream resultOutput;
+        resultOutput << resultFile.rdbuf();
+        ASSERT_EQ(resultOutput.str(), expectedOutput.str()) << results[r].inputFilePath;
+    }
+
+    // the missing file never leaves the extract stage
+    ASSERT_EQ(pipelineStatistics.extract.files, inputFilePaths.size() - 1);
+    ASSERT_EQ(pipelineStatistics.build.files, inputFilePaths.size() - 1);
+    ASSERT_EQ(pipelineStatistics.write.files, inputFilePaths.size() - 1);
+    ASSERT_GT(pipelineStatistics.extract.FilesPerSecond(), 0);
+    ASSERT_GT(pipelineStatistics.build.FilesPerSecond(), 0);
+    ASSERT_GT(pipelineStatistics.write.FilesPerSecond(), 0);
+    ASSERT_GE(pipelineStatistics.totalSeconds, pipelineStatistics.write.busySeconds);
+
+    std::filesystem::remove_all(outputDirectory);
+}
+
+TEST(PETScHdf5ToXdmfSeriesTests, ShouldGenerateSingleTemporalCollectionForSeries) {
+    // arrange
+    std::ifstream expectedResultFile("outputs/particleSeries.xmf");
+    std::stringstream expectedOutput;
+    expectedOutput << expectedResultFile.rdbuf();
+
+    std::stringstream resultStream;
+
+    // act
+    petscXdmfGenerator::GenerateSeries({"inputs/particleSeries.0.hdf5", "inputs/particleSeries.1.hdf5", "inputs/particleSeries.2.hdf5"}, resultStream);
+
+    // assert
+    ASSERT_EQ(resultStream.str(), expectedOutput.str());
+}
+
+TEST(PETScHdf5ToXdmfSeriesTests, ShouldReferenceTheFirstFilesMeshWhenTheMeshDoesNotChange) {
+    // arrange
+    auto directory = std::filesystem::temp_directory_path() / "petscXdmfGeneratorStaticMeshTest";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    std::vector<std::filesystem::path> inputFilePaths;
+    for (const auto& name : {"staticMesh.0.hdf5", "staticMesh.1.hdf5", "staticMesh.2.hdf5"}) {
+        inputFilePaths.push_back(directory / name);
+        std::filesystem::copy_file("inputs/steadyState.0.hdf5", inputFilePaths.back());
+    }
+    std::ifstream expectedResultFile("outputs/staticMeshSeries.xmf");
+    std::stringstream expectedOutput;
+    expectedOutput << expectedResultFile.rdbuf();
+
+    // act
+    std::stringstream sharedStream;
+    petscXdmfGenerator::GenerateSeries(inputFilePaths, sharedStream);
+
+    // the fingerprints are cached with the specifications, so a cached series is shared without opening any file
+    petscXdmfGenerator::GenerateOptions cacheOptions;
+    cacheOptions.useSpecificationCache = true;
+    cacheOptions.specificationCacheDirectory = directory / "cache";
+    std::stringstream uncachedStream;
+    petscXdmfGenerator::GenerateSeries(inputFilePaths, uncachedStream, cacheOptions);
+    std::stringstream cachedStream;
+    auto cachedStatistics = petscXdmfGenerator::GenerateSeries(inputFilePaths, cachedStream, cacheOptions);
+
+    // move a vertex inside the sampled middle block of the last file
+    {
+        auto fileId = H5Fopen(inputFilePaths.back().c_str(), H5F_ACC_RDWR, H5P_DEFAULT);
+        auto datasetId = H5Dopen2(fileId, "/geometry/vertices", H5P_DEFAULT);
+        auto spaceId = H5Dget_space(datasetId);
+        const hsize_t start[2] = {144, 0};
+        const hsize_t count[2] = {1, 1};
+        H5Sselect_hyperslab(spaceId, H5S_SELECT_SET, start, nullptr, count, nullptr);
+        auto memorySpaceId = H5Screate_simple(2, count, nullptr);
+        const double moved = 10.0;
+        ASSERT_GE(H5Dwrite(datasetId, H5T_NATIVE_DOUBLE, memorySpaceId, spaceId, H5P_DEFAULT, &moved), 0);
+        H5Sclose(memorySpaceId);
+        H5Sclose(spaceId);
+        H5Dclose(datasetId);
+        H5Fclose(fileId);
+    }
+    std::stringstream movedStream;
+    petscXdmfGenerator::GenerateSeries(inputFilePaths, movedStream);
+
+    petscXdmfGenerator::GenerateOptions options;
+    options.shareStaticMeshes = false;
+    std::stringstream separateStream;
+    petscXdmfGenerator::GenerateSeries(inputFilePaths, separateStream, options);
+
+    // assert
+    ASSERT_EQ(sharedStream.str(), expectedOutput.str());
+    ASSERT_EQ(uncachedStream.str(), expectedOutput.str());
+    ASSERT_EQ(cachedStream.str(), expectedOutput.str());
+    ASSERT_EQ(cachedStatistics.cachedSpecifications, 3u);
+    ASSERT_EQ(cachedStatistics.hdfOpens, 0u);
+
+    // only the moved vertices are written again, the cells are still shared
+    ASSERT_NE(movedStream.str().find("Name=\"HeavyData2_geometry_vertices\""), std::string::npos);
+    ASSERT_EQ(movedStream.str().find("Name=\"HeavyData1_geometry_vertices\""), std::string::npos);
+    ASSERT_EQ(movedStream.str().find("Name=\"HeavyData2_viz_topology_cells\""), std::string::npos);
+
+    // every file keeps its own mesh when sharing is disabled
+    for (const auto& name : {"HeavyData1_geometry_vertices", "HeavyData2_geometry_vertices", "HeavyData1_viz_topology_cells", "HeavyData2_viz_topology_cells"}) {
+        ASSERT_NE(separateStream.str().find("Name=\"" + std::string(name) + "\""), std::string::npos) << name;
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(PETScHdf5ToXdmfPartitionTests, ShouldGenerateASpatialCollectionOfThePartitionsForEachStep) {
+    // arrange
+    auto directory = std::filesystem::temp_directory_path() / "petscXdmfGeneratorPartitionTest";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    std::vector<std::filesystem::path> partitionFilePaths = {directory / "partition.0.hdf5", directory / "partition.1.hdf5"};
+    for (const auto& partitionFilePath : partitionFilePaths) {
+        std::filesystem::copy_file("inputs/flowWithMultipleComponents.hdf5", partitionFilePath);
+    }
+    std::ifstream expectedResultFile("outputs/flowWithMultipleComponents.partitions.xmf");
+    std::stringstream expectedOutput;
+    expectedOutput << expectedResultFile.rdbuf();
+
+    // act
+    std::stringstream resultStream;
+    petscXdmfGenerator::GeneratePartitions(partitionFilePaths, resultStream);
+
+    // assert
+    ASSERT_EQ(resultStream.str(), expectedOutput.str());
+
+    // every partition must hold the same steps
+    std::stringstream mismatchedStream;
+    ASSERT_THROW(petscXdmfGenerator::GeneratePartitions({partitionFilePaths.front(), "inputs/flowField.0.hdf5"}, mismatchedStream), std::invalid_argument);
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(PETScHdf5ToXdmfIncrementalTests, ShouldOnlyAppendNewTimeSteps) {
+    // arrange
+    auto workingDirectory = std::filesystem::temp_directory_path() / "petscXdmfGeneratorIncrementalTests";
+    std::filesystem::remove_all(workingDirectory);
+    std::filesystem::create_directories(workingDirectory);
+    auto inputFilePath = workingDirectory / "particleWithExtraFields.hdf5";
+    auto outputFilePath = workingDirectory / "particleWithExtraFields.xmf";
+
+    std::ifstream expectedResultFile("outputs/particleWithExtraFields.xmf");
+    std::stringstream expectedOutput;
+    expectedOutput << expectedResultFile.rdbuf();
+
+    // act
+    // start with only the first time step
+    std::filesystem::copy_file("inputs/particleSeries.0.hdf5", inputFilePath);
+    auto initialUpdate = petscXdmfGenerator::GenerateIncremental(inputFilePath);
+    auto repeatedUpdate = petscXdmfGenerator::GenerateIncremental(inputFilePath);
+
+    // then all of the time steps
+    std::filesystem::copy_file("inputs/particleWithExtraFields.hdf5", inputFilePath, std::filesystem::copy_options::overwrite_existing);
+    auto appendedUpdate = petscXdmfGenerator::GenerateIncremental(inputFilePath);
+
+    std::ifstream resultFile(outputFilePath);
+    std::stringstream resultOutput;
+    resultOutput << resultFile.rdbuf();
+
+    // assert
+    ASSERT_EQ(initialUpdate, petscXdmfGenerator::REBUILT);
+    ASSERT_EQ(repeatedUpdate, petscXdmfGenerator::UNCHANGED);
+    ASSERT_EQ(appendedUpdate, petscXdmfGenerator::APPENDED);
+    ASSERT_EQ(resultOutput.str(), expectedOutput.str());
+
+    std::filesystem::remove_all(workingDirectory);
+}
+
+TEST(PETScHdf5ToXdmfIncrementalTests, ShouldRebuildWhenTheSelectionChanges) {
+    // arrange
+    auto workingDirectory = std::filesystem::temp_directory_path() / "petscXdmfGeneratorIncrementalSelectionTests";
+    std::filesystem::remove_all(workingDirectory);
+    std::filesystem::create_directories(workingDirectory);
+    auto inputFilePath = workingDirectory / "particleWithExtraFields.hdf5";
+    auto outputFilePath = workingDirectory / "particleWithExtraFields.xmf";
+
+    std::ifstream expectedResultFile("outputs/particleWithExtraFields.xmf");
+    std::stringstream expectedOutput;
+    expectedOutput << expectedResultFile.rdbuf();
+
+    petscXdmfGenerator::GenerateOptions selectedOptions;
+    selectedOptions.timeStride = 2;
+
+    // act
+    // the selection changes while the input does not
+    std::filesystem::copy_file("inputs/particleSeries.0.hdf5", inputFilePath);
+    auto initialUpdate = petscXdmfGenerator::GenerateIncremental(inputFilePath);
+    auto selectedUpdate = petscXdmfGenerator::GenerateIncremental(inputFilePath, {}, selectedOptions);
+    auto repeatedUpdate = petscXdmfGenerator::GenerateIncremental(inputFilePath, {}, selectedOptions);
+
+    // as does the format of the existing steps
+    auto compactOptions = selectedOptions;
+    compactOptions.compactOutput = true;
+    auto compactUpdate = petscXdmfGenerator::GenerateIncremental(inputFilePath, {}, compactOptions);
+
+    // then the selection changes back as the input grows
+    std::filesystem::copy_file("inputs/particleWithExtraFields.hdf5", inputFilePath, std::filesystem::copy_options::overwrite_existing);
+    auto grownUpdate = petscXdmfGenerator::GenerateIncremental(inputFilePath);
+
+    std::ifstream resultFile(outputFilePath);
+    std::stringstream resultOutput;
+    resultOutput << resultFile.rdbuf();
+
+    // assert
+    ASSERT_EQ(initialUpdate, petscXdmfGenerator::REBUILT);
+    ASSERT_EQ(selectedUpdate, petscXdmfGenerator::REBUILT);
+    ASSERT_EQ(repeatedUpdate, petscXdmfGenerator::UNCHANGED);
+    ASSERT_EQ(compactUpdate, petscXdmfGenerator::REBUILT);
+    ASSERT_EQ(grownUpdate, petscXdmfGenerator::REBUILT);
+    ASSERT_EQ(resultOutput.str(), expectedOutput.str());
+
+    std::filesystem::remove_all(workingDirectory);
+}
+
+TEST(PETScHdf5ToXdmfCacheTests, ShouldGenerateExpectedXmlFromCachedSpecification) {
+    // arrange
+    auto cacheDirectory = std::filesystem::temp_directory_path() / "petscXdmfGeneratorCacheTests";
+    std::filesystem::remove_all(cacheDirectory);
+    petscXdmfGenerator::GenerateOptions options;
+    options.useSpecificationCache = true;
+    options.specificationCacheDirectory = cacheDirectory;
+
+    std::ifstream expectedResultFile("outputs/particleWithExtraFields.xmf");
+    std::stringstream expectedOutput;
+    expectedOutput << expectedResultFile.rdbuf();
+
+    // act
+    // the first generation populates the cache and the second is built from it
+    std::stringstream initialOutput;
+    petscXdmfGenerator::Generate("inputs/particleWithExtraFields.hdf5", initialOutput, options);
+    auto cacheEntries = std::distance(std::filesystem::directory_iterator(cacheDirectory), std::filesystem::directory_iterator());
+
+    std::stringstream cachedOutput;
+    auto cachedStatistics = petscXdmfGenerator::Generate("inputs/particleWithExtraFields.hdf5", cachedOutput, options);
+
+    // a corrupt length in the entry is read as a miss and the entry is replaced
+    auto entryPath = std::filesystem::directory_iterator(cacheDirectory)->path();
+    {
+        std::fstream entryFile(entryPath, std::ios::in | std::ios::out | std::ios::binary);
+        std::string entry((std::istreambuf_iterator<char>(entryFile)), std::istreambuf_iterator<char>());
+        const uint64_t corruptLength = 0x7f7f7f7f7f7f7f7f;
+        entryFile.seekp((std::streamoff)(entry.find("PXSPEC") + 8 + sizeof(uint32_t)));
+        entryFile.write(reinterpret_cast<const char*>(&corruptLength), sizeof(corruptLength));
+    }
+    std::stringstream corruptOutput;
+    auto corruptStatistics = petscXdmfGenerator::Generate("inputs/particleWithExtraFields.hdf5", corruptOutput, options);
+
+    // assert
+    ASSERT_EQ(cacheEntries, 1);
+    ASSERT_EQ(initialOutput.str(), expectedOutput.str());
+    ASSERT_EQ(cachedOutput.str(), expectedOutput.str());
+    ASSERT_EQ(cachedStatistics.cachedSpecifications, 1u);
+    ASSERT_EQ(cachedStatistics.hdfOpens, 0u);
+    ASSERT_EQ(corruptOutput.str(), expectedOutput.str());
+    ASSERT_EQ(corruptStatistics.cachedSpecifications, 0u);
+
+    std::filesystem::remove_all(cacheDirectory);
+}
+
+TEST(PETScHdf5ToXdmfParallelBuildTests, ShouldGenerateIdenticalXmlWithMultipleBuildThreads) {
+    for (const auto& testFile : {"flowField.0", "flowWithMultipleComponents", "particlesDynamic3D", "swarmStaticMesh.0"}) {
+        // arrange
+        std::ifstream expectedResultFile("outputs/" + std::string(testFile) + ".xmf");
+        std::stringstream expectedOutput;
+        expectedOutput << expectedResultFile.rdbuf();
+
+        petscXdmfGenerator::GenerateOptions options;
+        options.buildThreads = 3;
+
+        // act
+        std::stringstream resultStream;
+        petscXdmfGenerator::Generate("inputs/" + std::string(testFile) + ".hdf5", resultStream, options);
+
+        // assert
+        ASSERT_EQ(resultStream.str(), expectedOutput.str()) << testFile;
+    }
+}
+
+// accepts a fixed number of characters and then fails every write
+class FailingBuffer : public std::streambuf {
+   private:
+    std::size_t remaining;
+
+   protected:
+    int_type overflow(int_type character) override { return xsputn(nullptr, 1) == 1 ? traits_type::not_eof(character) : traits_type::eof(); }
+    std::streamsize xsputn(const char*, std::streamsize count) override {
+        const auto accepted = std::min<std::streamsize>(count, (std::streamsize)remaining);
+        remaining -= (std::size_t)accepted;
+        return accepted;
+    }
+
+   public:
+    explicit FailingBuffer(std::size_t capacity) : remaining(capacity) {}
+};
+
+TEST(PETScHdf5ToXdmfParallelBuildTests, ShouldReportAFailedWriteFromTheBuildThreadsToTheCaller) {
+    // arrange
+    // the headers fit in the buffer so the write fails while the steps are being built
+    FailingBuffer failingBuffer(8192);
+    std::ostream failingStream(&failingBuffer);
+    failingStream.exceptions(std::ios::badbit);
+
+    petscXdmfGenerator::GenerateOptions options;
+    options.buildThreads = 3;
+
+    // act
+    // assert
+    ASSERT_THROW(petscXdmfGenerator::Generate("inputs/flowField.0.hdf5", failingStream, options), std::ios_base::failure);
+}
+
+TEST(PETScHdf5ToXdmfParallelBuildTests, ShouldRejectCellsWithoutAnXdmfTopologyOnEveryBuildThread) {
+    // arrange
+    auto extracted = petscXdmfGenerator::ReadSpecification("inputs/flowField.0.hdf5");
+    auto grid = extracted->Grids().front();
+    grid.topology.numberCorners = 5;
+    auto specification = std::make_shared<petscXdmfGenerator::XdmfSpecification>(extracted->Hdf5File());
+    specification->AddGrid(grid);
+
+    petscXdmfGenerator::GenerateOptions options;
+    options.buildThreads = 3;
+
+    // act
+    // assert
+    std::stringstream resultStream;
+    ASSERT_THROW(petscXdmfGenerator::Generate(specification, resultStream, options), std::invalid_argument);
+}
+
+TEST(PETScHdf5ToXdmfCompactTests, ShouldGenerateXmlWithoutAddedWhiteSpace) {
+    for (const auto& testFile : {"flowField.0", "particlesDynamic3D", "swarmStaticMesh.0"}) {
+        // arrange
+        std::ifstream expectedResultFile("outputs/" + std::string(testFile) + ".xmf");
+        std::stringstream expectedOutput;
+        expectedOutput << expectedResultFile.rdbuf();
+        // only the preamble keeps its new lines
+        auto expectedCompactOutput = std::regex_replace(expectedOutput.str(), std::regex("\n *"), "");
+
+        petscXdmfGenerator::GenerateOptions options;
+        options.compactOutput = true;
+
+        // act
+        std::stringstream resultStream;
+        petscXdmfGenerator::Generate("inputs/" + std::string(testFile) + ".hdf5", resultStream, options);
+
+        // assert
+        auto result = resultStream.str();
+        ASSERT_EQ(result.find('\n', result.find("<Xdmf")), std::string::npos) << testFile;
+        ASSERT_EQ(std::regex_replace(result, std::regex("\n *"), ""), expectedCompactOutput) << testFile;
+    }
+}
+
+TEST(PETScHdf5ToXdmfFileDescriptorTests, ShouldGenerateExpectedXmlToFileDescriptor) {
+    // arrange
+    std::ifstream expectedResultFile("outputs/flowField.0.xmf");
+    std::stringstream expectedOutput;
+    expectedOutput << expectedResultFile.rdbuf();
+
+    auto outputFile = std::filesystem::temp_directory_path() / "petscXdmfGeneratorFileDescriptorTest.xmf";
+    int fileDescriptor = ::open(outputFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    ASSERT_GE(fileDescriptor, 0);
+
+    // act
+    petscXdmfGenerator::Generate("inputs/flowField.0.hdf5", fileDescriptor);
+    ::close(fileDescriptor);
+
+    // assert
+    std::ifstream resultFile(outputFile);
+    std::stringstream resultOutput;
+    resultOutput << resultFile.rdbuf();
+    ASSERT_EQ(resultOutput.str(), expectedOutput.str());
+    std::filesystem::remove(outputFile);
+}
+
+TEST(PETScHdf5ToXdmfTimeReferenceTests, ShouldReferenceTimeDatasetForLongTimeLists) {
+    for (const auto& [threshold, expectedFile] : std::vector<std::pair<std::size_t, std::string>>{{16, "flowWithParticles.0.timeReference"}, {17, "flowWithParticles.0"}}) {
+        // arrange
+        std::ifstream expectedResultFile("outputs/" + expectedFile + ".xmf");
+        std::stringstream expectedOutput;
+        expectedOutput << expectedResultFile.rdbuf();
+
+        petscXdmfGenerator::GenerateOptions options;
+        options.timeReferenceThreshold = threshold;
+
+        // act
+        std::stringstream resultStream;
+        petscXdmfGenerator::Generate("inputs/flowWithParticles.0.hdf5", resultStream, options);
+
+        // assert
+        ASSERT_EQ(resultStream.str(), expectedOutput.str()) << threshold;
+    }
+}
+
+TEST(PETScHdf5ToXdmfStatisticsTests, ShouldReportHdfCallsAndBytesWritten) {
+    // arrange
+    auto outputFile = std::filesystem::temp_directory_path() / "petscXdmfGeneratorStatisticsTest.xmf";
+
+    // act
+    auto statistics = petscXdmfGenerator::Generate("inputs/flowWithParticles.0.hdf5", outputFile);
+
+    // assert
+    ASSERT_EQ(statistics.cachedSpecifications, 0u);
+    ASSERT_GT(statistics.hdfOpens, 0u);
+    ASSERT_GT(statistics.hdfLinkChecks, 0u);
+    ASSERT_GT(statistics.hdfAttributeReads, 0u);
+    ASSERT_EQ(statistics.hdfDatasetReads, 1u);             // only the time is read
+    ASSERT_EQ(statistics.hdfBytesRead, 16 * sizeof(double));  // 16 time steps
+    ASSERT_EQ(statistics.bytesWritten, std::filesystem::file_size(outputFile));
+    ASSERT_GE(statistics.totalSeconds, statistics.openSeconds + statistics.specificationSeconds + statistics.writeSeconds);
+    std::filesystem::remove(outputFile);
+}
+
+TEST(PETScHdf5ToXdmfWatchTests, ShouldConvertExistingAndNewlyWrittenFiles) {
+    for (bool forcePolling : {false, true}) {
+        // arrange
+        auto directory = std::filesystem::temp_directory_path() / "petscXdmfGeneratorWatchTest";
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+        std::filesystem::copy_file("inputs/flowField.0.hdf5", directory / "flowField.0.hdf5");
+
+        petscXdmfGenerator::WatchOptions watchOptions;
+        watchOptions.debounce = std::chrono::milliseconds(50);
+        watchOptions.pollInterval = std::chrono::milliseconds(20);
+        watchOptions.forcePolling = forcePolling;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+        // act
+        std::vector<std::string> converted;
+        petscXdmfGenerator::Watch(
+            directory, watchOptions, {},
+            [&](const petscXdmfGenerator::BatchResult& result, petscXdmfGenerator::IncrementalUpdate update) {
+                ASSERT_TRUE(result.success) << result.error;
+                ASSERT_EQ(update, petscXdmfGenerator::REBUILT);
+                converted.push_back(result.inputFilePath.filename().string());
+
+                // write a new file once the existing file has been converted
+                if (converted.size() == 1) {
+                    std::filesystem::copy_file("inputs/particlesDynamic3D.hdf5", directory / "particlesDynamic3D.hdf5");
+                }
+            },
+            [&] { return converted.size() >= 2 || std::chrono::steady_clock::now() > deadline; });
+
+        // assert
+        ASSERT_EQ(converted, (std::vector<std::string>{"flowField.0.hdf5", "particlesDynamic3D.hdf5"})) << forcePolling;
+        for (const auto& testFile : {"flowField.0", "particlesDynamic3D"}) {
+            std::ifstream expectedResultFile("outputs/" + std::string(testFile) + ".xmf");
+            std::stringstream expectedOutput;
+            expectedOutput << expectedResultFile.rdbuf();
+            std::ifstream resultFile(directory / (std::string(testFile) + ".xmf"));
+            std::stringstream resultOutput;
+            resultOutput << resultFile.rdbuf();
+            ASSERT_EQ(resultOutput.str(), expectedOutput.str()) << testFile << " " << forcePolling;
+        }
+        std::filesystem::remove_all(directory);
+    }
+}
+
+// copies each object below the root into the destination file
+static herr_t CopyRootChild(hid_t locId, const char* name, const H5L_info_t*, void* destinationId) {
+    return H5Ocopy(locId, name, *(hid_t*)destinationId, name, H5P_DEFAULT, H5P_DEFAULT);
+}
+
+TEST(PETScHdf5ToXdmfSwmrTests, ShouldGenerateExpectedXmlFromASwmrFile) {
+    for (const auto& testFile : {"flowField.0", "particlesDynamic3D"}) {
+        // arrange
+        // swmr requires the latest file format, so copy the input into a new file
+        auto directory = std::filesystem::temp_directory_path() / "petscXdmfGeneratorSwmrTest";
+        std::filesystem::create_directories(directory);
+        auto inputFilePath = directory / (std::string(testFile) + ".hdf5");
+        {
+            auto accessProperties = H5Pcreate(H5P_FILE_ACCESS);
+            H5Pset_libver_bounds(accessProperties, H5F_LIBVER_LATEST, H5F_LIBVER_LATEST);
+            auto sourceId = H5Fopen(("inputs/" + std::string(testFile) + ".hdf5").c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+            auto destinationId = H5Fcreate(inputFilePath.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, accessProperties);
+            ASSERT_GE(H5Literate(sourceId, H5_INDEX_NAME, H5_ITER_NATIVE, nullptr, CopyRootChild, &destinationId), 0);
+            H5Fclose(destinationId);
+            H5Fclose(sourceId);
+            H5Pclose(accessProperties);
+        }
+
+        std::ifstream expectedResultFile("outputs/" + std::string(testFile) + ".xmf");
+        std::stringstream expectedOutput;
+        expectedOutput << expectedResultFile.rdbuf();
+
+        // act
+        petscXdmfGenerator::GenerateOptions options;
+        options.swmrRead = true;
+        std::stringstream resultStream;
+        petscXdmfGenerator::Generate(inputFilePath, resultStream, options);
+
+        // assert
+        ASSERT_EQ(resultStream.str(), expectedOutput.str()) << testFile;
+        std::filesystem::remove_all(directory);
+    }
+}
+
+TEST(PETScHdf5ToXdmfSpecificationTests, ShouldRejectInvalidSpecifications) {
+    // arrange
+    petscXdmfGenerator::XdmfSpecification::GridDescription validGrid;
+    validGrid.name = "domain";
+    validGrid.geometry = {.name = "vertices", .path = "/geometry/vertices", .shape = {81, 2}, .componentDimension = 2, .fieldType = petscXdmfGenerator::VECTOR};
+    validGrid.fields.push_back({.name = "solution",
+                                .path = "/vertex_fields/solution",
+                                .shape = {81, 2},
+                                .componentDimension = 2,
+                                .fieldType = petscXdmfGenerator::VECTOR,
+                                .components = {{.name = "solution0", .offset = 0}, {.name = "solution1", .offset = 1}}});
+
+    // each change breaks a single rule, named by part of the message it must be rejected with
+    std::vector<std::pair<std::string, std::function<void(petscXdmfGenerator::XdmfSpecification::GridDescription&)>>> invalidGrids = {
+        {"must be named", [](auto& grid) { grid.name.clear(); }},
+        {"must have a shape", [](auto& grid) { grid.geometry.shape = {81}; }},
+        {"is outside of the field", [](auto& grid) { grid.fields.front().components.back().offset = 2; }},
+        {"time stride", [](auto& grid) { grid.timeStride = 0; }}};
+
+    std::stringstream invalidJson("{\"format\": \"petscXdmfGenerator.specification\", \"version\": 1, \"hdf5File\": \"a.hdf5\", \"grids\": [}");
+    std::stringstream otherJson("{\"name\": \"not a specification\"}");
+    std::stringstream nestedJson(std::string(100000, '[') + std::string(100000, ']'));
+
+    // act
+    // assert
+    petscXdmfGenerator::XdmfSpecification("flowField.0.hdf5", {validGrid}).Validate();
+    for (const auto& [message, breakRule] : invalidGrids) {
+        auto grid = validGrid;
+        breakRule(grid);
+        auto specification = std::make_shared<petscXdmfGenerator::XdmfSpecification>("flowField.0.hdf5");
+        specification->AddGrid(grid);
+        try {
+            specification->Validate();
+            FAIL() << "expected the specification to be rejected because it " << message;
+        } catch (const std::invalid_argument& exception) {
+            ASSERT_NE(std::string(exception.what()).find(message), std::string::npos) << exception.what();
+        }
+
+        std::stringstream output;
+        ASSERT_THROW(petscXdmfGenerator::Generate(specification, output), std::invalid_argument) << message;
+    }
+    ASSERT_THROW(petscXdmfGenerator::XdmfSpecification::ReadJson(invalidJson), std::runtime_error);
+    ASSERT_THROW(petscXdmfGenerator::XdmfSpecification::ReadJson(otherJson), std::runtime_error);
+    ASSERT_THROW(petscXdmfGenerator::XdmfSpecification::ReadJson(nestedJson), std::runtime_error);
+}
+
+// reads every value in a dataset converted to double
+static std::vector<double> ReadDataset(const std::filesystem::path& filePath, const std::string& datasetPath) {
+    auto fileId = H5Fopen(filePath.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+    auto datasetId = H5Dopen2(fileId, datasetPath.c_str(), H5P_DEFAULT);
+    auto spaceId = H5Dget_space(datasetId);
+    std::vector<double> values((std::size_t)H5Sget_simple_extent_npoints(spaceId));
+    if (datasetId < 0 || H5Dread(datasetId, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, values.data()) < 0) {
+        values.clear();
+    }
+    H5Sclose(spaceId);
+    H5Dclose(datasetId);
+    H5Fclose(fileId);
+    return values;
+}
+
+TEST(PETScHdf5ToXdmfVtkHdfTests, ShouldLinkThePetscDatasetsFromAVtkHdfFile) {
+    for (const auto& testFile : {"flowField.0", "flowWithMultipleComponents", "particlesDynamic3D"}) {
+        // arrange
+        // the vtkhdf file must be written next to the hdf5 file
+        auto directory = std::filesystem::temp_directory_path() / "petscXdmfGeneratorVtkHdfTest";
+        std::filesystem::create_directories(directory);
+        auto inputFilePath = directory / (std::string(testFile) + ".hdf5");
+        std::filesystem::copy_file("inputs/" + std::string(testFile) + ".hdf5", inputFilePath, std::filesystem::copy_options::overwrite_existing);
+        auto specification = petscXdmfGenerator::ReadSpecification(inputFilePath);
+        const auto& grid = specification->Grids().front();
+
+        // act
+        petscXdmfGenerator::GenerateVtkHdf(inputFilePath);
+
+        // assert
+        auto outputFilePath = directory / (std::string(testFile) + ".vtkhdf");
+        ASSERT_TRUE(std::filesystem::exists(outputFilePath)) << testFile;
+
+        // the points are padded to three coordinates
+        auto points = ReadDataset(outputFilePath, "/VTKHDF/Points");
+        auto vertices = ReadDataset(inputFilePath, grid.geometry.path);
+        const auto dimension = grid.geometry.GetDimension();
+        ASSERT_EQ(points.size(), vertices.size() / dimension * 3) << testFile;
+        for (std::size_t p = 0; p < points.size() / 3; p++) {
+            for (std::size_t d = 0; d < 3; d++) {
+                ASSERT_EQ(points[p * 3 + d], d < dimension ? vertices[p * dimension + d] : 0.0) << testFile;
+            }
+        }
+
+        // particles are written as vertices
+        auto connectivity = ReadDataset(outputFilePath, "/VTKHDF/Connectivity");
+        auto types = ReadDataset(outputFilePath, "/VTKHDF/Types");
+        auto offsets = ReadDataset(outputFilePath, "/VTKHDF/Offsets");
+        const auto corners = grid.topology.numberCorners ? grid.topology.numberCorners : 1;
+        if (grid.topology.numberCorners) {
+            ASSERT_EQ(connectivity, ReadDataset(inputFilePath, grid.topology.path)) << testFile;
+            ASSERT_EQ(types, std::vector<double>(grid.topology.number, corners == 3 ? 5.0 /*triangle*/ : 9.0 /*quad*/)) << testFile;
+        } else {
+            ASSERT_EQ(connectivity.size(), grid.geometry.GetDof()) << testFile;
+            ASSERT_EQ(connectivity.back(), (double)grid.geometry.GetDof() - 1) << testFile;
+            ASSERT_EQ(types, std::vector<double>(grid.geometry.GetDof(), 1.0)) << testFile;
+        }
+        ASSERT_EQ(offsets.size(), types.size() + 1) << testFile;
+        ASSERT_EQ(offsets.back(), (double)(types.size() * corners)) << testFile;
+
+        // every step of each field is read from the PETSc dataset
+        for (const auto& field : grid.fields) {
+            std::string location = field.fieldLocation == petscXdmfGenerator::NODE ? "PointData/" : "CellData/";
+            ASSERT_EQ(ReadDataset(outputFilePath, "/VTKHDF/" + location + field.name), ReadDataset(inputFilePath, field.path)) << testFile << " " << field.name;
+        }
+        ASSERT_EQ(ReadDataset(outputFilePath, "/VTKHDF/Steps/Values"), grid.time) << testFile;
+        std::filesystem::remove_all(directory);
+    }
+}
+
+TEST(PETScHdf5ToXdmfSelectionTests, ShouldOnlyWriteTheSelectedFieldsAndTimes) {
+    // arrange
+    std::ifstream expectedResultFile("outputs/flowField.0.selected.xmf");
+    std::stringstream expectedOutput;
+    expectedOutput << expectedResultFile.rdbuf();
+
+    petscXdmfGenerator::GenerateOptions options;
+    options.includeFields = {"*velocity", "*temperature"};
+    options.excludeFields = {"*temp*"};
+    options.timeBegin = 0.1;
+    options.timeEnd = 0.5;
+    options.timeStride = 3;
+
+    // act
+    std::stringstream resultStream;
+    petscXdmfGenerator::Generate("inputs/flowField.0.hdf5", resultStream, options);
+
+    // a saved selection is written the same way
+    std::stringstream savedSpecification;
+    petscXdmfGenerator::ReadSpecification("inputs/flowField.0.hdf5", options)->WriteJson(savedSpecification);
+    std::stringstream savedResultStream;
+    petscXdmfGenerator::Generate(petscXdmfGenerator::XdmfSpecification::ReadJson(savedSpecification), savedResultStream);
+
+    // assert
+    ASSERT_EQ(resultStream.str(), expectedOutput.str());
+    ASSERT_EQ(savedResultStream.str(), expectedOutput.str());
+
+    options.timeBegin = 100;
+    ASSERT_THROW(petscXdmfGenerator::Generate("inputs/flowField.0.hdf5", resultStream, options), std::invalid_argument);
+}
+
+TEST(PETScHdf5ToXdmfSelectionTests, ShouldAddParticleGridsThatReadEveryNthParticle) {
+    // arrange
+    std::ifstream expectedResultFile("outputs/flowWithParticles.0.lod.xmf");
+    std::stringstream expectedOutput;
+    expectedOutput << expectedResultFile.rdbuf();
+
+    petscXdmfGenerator::GenerateOptions options;
+    options.timeStride = 5;
+    options.particleLevelsOfDetail = {7};
+
+    // act
+    std::stringstream resultStream;
+    petscXdmfGenerator::Generate("inputs/flowWithParticles.0.hdf5", resultStream, options);
+
+    // the strided grids are kept in a saved specification
+    std::stringstream savedSpecification;
+    petscXdmfGenerator::ReadSpecification("inputs/flowWithParticles.0.hdf5", options)->WriteBinary(savedSpecification);
+    std::stringstream savedResultStream;
+    petscXdmfGenerator::Generate(petscXdmfGenerator::XdmfSpecification::ReadBinary(savedSpecification), savedResultStream);
+
+    // assert
+    ASSERT_EQ(resultStream.str(), expectedOutput.str());
+    ASSERT_EQ(savedResultStream.str(), expectedOutput.str());
+
+    // each level must read fewer particles
+    options.particleLevelsOfDetail = {1};
+    ASSERT_THROW(petscXdmfGenerator::Generate("inputs/flowWithParticles.0.hdf5", resultStream, options), std::invalid_argument);
+
+    // grids with cells are never strided
+    auto specification = petscXdmfGenerator::ReadSpecification("inputs/flowField.0.hdf5");
+    auto grids = specification->Grids().size();
+    specification->AddLevelsOfDetail({10});
+    ASSERT_EQ(specification->Grids().size(), grids);
+}
+
+TEST(PETScHdf5ToXdmfSummaryTests, ShouldWriteTheRangeAndMeanOfEachFieldForEachStep) {
+    // arrange
+    std::ifstream expectedResultFile("outputs/flowWithMultipleComponents.summaries.xmf");
+    std::stringstream expectedOutput;
+    expectedOutput << expectedResultFile.rdbuf();
+
+    petscXdmfGenerator::GenerateOptions options;
+    options.timeStride = 5;
+    options.fieldSummaries = true;
+
+    // act
+    std::stringstream resultStream;
+    petscXdmfGenerator::Generate("inputs/flowWithMultipleComponents.hdf5", resultStream, options);
+
+    // the summaries are kept in both saved specification formats
+    auto specification = petscXdmfGenerator::ReadSpecification("inputs/flowWithMultipleComponents.hdf5", options);
+    std::stringstream binarySpecification;
+    specification->WriteBinary(binarySpecification);
+    std::stringstream binaryResultStream;
+    petscXdmfGenerator::Generate(petscXdmfGenerator::XdmfSpecification::ReadBinary(binarySpecification), binaryResultStream);
+
+    std::stringstream jsonSpecification;
+    specification->WriteJson(jsonSpecification);
+    std::stringstream jsonResultStream;
+    petscXdmfGenerator::Generate(petscXdmfGenerator::XdmfSpecification::ReadJson(jsonSpecification), jsonResultStream);
+
+    // assert
+    ASSERT_EQ(resultStream.str(), expectedOutput.str());
+    ASSERT_EQ(binaryResultStream.str(), expectedOutput.str());
+    ASSERT_EQ(jsonResultStream.str(), expectedOutput.str());
+
+    // summaries are only written when requested
+    std::stringstream plainResultStream;
+    options.fieldSummaries = false;
+    petscXdmfGenerator::Generate("inputs/flowWithMultipleComponents.hdf5", plainResultStream, options);
+    ASSERT_EQ(plainResultStream.str().find("<Information"), std::string::npos);
+}
+
+TEST(PETScHdf5ToXdmfSummaryTests, ShouldOnlySummarizeTheSelectedTimes) {
+    // arrange
+    std::ifstream expectedResultFile("outputs/flowWithMultipleComponents.summaries.xmf");
+    std::stringstream expectedOutput;
+    expectedOutput << expectedResultFile.rdbuf();
+
+    petscXdmfGenerator::GenerateOptions options;
+    options.fieldSummaries = true;
+    petscXdmfGenerator::GenerateStatistics everyTimeStatistics;
+    petscXdmfGenerator::GenerateStatistics selectedStatistics;
+
+    // act
+    auto specification = petscXdmfGenerator::ReadSpecification("inputs/flowWithMultipleComponents.hdf5", options, &everyTimeStatistics);
+    options.timeStride = 5;
+    petscXdmfGenerator::ReadSpecification("inputs/flowWithMultipleComponents.hdf5", options, &selectedStatistics);
+
+    // a specification summarized at every time keeps the summaries of the times it selects later
+    specification->Select([](const std::string&) { return true; }, options.timeBegin, options.timeEnd, options.timeStride);
+    std::stringstream resultStream;
+    petscXdmfGenerator::Generate(specification, resultStream);
+
+    // assert
+    ASSERT_LT(selectedStatistics.hdfBytesRead, everyTimeStatistics.hdfBytesRead);
+    ASSERT_EQ(resultStream.str(), expectedOutput.str());
+}
+
+TEST(PETScHdf5ToXdmfSummaryTests, ShouldNotWriteCachedSummariesUnlessRequested) {
+    // arrange
+    auto cacheDirectory = std::filesystem::temp_directory_path() / "petscXdmfGeneratorSummaryCacheTests";
+    std::filesystem::remove_all(cacheDirectory);
+    petscXdmfGenerator::GenerateOptions options;
+    options.timeStride = 5;
+    options.useSpecificationCache = true;
+    options.specificationCacheDirectory = cacheDirectory;
+
+    std::ifstream expectedResultFile("outputs/flowWithMultipleComponents.summaries.xmf");
+    std::stringstream expectedOutput;
+    expectedOutput << expectedResultFile.rdbuf();
+
+    // act
+    // the first generation caches the summaries and the second reuses the entry without asking for them
+    std::stringstream summarizedOutput;
+    options.fieldSummaries = true;
+    petscXdmfGenerator::Generate("inputs/flowWithMultipleComponents.hdf5", summarizedOutput, options);
+
+    std::stringstream plainOutput;
+    options.fieldSummaries = false;
+    auto statistics = petscXdmfGenerator::Generate("inputs/flowWithMultipleComponents.hdf5", plainOutput, options);
+
+    // assert
+    ASSERT_EQ(summarizedOutput.str(), expectedOutput.str());
+    ASSERT_EQ(statistics.cachedSpecifications, 1);
+    ASSERT_EQ(plainOutput.str().find("<Information"), std::string::npos);
+
+    std::filesystem::remove_all(cacheDirectory);
+}
+
+TEST(PETScHdf5ToXdmfRepackTests, ShouldRewriteMisalignedDatasetsWithOneChunkPerStep) {
+    // arrange
+    auto directory = std::filesystem::temp_directory_path() / "petscXdmfGeneratorRepackTest";
+    std::filesystem::create_directories(directory / "repacked");
+    auto inputFilePath = directory / "flowField.0.hdf5";
+    std::filesystem::copy_file("inputs/flowField.0.hdf5", inputFilePath, std::filesystem::copy_options::overwrite_existing);
+
+    // store the velocity in compressed chunks that each hold several steps and half of the points
+    const std::string velocityPath = "/vertex_fields/Incompressible Flow Numerical Solution_velocity";
+    const auto velocity = ReadDataset(inputFilePath, velocityPath);
+    {
+        auto fileId = H5Fopen(inputFilePath.c_str(), H5F_ACC_RDWR, H5P_DEFAULT);
+        ASSERT_GE(H5Ldelete(fileId, velocityPath.c_str(), H5P_DEFAULT), 0);
+        const hsize_t shape[3] = {31, 81, 2};
+        const hsize_t chunk[3] = {4, 41, 2};
+        auto spaceId = H5Screate_simple(3, shape, nullptr);
+        auto propertiesId = H5Pcreate(H5P_DATASET_CREATE);
+        H5Pset_chunk(propertiesId, 3, chunk);
+        H5Pset_deflate(propertiesId, 1);
+        auto datasetId = H5Dcreate2(fileId, velocityPath.c_str(), H5T_IEEE_F64LE, spaceId, H5P_DEFAULT, propertiesId, H5P_DEFAULT);
+        ASSERT_GE(H5Dwrite(datasetId, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, velocity.data()), 0);
+
+        // the field type is needed to describe the field
+        auto typeId = H5Tcopy(H5T_C_S1);
+        H5Tset_size(typeId, 7);
+        auto scalarId = H5Screate(H5S_SCALAR);
+        auto attributeId = H5Acreate2(datasetId, "vector_field_type", typeId, scalarId, H5P_DEFAULT, H5P_DEFAULT);
+        ASSERT_GE(H5Awrite(attributeId, typeId, "vector"), 0);
+        H5Aclose(attributeId);
+        H5Sclose(scalarId);
+        H5Tclose(typeId);
+        H5Dclose(datasetId);
+        H5Pclose(propertiesId);
+        H5Sclose(spaceId);
+        H5Fclose(fileId);
+    }
+
+    std::ifstream expectedResultFile("outputs/flowField.0.xmf");
+    std::stringstream expectedOutput;
+    expectedOutput << expectedResultFile.rdbuf();
+
+    // act
+    auto repackedFilePath = directory / "repacked" / "flowField.0.hdf5";
+    auto rewritten = petscXdmfGenerator::Repack(inputFilePath, repackedFilePath);
+    std::stringstream resultStream;
+    petscXdmfGenerator::Generate(repackedFilePath, resultStream);
+
+    // assert
+    ASSERT_EQ(rewritten.size(), 1u);
+    ASSERT_EQ(rewritten.front().path, velocityPath);
+    ASSERT_EQ(rewritten.front().chunksPerStep, 2u);
+    ASSERT_TRUE(rewritten.front().filtered);
+    for (const auto& report : petscXdmfGenerator::AnalyzeLayout(repackedFilePath)) {
+        ASSERT_TRUE(report.aligned) << report;
+    }
+    ASSERT_EQ(ReadDataset(repackedFilePath, velocityPath), velocity);
+    ASSERT_EQ(ReadDataset(repackedFilePath, "/viz/topology/cells"), ReadDataset(inputFilePath, "/viz/topology/cells"));
+    ASSERT_EQ(resultStream.str(), expectedOutput.str());
+    ASSERT_THROW(petscXdmfGenerator::Repack(inputFilePath, inputFilePath), std::invalid_argument);
+    std::filesystem::remove_all(directory);
+}